@@ -71,16 +71,17 @@ DRESULT disk_read (
 	UINT count		/* Number of sectors to read */
 )
 {
-	DRESULT res;
-	int result;
+	uint16_t result = 0;
 
 	if(pdrv != 0)
 		return RES_NOTRDY;	//	Disc other than 0 is not used
 
-	//	Read single block
-	for(uint16_t i = 0; i< count; i++)
+	//	Read the consecutive blocks with one request, FatFS asks for them when it reads whole sectors of the file
+	if(count > 1)
+		result = SD_Read_Multiple_Blocks(sector, buff, count);
+	else
 		SD_Read_Single_Block(sector, buff);
-	return RES_OK;
+	return (result == 0) ? RES_OK : RES_ERROR;
 }
 
 
@@ -97,39 +98,17 @@ DRESULT disk_write (
 	UINT count			/* Number of sectors to write */
 )
 {
-	DRESULT res;
-	int result;
+	uint16_t result;
 
-	switch (pdrv) {
-	case ATA :
-		// translate the arguments here
-
-		result = ATA_disk_write(buff, sector, count);
-
-		// translate the reslut code here
-
-		return res;
-
-	case MMC :
-		// translate the arguments here
-
-		result = MMC_disk_write(buff, sector, count);
-
-		// translate the reslut code here
-
-		return res;
-
-	case USB :
-		// translate the arguments here
-
-		result = USB_disk_write(buff, sector, count);
-
-		// translate the reslut code here
-
-		return res;
-	}
+	if(pdrv != 0)
+		return RES_NOTRDY;	//	Disc other than 0 is not used
 
-	return RES_PARERR;
+	//	Write the consecutive blocks with one request, FatFS gives them when the file is written in whole sectors
+	if(count > 1)
+		result = SD_Write_Multiple_Blocks(sector, buff, count);
+	else
+		result = SD_Write_Single_Block(sector, buff);
+	return (result == 0) ? RES_OK : RES_ERROR;
 }
 #endif
 
@@ -145,28 +124,12 @@ DRESULT disk_ioctl (
 	void *buff		/* Buffer to send/receive control data */
 )
 {
-	DRESULT res;
-
-
-	switch (pdrv) {
-	case ATA :
-
-		// Process of the command for the ATA drive
-
-		return res;
-
-	case MMC :
-
-		// Process of the command for the MMC/SD card
-
-		return res;
-
-	case USB :
-
-		// Process of the command the USB drive
+	if(pdrv != 0)
+		return RES_NOTRDY;	//	Disc other than 0 is not used
 
-		return res;
-	}
+	//	Only the sync is needed by FatFS at this configuration. The write functions return after the card has programmed the blocks, so there is nothing to flush
+	if(cmd == CTRL_SYNC)
+		return RES_OK;
 
 	return RES_PARERR;
 }
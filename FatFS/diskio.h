@@ -9,8 +9,8 @@
 extern "C" {
 #endif
 
-#define _USE_WRITE	0	/* 1: Enable disk_write function */
-#define _USE_IOCTL	0	/* 1: Enable disk_ioctl fucntion */
+#define _USE_WRITE	1	/* 1: Enable disk_write function */
+#define _USE_IOCTL	1	/* 1: Enable disk_ioctl fucntion */
 
 #include "integer.h"
 
@@ -411,6 +411,22 @@ static BYTE CurrVol;			/* Current drive */
 static FILESEM Files[_FS_LOCK];	/* Open object lock semaphores */
 #endif
 
+#if _USE_DIRCACHE
+#if _USE_LFN
+#error _USE_DIRCACHE must be 0 at LFN cfg.
+#endif
+typedef struct {
+	FATFS *fs;				/* Object ID 1, volume (NULL:blank entry) */
+	WORD id;				/* Object ID 2, volume mount ID */
+	WORD index;				/* Index of the entry in the directory */
+	DWORD sclust;			/* Object ID 3, directory start cluster */
+	DWORD clust;			/* Cluster containing the entry */
+	DWORD sect;				/* Sector containing the entry */
+	BYTE entry[SZ_DIRE];	/* Copy of the directory entry (SFN is the object ID 4) */
+} DCENT;
+static DCENT DirCache[_USE_DIRCACHE];	/* Directory entry lookup cache */
+#endif
+
 #if _USE_LFN == 0			/* Non LFN feature */
 #define	DEFINE_NAMEBUF		BYTE sfn[12]
 #define INIT_BUF(dobj)		(dobj).fn = sfn
@@ -464,10 +480,10 @@ void mem_cpy (void* dst, const void* src, UINT cnt) {
 	const BYTE *s = (const BYTE*)src;
 
 #if _WORD_ACCESS == 1
-	while (cnt >= sizeof (int)) {
-		*(int*)d = *(int*)s;
-		d += sizeof (int); s += sizeof (int);
-		cnt -= sizeof (int);
+	while (cnt >= 4) {
+		ST_DWORD(d, LD_DWORD(s));
+		d += 4; s += 4;
+		cnt -= 4;
 	}
 #endif
 	while (cnt--)
@@ -484,6 +500,7 @@ void mem_set (void* dst, int val, UINT cnt) {
 }
 
 /* Compare memory to memory */
+#if _WORD_ACCESS != 1 || _USE_DIRCACHE
 static
 int mem_cmp (const void* dst, const void* src, UINT cnt) {
 	const BYTE *d = (const BYTE *)dst, *s = (const BYTE *)src;
@@ -492,6 +509,18 @@ int mem_cmp (const void* dst, const void* src, UINT cnt) {
 	while (cnt-- && (r = *d++ - *s++) == 0) ;
 	return r;
 }
+#endif
+
+/* Compare an SFN in the directory entry with the given one (0:Matched) */
+#if _WORD_ACCESS == 1
+static
+int cmp_sfn (const BYTE* dir, const BYTE* fn) {
+	return LD_DWORD(dir) != LD_DWORD(fn) || LD_DWORD(dir + 4) != LD_DWORD(fn + 4)
+		|| LD_WORD(dir + 8) != LD_WORD(fn + 8) || dir[10] != fn[10];
+}
+#else
+#define	cmp_sfn(dir, fn)	mem_cmp(dir, fn, 11)
+#endif
 
 /* Check if chr is contained in the string */
 static
@@ -818,6 +847,115 @@ DWORD get_fat (	/* 0xFFFFFFFF:Disk error, 1:Internal error, 2..0x0FFFFFFF:Cluste
 
 
 
+/*-----------------------------------------------------------------------*/
+/* FAT handling - Free cluster bitmap                                    */
+/*-----------------------------------------------------------------------*/
+#if !_FS_READONLY && _USE_FREEMAP
+static
+void fmap_put (
+	FATFS* fs,	/* File system object */
+	DWORD clst,	/* FAT index number (cluster number) which has been changed */
+	DWORD val	/* New value of the entry */
+)
+{
+	if (fs->fmap_stat != 1) return;		/* Bitmap is not in use */
+
+	if ((val & 0x0FFFFFFF) == 0)
+		fs->fmap[clst / 32] |= (DWORD)1 << (clst % 32);
+	else
+		fs->fmap[clst / 32] &= ~((DWORD)1 << (clst % 32));
+}
+
+
+static
+FRESULT fmap_build (	/* FR_OK: Bitmap is valid or not applicable, !=0: Error code */
+	FATFS* fs			/* File system object */
+)
+{
+	DWORD n, clst, sect, stat;
+	UINT i;
+	BYTE fat, *p;
+	FRESULT res;
+
+
+	if (fs->fmap_stat) return FR_OK;	/* Already built or the volume is too large */
+	if (fs->n_fatent > _FREEMAP_CLST) {
+		fs->fmap_stat = 2;				/* Fall back to the FAT scan */
+		return FR_OK;
+	}
+
+	mem_set(fs->fmap, 0, sizeof fs->fmap);
+	fat = fs->fs_type;
+	n = 0;
+	if (fat == FS_FAT12) {
+		for (clst = 2; clst < fs->n_fatent; clst++) {
+			stat = get_fat(fs, clst);
+			if (stat == 0xFFFFFFFF) return FR_DISK_ERR;
+			if (stat == 1) return FR_INT_ERR;
+			if (stat == 0) {
+				fs->fmap[clst / 32] |= (DWORD)1 << (clst % 32);
+				n++;
+			}
+		}
+	} else {
+		sect = fs->fatbase;
+		i = 0; p = 0;
+		for (clst = 0; clst < fs->n_fatent; clst++) {
+			if (!i) {
+				res = move_window(fs, sect++);
+				if (res != FR_OK) return res;
+				p = fs->win;
+				i = SS(fs);
+			}
+			if (fat == FS_FAT16) {
+				stat = LD_WORD(p);
+				p += 2; i -= 2;
+			} else {
+				stat = LD_DWORD(p) & 0x0FFFFFFF;
+				p += 4; i -= 4;
+			}
+			if (stat == 0 && clst >= 2) {	/* Entry 0 and 1 are reserved */
+				fs->fmap[clst / 32] |= (DWORD)1 << (clst % 32);
+				n++;
+			}
+		}
+	}
+	fs->free_clust = n;				/* The scan gives the exact free cluster count */
+	fs->fsi_flag |= 1;
+	fs->fmap_stat = 1;
+
+	return FR_OK;
+}
+
+
+static
+DWORD fmap_scan (	/* 0:No free cluster in the range, >=2:Free cluster# */
+	FATFS* fs,		/* File system object */
+	DWORD clst,		/* First cluster# to check */
+	DWORD end		/* Cluster# to stop at (not checked) */
+)
+{
+	DWORD bits;
+
+
+	while (clst < end) {
+		bits = fs->fmap[clst / 32] >> (clst % 32);
+		if (bits) {						/* A free cluster is in this word */
+			while (!(bits & 1)) {
+				bits >>= 1; clst++;
+			}
+			return (clst < end) ? clst : 0;
+		}
+		clst = (clst | 31) + 1;			/* Skip the fully allocated word */
+	}
+
+	return 0;
+}
+#endif /* !_FS_READONLY && _USE_FREEMAP */
+
+
+
+
 
 /*-----------------------------------------------------------------------*/
 /* FAT access - Change value of a FAT entry                              */
@@ -876,6 +1014,9 @@ FRESULT put_fat (
 			res = FR_INT_ERR;
 		}
 	}
+#if _USE_FREEMAP
+	if (res == FR_OK) fmap_put(fs, clst, val);	/* Keep the free cluster bitmap in sync */
+#endif
 
 	return res;
 }
@@ -963,18 +1104,29 @@ DWORD create_chain (	/* 0:No free cluster, 1:Internal error, 0xFFFFFFFF:Disk err
 		scl = clst;
 	}
 
-	ncl = scl;				/* Start cluster */
-	for (;;) {
-		ncl++;							/* Next cluster */
-		if (ncl >= fs->n_fatent) {		/* Check wrap around */
-			ncl = 2;
-			if (ncl > scl) return 0;	/* No free cluster */
+#if _USE_FREEMAP
+	res = fmap_build(fs);				/* Build the free cluster bitmap at first allocation */
+	if (res != FR_OK) return (res == FR_DISK_ERR) ? 0xFFFFFFFF : 1;
+	if (fs->fmap_stat == 1) {
+		ncl = fmap_scan(fs, scl + 1, fs->n_fatent);	/* Find a free cluster after the start point */
+		if (!ncl) ncl = fmap_scan(fs, 2, scl + 1);	/* Wrap around */
+		if (!ncl) return 0;							/* No free cluster */
+	} else
+#endif
+	{
+		ncl = scl;				/* Start cluster */
+		for (;;) {
+			ncl++;							/* Next cluster */
+			if (ncl >= fs->n_fatent) {		/* Check wrap around */
+				ncl = 2;
+				if (ncl > scl) return 0;	/* No free cluster */
+			}
+			cs = get_fat(fs, ncl);			/* Get the cluster status */
+			if (cs == 0) break;				/* Found a free cluster */
+			if (cs == 0xFFFFFFFF || cs == 1)/* An error occurred */
+				return cs;
+			if (ncl == scl) return 0;		/* No free cluster */
 		}
-		cs = get_fat(fs, ncl);			/* Get the cluster status */
-		if (cs == 0) break;				/* Found a free cluster */
-		if (cs == 0xFFFFFFFF || cs == 1)/* An error occurred */
-			return cs;
-		if (ncl == scl) return 0;		/* No free cluster */
 	}
 
 	res = put_fat(fs, ncl, 0x0FFFFFFF);	/* Mark the new cluster "last link" */
@@ -1385,16 +1537,26 @@ void gen_numname (
 /*-----------------------------------------------------------------------*/
 /* Calculate sum of an SFN                                               */
 /*-----------------------------------------------------------------------*/
-#if _USE_LFN
+#if _USE_LFN || defined(FF_BENCHMARK)	/* The host benchmark measures it also without LFN */
 static
 BYTE sum_sfn (
 	const BYTE* dir		/* Pointer to the SFN entry */
 )
 {
 	BYTE sum = 0;
+#if _WORD_ACCESS == 1	/* Fetch the name in three loads instead of eleven, the steps are unrolled */
+	DWORD w0 = LD_DWORD(dir), w1 = LD_DWORD(dir + 4), w2 = LD_WORD(dir + 8) | ((DWORD)dir[10] << 16);
+#define	SUM_SFN_STEP(b)	sum = (sum >> 1) + (sum << 7) + (BYTE)(b)
+
+	SUM_SFN_STEP(w0); SUM_SFN_STEP(w0 >> 8); SUM_SFN_STEP(w0 >> 16); SUM_SFN_STEP(w0 >> 24);
+	SUM_SFN_STEP(w1); SUM_SFN_STEP(w1 >> 8); SUM_SFN_STEP(w1 >> 16); SUM_SFN_STEP(w1 >> 24);
+	SUM_SFN_STEP(w2); SUM_SFN_STEP(w2 >> 8); SUM_SFN_STEP(w2 >> 16);
+#undef	SUM_SFN_STEP
+#else
 	UINT n = 11;
 
 	do sum = (sum >> 1) + (sum << 7) + *dir++; while (--n);
+#endif
 	return sum;
 }
 #endif
@@ -1402,6 +1564,88 @@ BYTE sum_sfn (
 
 
 
+/*-----------------------------------------------------------------------*/
+/* Directory handling - Entry lookup cache                               */
+/*-----------------------------------------------------------------------*/
+#if _USE_DIRCACHE
+static
+UINT dcache_hash (		/* Index of the cache entry for the name */
+	DWORD sclust,		/* Start cluster of the directory */
+	const BYTE* fn		/* SFN to be found */
+)
+{
+	DWORD h = sclust;
+	UINT n;
+
+
+	for (n = 0; n < 11; n++) h = h * 31 + fn[n];
+	return (UINT)(h % _USE_DIRCACHE);
+}
+
+
+static
+int dcache_find (		/* 1:Found and the directory object is set to the entry, 0:Not cached */
+	DIR* dp				/* Directory object with the name to be found */
+)
+{
+	DCENT *ce;
+
+
+	ce = &DirCache[dcache_hash(dp->sclust, dp->fn)];
+	if (ce->fs != dp->fs || ce->id != dp->fs->id || ce->sclust != dp->sclust
+		|| mem_cmp(ce->entry, dp->fn, 11)) return 0;
+
+	dp->index = ce->index;
+	dp->clust = ce->clust;
+	dp->sect = ce->sect;
+#if _FS_READONLY
+	dp->dir = ce->entry;			/* The entry is only read, use the copy */
+#else
+	if (move_window(dp->fs, dp->sect) != FR_OK) return 0;	/* The entry can be modified, load it to the window */
+	dp->dir = dp->fs->win + (dp->index % (SS(dp->fs) / SZ_DIRE)) * SZ_DIRE;
+#endif
+	return 1;
+}
+
+
+static
+void dcache_put (
+	DIR* dp				/* Directory object pointing the found entry */
+)
+{
+	DCENT *ce;
+
+
+	ce = &DirCache[dcache_hash(dp->sclust, dp->dir)];
+	ce->fs = dp->fs;
+	ce->id = dp->fs->id;
+	ce->sclust = dp->sclust;
+	ce->clust = dp->clust;
+	ce->sect = dp->sect;
+	ce->index = dp->index;
+	mem_cpy(ce->entry, dp->dir, SZ_DIRE);
+}
+
+
+#if !_FS_READONLY
+static
+void dcache_clear (
+	FATFS* fs			/* File system object which directory has been changed */
+)
+{
+	UINT i;
+
+
+	for (i = 0; i < _USE_DIRCACHE; i++) {
+		if (DirCache[i].fs == fs) DirCache[i].fs = 0;
+	}
+}
+#endif
+#endif /* _USE_DIRCACHE */
+
+
+
+
 /*-----------------------------------------------------------------------*/
 /* Directory handling - Find an object in the directory                  */
 /*-----------------------------------------------------------------------*/
@@ -1417,6 +1661,9 @@ FRESULT dir_find (
 	BYTE a, ord, sum;
 #endif
 
+#if _USE_DIRCACHE
+	if (dcache_find(dp)) return FR_OK;	/* Found in the cache */
+#endif
 	res = dir_sdi(dp, 0);			/* Rewind directory object */
 	if (res != FR_OK) return res;
 
@@ -1446,13 +1693,17 @@ FRESULT dir_find (
 				}
 			} else {					/* An SFN entry is found */
 				if (!ord && sum == sum_sfn(dir)) break;	/* LFN matched? */
-				if (!(dp->fn[NSFLAG] & NS_LOSS) && !mem_cmp(dir, dp->fn, 11)) break;	/* SFN matched? */
+				if (!(dp->fn[NSFLAG] & NS_LOSS) && !cmp_sfn(dir, dp->fn)) break;	/* SFN matched? */
 				ord = 0xFF; dp->lfn_idx = 0xFFFF;	/* Reset LFN sequence */
 			}
 		}
 #else		/* Non LFN configuration */
-		if (!(dir[DIR_Attr] & AM_VOL) && !mem_cmp(dir, dp->fn, 11)) /* Is it a valid entry? */
+		if (!(dir[DIR_Attr] & AM_VOL) && !cmp_sfn(dir, dp->fn)) { /* Is it a valid entry? */
+#if _USE_DIRCACHE
+			dcache_put(dp);				/* Remember where it is */
+#endif
 			break;
+		}
 #endif
 		res = dir_next(dp, 0);		/* Next entry */
 	} while (res == FR_OK);
@@ -1578,6 +1829,9 @@ FRESULT dir_register (	/* FR_OK:Successful, FR_DENIED:No free entry or too many
 		}
 	}
 #else	/* Non LFN configuration */
+#if _USE_DIRCACHE
+	dcache_clear(dp->fs);		/* Directory is going to change */
+#endif
 	res = dir_alloc(dp, 1);		/* Allocate an entry for SFN */
 #endif
 
@@ -1629,6 +1883,9 @@ FRESULT dir_remove (	/* FR_OK: Successful, FR_DISK_ERR: A disk error */
 	}
 
 #else			/* Non LFN configuration */
+#if _USE_DIRCACHE
+	dcache_clear(dp->fs);		/* Directory is going to change */
+#endif
 	res = dir_sdi(dp, dp->index);
 	if (res == FR_OK) {
 		res = move_window(dp->fs, dp->sect);
@@ -2279,6 +2536,9 @@ FRESULT find_volume (	/* FR_OK(0): successful, !=0: any error occurred */
 #if !_FS_READONLY
 	/* Initialize cluster allocation information */
 	fs->last_clust = fs->free_clust = 0xFFFFFFFF;
+#if _USE_FREEMAP
+	fs->fmap_stat = 0;			/* Free cluster bitmap is built on demand */
+#endif
 
 	/* Get fsinfo if available */
 	fs->fsi_flag = 0x80;
@@ -3374,6 +3634,11 @@ FRESULT f_getfree (
 	res = find_volume(fatfs, &path, 0);
 	fs = *fatfs;
 	if (res == FR_OK) {
+#if _USE_FREEMAP
+		/* Building the free cluster bitmap counts the free clusters as well */
+		if (fs->free_clust > fs->n_fatent - 2) res = fmap_build(fs);
+		if (res != FR_OK) LEAVE_FF(fs, res);
+#endif
 		/* If free_clust is valid, return it without full cluster scan */
 		if (fs->free_clust <= fs->n_fatent - 2) {
 			*nclst = fs->free_clust;
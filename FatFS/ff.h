@@ -93,6 +93,10 @@ typedef struct {
 #if !_FS_READONLY
 	DWORD	last_clust;		/* Last allocated cluster */
 	DWORD	free_clust;		/* Number of free clusters */
+#if _USE_FREEMAP
+	BYTE	fmap_stat;		/* Free cluster bitmap status (0:Not built, 1:Valid, 2:Volume too large) */
+	DWORD	fmap[(_FREEMAP_CLST + 31) / 32];	/* Free cluster bitmap (1:Free, 0:Used) */
+#endif
 #endif
 #if _FS_RPATH
 	DWORD	cdir;			/* Current directory start cluster (0:root) */
@@ -332,10 +336,19 @@ int ff_del_syncobj (_SYNC_t sobj);				/* Delete a sync object */
 /* Multi-byte word access macros  */
 
 #if _WORD_ACCESS == 1	/* Enable word access to the FAT structure */
+#if defined(__GNUC__)	/* Packed types: single LDR/STR at any address, never merged into LDM/LDRD */
+typedef struct { WORD w; } __attribute__((packed)) UA_WORD;
+typedef struct { DWORD d; } __attribute__((packed)) UA_DWORD;
+#define	LD_WORD(ptr)		(WORD)(((const UA_WORD*)(const BYTE*)(ptr))->w)
+#define	LD_DWORD(ptr)		(DWORD)(((const UA_DWORD*)(const BYTE*)(ptr))->d)
+#define	ST_WORD(ptr,val)	((UA_WORD*)(BYTE*)(ptr))->w=(WORD)(val)
+#define	ST_DWORD(ptr,val)	((UA_DWORD*)(BYTE*)(ptr))->d=(DWORD)(val)
+#else
 #define	LD_WORD(ptr)		(WORD)(*(WORD*)(BYTE*)(ptr))
 #define	LD_DWORD(ptr)		(DWORD)(*(DWORD*)(BYTE*)(ptr))
 #define	ST_WORD(ptr,val)	*(WORD*)(BYTE*)(ptr)=(WORD)(val)
 #define	ST_DWORD(ptr,val)	*(DWORD*)(BYTE*)(ptr)=(DWORD)(val)
+#endif
 #else					/* Use byte-by-byte access to the FAT structure */
 #define	LD_WORD(ptr)		(WORD)(((WORD)*((BYTE*)(ptr)+1)<<8)|(WORD)*(BYTE*)(ptr))
 #define	LD_DWORD(ptr)		(DWORD)(((DWORD)*((BYTE*)(ptr)+3)<<24)|((DWORD)*((BYTE*)(ptr)+2)<<16)|((WORD)*((BYTE*)(ptr)+1)<<8)|*(BYTE*)(ptr))
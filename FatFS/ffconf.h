@@ -8,7 +8,7 @@
 / Functions and Buffer Configurations
 /---------------------------------------------------------------------------*/
 
-#define	_FS_TINY		0
+#define	_FS_TINY		1
 /* This option switches tiny buffer configuration. (0:Normal or 1:Tiny)
 /  At the tiny configuration, size of the file object (FIL) is reduced _MAX_SS
 /  bytes. Instead of private sector buffer eliminated from the file object,
@@ -16,7 +16,7 @@
 /  data transfer. */
 
 
-#define _FS_READONLY	1
+#define _FS_READONLY	0
 /* This option switches read-only configuration. (0:Read/Write or 1:Read-only)
 /  Read-only configuration removes writing API functions, f_write(), f_sync(),
 /  f_unlink(), f_mkdir(), f_chmod(), f_rename(), f_truncate(), f_getfree()
@@ -60,11 +60,22 @@
 /  (0:Disable or 1:Enable) */
 
 
-#define	_USE_FORWARD	0
+#define	_USE_FORWARD	1
 /* This option switches f_forward() function. (0:Disable or 1:Enable)
 /  To enable it, also _FS_TINY need to be set to 1. */
 
 
+#define	_USE_DIRCACHE	8
+/* This option switches the directory entry lookup cache. (0:Disable or >0:Enable)
+/  The value defines how many entries are cached. Each cache entry maps the
+/  directory start cluster and the 8.3 name to the location of the found entry
+/  and takes about 56 bytes of RAM. Repeated f_open(), f_stat() and f_opendir()
+/  with the same path do not scan the directory sectors again. At read-only
+/  configuration a copy of the entry is kept, so a hit needs no disk access at
+/  all. The cache is cleared when an entry is added to or removed from any
+/  directory. Available only at non-LFN configuration (_USE_LFN == 0). */
+
+
 /*---------------------------------------------------------------------------/
 / Locale and Namespace Configurations
 /---------------------------------------------------------------------------*/
@@ -190,6 +201,19 @@
 */
 
 
+#define	_USE_FREEMAP	1
+#define	_FREEMAP_CLST	65536
+/* The _USE_FREEMAP option switches the in-RAM free cluster bitmap. (0:Disable
+/  or 1:Enable) When enabled, the FAT is scanned once on the first allocation or
+/  f_getfree() call after the volume mount and every FAT entry is mirrored as
+/  one bit in the file system object. put_fat() keeps the bitmap in sync, so
+/  create_chain() becomes a bit scan and f_getfree() does not read the FAT.
+/  The _FREEMAP_CLST defines the max number of clusters covered by the bitmap
+/  (_FREEMAP_CLST / 8 bytes of RAM per volume). Volumes with more clusters fall
+/  back to the linear FAT scan. This option has no effect at read-only
+/  configuration (_FS_READONLY == 1). */
+
+
 
 /*---------------------------------------------------------------------------/
 / System Configurations
@@ -242,7 +266,7 @@
 /  included somewhere in the scope of ff.c. */
 
 
-#define _WORD_ACCESS	0
+#define _WORD_ACCESS	1
 /* The _WORD_ACCESS option is an only platform dependent option. It defines
 /  which access method is used to the word data on the FAT volume.
 /
@@ -258,6 +282,7 @@
 /  ARM7TDMI   0   *2          ColdFire   0    *1         V850E      0    *2
 /  Cortex-M3  0   *3          Z80        0/1             V850ES     0/1
 /  Cortex-M0  0   *2          x86        0/1             TLCS-870   0/1
+/  Cortex-M4  1   *4
 /  AVR        0/1             RX600(LE)  0/1             TLCS-900   0/1
 /  AVR32      0   *1          RL78       0    *2         R32C       0    *2
 /  PIC18      0/1             SH-2       0    *1         M16C       0/1
@@ -267,5 +292,8 @@
 /  *1:Big-endian.
 /  *2:Unaligned memory access is not supported.
 /  *3:Some compilers generate LDM/STM for mem_cpy function.
+/  *4:LDR/STR allow misaligned address (CCR.UNALIGN_TRP = 0), LDM/LDRD do not.
+/     With GCC the word access goes through packed types (ff.h), so it is
+/     never merged into LDM/LDRD, also in mem_cpy function.
 */
 
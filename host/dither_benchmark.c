@@ -0,0 +1,88 @@
+/**
+ * NOTE:	The host benchmark of the dither stage. dither.c is built with the C reference versions of the DSP instructions
+ * 			(dsp.h without __ARM_FEATURE_DSP) and Dither_Process() is timed in every mode on the blocks of
+ * 			DITHER_BENCHMARK_FRAMES frames, as Dither_Benchmark() does with the DWT cycle counter on the target. The output
+ * 			is checked too: for a constant input between two DAC steps the mean of the 12 bit output has to be the input,
+ * 			which the truncation misses by up to one step. The host CPU is not the Cortex-M4, the numbers compare the modes,
+ * 			DITHER_CYCLE_BUDGET is checked by Dither_Benchmark() on the target.
+ *
+ * 			gcc -O2 -std=gnu99 -I inc host/dither_benchmark.c src/dither.c -o dither_benchmark
+ */
+
+#include "dither.h"
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <time.h>
+
+#define BENCHMARK_FRAMES		(uint32_t)65536		//	Frames processed in one pass, multiple of DITHER_BENCHMARK_FRAMES
+#define BENCHMARK_PASSES		(uint32_t)200
+#define BENCHMARK_LEFT			(uint32_t)0x1238	//	0x123 and a half of the DAC step
+#define BENCHMARK_RIGHT			(uint32_t)0xABC4	//	0xABC and a quarter of the DAC step
+#define BENCHMARK_MAX_ERROR		0.05				//	The largest error of the mean in the DAC steps, the truncation is 0.25 - 0.5
+
+static uint32_t	words[BENCHMARK_FRAMES];
+static const char* const mode_names[] = {"off", "tpdf", "shaped 1", "shaped 2"};
+
+static double Benchmark_Now_ns(void)
+{
+	struct timespec now;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return now.tv_sec * 1e9 + now.tv_nsec;
+}
+
+/**
+ * \brief This function fills the pass with the constant frame of BENCHMARK_LEFT and BENCHMARK_RIGHT
+ */
+static void Benchmark_Fill(void)
+{
+	for(uint32_t i = 0; i < BENCHMARK_FRAMES; i++)
+		words[i] = BENCHMARK_LEFT | (BENCHMARK_RIGHT << 16);
+}
+
+int main(void)
+{
+	int failures = 0;
+
+	for(dither_mode_e mode = DITHER_MODE_OFF; mode <= DITHER_MODE_TPDF_SHAPED_2; mode++)
+	{
+		double		time = 0;
+		double		start;
+		uint64_t	sum_left = 0;
+		uint64_t	sum_right = 0;
+		double		error_left;
+		double		error_right;
+		bool		in_limit;
+
+		Dither_Set_Mode(mode);
+		for(uint32_t pass = 0; pass < BENCHMARK_PASSES; pass++)
+		{
+			Benchmark_Fill();
+			start = Benchmark_Now_ns();
+			for(uint32_t block = 0; block < BENCHMARK_FRAMES; block += DITHER_BENCHMARK_FRAMES)
+				Dither_Process(words + block, DITHER_BENCHMARK_FRAMES);
+			time += Benchmark_Now_ns() - start;
+
+			//	The DAC converts the upper 12 bits of the lanes
+			for(uint32_t i = 0; i < BENCHMARK_FRAMES; i++)
+			{
+				sum_left += (words[i] & 0xFFFF) >> 4;
+				sum_right += words[i] >> 20;
+			}
+		}
+
+		error_left = (double)sum_left / (BENCHMARK_FRAMES * BENCHMARK_PASSES) - BENCHMARK_LEFT / 16.0;
+		error_right = (double)sum_right / (BENCHMARK_FRAMES * BENCHMARK_PASSES) - BENCHMARK_RIGHT / 16.0;
+		//	Only the dither has to keep the mean, the truncation is the reference
+		in_limit = (error_left < BENCHMARK_MAX_ERROR) && (error_left > -BENCHMARK_MAX_ERROR) && (error_right < BENCHMARK_MAX_ERROR) && (error_right > -BENCHMARK_MAX_ERROR);
+		if((mode != DITHER_MODE_OFF) && !in_limit)
+			failures++;
+
+		printf("%-9s  %5.2f ns per stereo frame  mean error %+.3f %+.3f DAC steps  %s\n", mode_names[mode],
+				time / ((double)BENCHMARK_FRAMES * BENCHMARK_PASSES), error_left, error_right,
+				(mode == DITHER_MODE_OFF) ? "truncation" : (in_limit ? "ok" : "MEAN IS OFF"));
+	}
+
+	return failures ? 1 : 0;
+}
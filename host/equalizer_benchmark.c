@@ -0,0 +1,140 @@
+/**
+ * NOTE:	The host check and benchmark of the equalizer. equalizer.c is built with the C reference versions of the DSP
+ * 			instructions (dsp.h without __ARM_FEATURE_DSP). A sine goes through Equalizer_Process() with one band at
+ * 			+-EQUALIZER_MAX_GAIN and the others at 0dB, its level at the output is taken by the correlation with the input
+ * 			frequency. The bands are checked in their pass band: the bass shelf at 20Hz, the middle peak at 1kHz and the
+ * 			treble shelf at 15kHz must give the full gain, and the shelf corners (100Hz and 8kHz) half of it in dB.
+ * 			Then all bands are timed on the blocks of EQUALIZER_BENCHMARK_FRAMES frames, like Equalizer_Benchmark().
+ * 			The host CPU is not the Cortex-M4, EQUALIZER_CYCLE_BUDGET is checked by Equalizer_Benchmark() on the target.
+ *
+ * 			gcc -O2 -std=gnu99 -I host/stub -I inc host/equalizer_benchmark.c src/equalizer.c -lm -o equalizer_benchmark
+ */
+
+#include "equalizer.h"
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <math.h>
+#include <time.h>
+
+#define BENCHMARK_RATE			EQUALIZER_DEFAULT_RATE
+#define BENCHMARK_SETTLE		(uint32_t)(BENCHMARK_RATE / 2)	//	Frames before the measurement, the 20Hz shelf settles slowly
+#define BENCHMARK_MEASURE		(uint32_t)BENCHMARK_RATE		//	Frames of the measurement, 1s
+#define BENCHMARK_AMPLITUDE		3276.0							//	-20dBFS, +12dB still fits
+#define BENCHMARK_TOLERANCE		0.5								//	In dB
+#define BENCHMARK_PASSES		(uint32_t)2000
+#define BENCHMARK_PI			3.14159265358979
+
+typedef struct
+{
+	uint8_t		band;
+	double		frequency;		/*< In Hz */
+	double		gain_part;		/*< The expected part of the band gain in dB, 1 - the full gain, 0.5 - the shelf corner */
+}benchmark_point_t;
+
+static const benchmark_point_t points[] =
+{
+	{0, 20, 1.0},
+	{0, 100, 0.5},
+	{1, 1000, 1.0},
+	{2, 8000, 0.5},
+	{2, 15000, 1.0},
+};
+
+static uint32_t	words[EQUALIZER_BENCHMARK_FRAMES];
+
+static double Benchmark_Now_ns(void)
+{
+	struct timespec now;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return now.tv_sec * 1e9 + now.tv_nsec;
+}
+
+/**
+ * \brief This function measures the gain at the frequency with the bands set as they are
+ *
+ * \return	the gain in dB, the left and the right channel averaged
+ */
+static double Benchmark_Gain(double frequency)
+{
+	double		w = 2 * BENCHMARK_PI * frequency / BENCHMARK_RATE;
+	double		sin_sum[2] = {0, 0};
+	double		cos_sum[2] = {0, 0};
+	uint32_t	frame = 0;
+	double		level = 0;
+
+	while(frame < BENCHMARK_SETTLE + BENCHMARK_MEASURE)
+	{
+		for(uint32_t i = 0; i < EQUALIZER_BENCHMARK_FRAMES; i++)
+		{
+			int32_t sample = (int32_t)lrint(BENCHMARK_AMPLITUDE * sin(w * (frame + i)));
+
+			//	The right channel is inverted, both must give the same level
+			words[i] = (uint32_t)(sample + 32768) | ((uint32_t)(32768 - sample) << 16);
+		}
+		Equalizer_Process(words, EQUALIZER_BENCHMARK_FRAMES);
+
+		for(uint32_t i = 0; (i < EQUALIZER_BENCHMARK_FRAMES) && (frame < BENCHMARK_SETTLE + BENCHMARK_MEASURE); i++, frame++)
+		{
+			if(frame < BENCHMARK_SETTLE)
+				continue;
+			for(uint32_t channel = 0; channel < 2; channel++)
+			{
+				double sample = (double)((words[i] >> (16 * channel)) & 0xFFFF) - 32768;
+
+				sin_sum[channel] += sample * sin(w * frame);
+				cos_sum[channel] += sample * cos(w * frame);
+			}
+		}
+	}
+
+	for(uint32_t channel = 0; channel < 2; channel++)
+		level += 2 * sqrt(sin_sum[channel] * sin_sum[channel] + cos_sum[channel] * cos_sum[channel]) / BENCHMARK_MEASURE;
+
+	return 20 * log10(level / 2 / BENCHMARK_AMPLITUDE);
+}
+
+int main(void)
+{
+	int		failures = 0;
+	double	time = 0;
+	double	start;
+
+	Equalizer_Set_Enabled(true);
+	for(uint32_t p = 0; p < sizeof(points) / sizeof(points[0]); p++)
+	{
+		for(int8_t gain = -EQUALIZER_MAX_GAIN; gain <= EQUALIZER_MAX_GAIN; gain += 2 * EQUALIZER_MAX_GAIN)
+		{
+			double	expected = gain * points[p].gain_part;
+			double	measured;
+			bool	in_limit;
+
+			for(uint8_t band = 0; band < EQUALIZER_BANDS; band++)
+				Equalizer_Set_Gain(band, (band == points[p].band) ? gain : 0);
+			measured = Benchmark_Gain(points[p].frequency);
+			in_limit = fabs(measured - expected) <= BENCHMARK_TOLERANCE;
+			if(!in_limit)
+				failures++;
+
+			printf("band %u  %+3d dB  %5.0f Hz  %+6.2f dB  expected %+6.2f dB  %s\n", points[p].band, gain, points[p].frequency,
+					measured, expected, in_limit ? "ok" : "OUT OF LIMIT");
+		}
+	}
+
+	//	All bands on, like Equalizer_Benchmark()
+	for(uint8_t band = 0; band < EQUALIZER_BANDS; band++)
+		Equalizer_Set_Gain(band, -EQUALIZER_GAIN_STEP);
+	for(uint32_t pass = 0; pass < BENCHMARK_PASSES; pass++)
+	{
+		for(uint32_t i = 0; i < EQUALIZER_BENCHMARK_FRAMES; i++)
+			words[i] = (i * 256) | ((65535 - i * 256) << 16);
+		start = Benchmark_Now_ns();
+		Equalizer_Process(words, EQUALIZER_BENCHMARK_FRAMES);
+		time += Benchmark_Now_ns() - start;
+	}
+	printf("%u bands  %5.2f ns per sample per band\n", EQUALIZER_BANDS,
+			time / ((double)BENCHMARK_PASSES * EQUALIZER_BENCHMARK_FRAMES * 2 * EQUALIZER_BANDS));
+
+	return failures ? 1 : 0;
+}
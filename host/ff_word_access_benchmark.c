@@ -0,0 +1,135 @@
+/**
+ * NOTE:	The host benchmark of the FatFs word access (_WORD_ACCESS 1, ffconf.h). ff.c is compiled in as it is configured
+ * 			for the target and every word access helper is timed against the byte by byte code it replaced: LD_WORD,
+ * 			LD_DWORD, ST_DWORD, cmp_sfn (mem_cmp of 11 bytes before) and sum_sfn. All the accesses are at odd addresses,
+ * 			like the fields of the directory entries in the sector buffer. The results of both versions are compared too.
+ * 			The host CPU is not the Cortex-M4, the numbers show the gain per operation, not the cycles on the target.
+ *
+ * 			gcc -O2 -std=gnu99 -DFF_BENCHMARK -I FatFS host/ff_word_access_benchmark.c -o ff_word_access_benchmark
+ */
+
+#include <stdio.h>
+#include <stdint.h>
+#include <time.h>
+
+//	integer.h declares DWORD as unsigned long, which has 64 bits on the 64 bit hosts. The 32 bit types are set here
+//	and integer.h is skipped
+#define _FF_INTEGER
+typedef uint8_t		BYTE;
+typedef int16_t		SHORT;
+typedef uint16_t	WORD;
+typedef uint16_t	WCHAR;
+typedef int			INT;
+typedef unsigned	UINT;
+typedef int32_t		LONG;
+typedef uint32_t	DWORD;
+
+#include "ff.c"
+
+#if _WORD_ACCESS != 1
+#error "The benchmark compares the word access with the byte access, _WORD_ACCESS has to be 1"
+#endif
+
+#define BENCHMARK_ENTRIES		4096			//	Directory entries in the test buffer, power of 2
+#define BENCHMARK_LOOPS			20000000
+
+//	The byte by byte versions, as in ff.h and ff.c with _WORD_ACCESS 0
+#define	BYTE_LD_WORD(ptr)		(WORD)(((WORD)*((BYTE*)(ptr)+1)<<8)|(WORD)*(BYTE*)(ptr))
+#define	BYTE_LD_DWORD(ptr)		(DWORD)(((DWORD)*((BYTE*)(ptr)+3)<<24)|((DWORD)*((BYTE*)(ptr)+2)<<16)|((WORD)*((BYTE*)(ptr)+1)<<8)|*(BYTE*)(ptr))
+#define	BYTE_ST_DWORD(ptr,val)	*(BYTE*)(ptr)=(BYTE)(val); *((BYTE*)(ptr)+1)=(BYTE)((DWORD)(val)>>8); *((BYTE*)(ptr)+2)=(BYTE)((DWORD)(val)>>16); *((BYTE*)(ptr)+3)=(BYTE)((DWORD)(val)>>24)
+
+static BYTE		entries[BENCHMARK_ENTRIES * 32 + 1];	/*< The directory entries, one byte off the word boundary */
+static BYTE		name[12];								/*< The searched SFN */
+
+//	The dummy disk functions, ff.c is not used with a volume here
+DSTATUS disk_initialize (BYTE pdrv) { (void)pdrv; return STA_NOINIT; }
+DSTATUS disk_status (BYTE pdrv) { (void)pdrv; return STA_NOINIT; }
+DRESULT disk_read (BYTE pdrv, BYTE* buff, DWORD sector, UINT count) { (void)pdrv; (void)buff; (void)sector; (void)count; return RES_ERROR; }
+DRESULT disk_write (BYTE pdrv, const BYTE* buff, DWORD sector, UINT count) { (void)pdrv; (void)buff; (void)sector; (void)count; return RES_ERROR; }
+DRESULT disk_ioctl (BYTE pdrv, BYTE cmd, void* buff) { (void)pdrv; (void)cmd; (void)buff; return RES_ERROR; }
+
+static int byte_cmp_sfn (const BYTE* dir, const BYTE* fn)
+{
+	int r = 0;
+	UINT cnt = 11;
+
+	while (cnt-- && (r = *dir++ - *fn++) == 0) ;
+	return r;
+}
+
+static BYTE byte_sum_sfn (const BYTE* dir)
+{
+	BYTE sum = 0;
+	UINT n = 11;
+
+	do sum = (sum >> 1) + (sum << 7) + *dir++; while (--n);
+	return sum;
+}
+
+static double Benchmark_Now_ns(void)
+{
+	struct timespec now;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return now.tv_sec * 1e9 + now.tv_nsec;
+}
+
+//	The entry used by the loop i, the loop index keeps the compiler from taking the loads out of the loop
+#define ENTRY(i)				(entries + 1 + ((i) & (BENCHMARK_ENTRIES - 1)) * 32)
+//	The result is used, so the loop is not removed
+#define MEASURE(result, expression) \
+	({ double start = Benchmark_Now_ns(); DWORD acc = 0; \
+	   for (UINT i = 0; i < BENCHMARK_LOOPS; i++) { acc += (DWORD)(expression); __asm__ volatile("" : "+r"(acc)); } \
+	   result = acc; (Benchmark_Now_ns() - start) / BENCHMARK_LOOPS; })
+
+static int failures;
+
+static void Benchmark_Report(const char* operation, double byte_ns, DWORD byte_result, double word_ns, DWORD word_result)
+{
+	printf("%-10s  byte %6.2f ns  word %6.2f ns  gain %5.2fx  %s\n", operation, byte_ns, word_ns, byte_ns / word_ns,
+			(byte_result == word_result) ? "same result" : "DIFFERENT RESULT");
+	if (byte_result != word_result)
+		failures++;
+}
+
+int main(void)
+{
+	DWORD	byte_result, word_result;
+	double	byte_ns, word_ns;
+	DWORD	random = 0xACE1;
+
+	for (UINT i = 0; i < sizeof(entries); i++) {
+		random = random * 1103515245 + 12345;
+		entries[i] = (BYTE)(random >> 16);
+	}
+	//	Every 16th entry has the searched name, the rest differ at a random place
+	mem_cpy(name, "README  TXT", 11);
+	for (UINT i = 0; i < BENCHMARK_ENTRIES; i++) {
+		mem_cpy(ENTRY(i), name, 11);
+		if (i % 16)
+			ENTRY(i)[entries[i] % 11] ^= 0x20;
+	}
+
+	byte_ns = MEASURE(byte_result, BYTE_LD_WORD(ENTRY(i) + DIR_FstClusLO));
+	word_ns = MEASURE(word_result, LD_WORD(ENTRY(i) + DIR_FstClusLO));
+	Benchmark_Report("LD_WORD", byte_ns, byte_result, word_ns, word_result);
+
+	byte_ns = MEASURE(byte_result, BYTE_LD_DWORD(ENTRY(i) + DIR_FileSize));
+	word_ns = MEASURE(word_result, LD_DWORD(ENTRY(i) + DIR_FileSize));
+	Benchmark_Report("LD_DWORD", byte_ns, byte_result, word_ns, word_result);
+
+	byte_ns = MEASURE(byte_result, ({ BYTE_ST_DWORD(ENTRY(i) + DIR_FileSize, i); ENTRY(i)[DIR_FileSize]; }));
+	word_ns = MEASURE(word_result, ({ ST_DWORD(ENTRY(i) + DIR_FileSize, i); ENTRY(i)[DIR_FileSize]; }));
+	Benchmark_Report("ST_DWORD", byte_ns, byte_result, word_ns, word_result);
+
+	//	Only the match matters, the sign of mem_cmp is not used by dir_find
+	byte_ns = MEASURE(byte_result, byte_cmp_sfn(ENTRY(i), name) == 0);
+	word_ns = MEASURE(word_result, cmp_sfn(ENTRY(i), name) == 0);
+	Benchmark_Report("cmp_sfn", byte_ns, byte_result, word_ns, word_result);
+
+	byte_ns = MEASURE(byte_result, byte_sum_sfn(ENTRY(i)));
+	word_ns = MEASURE(word_result, sum_sfn(ENTRY(i)));
+	Benchmark_Report("sum_sfn", byte_ns, byte_result, word_ns, word_result);
+
+	return failures ? 1 : 0;
+}
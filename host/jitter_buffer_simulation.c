@@ -0,0 +1,167 @@
+/**
+ * NOTE:	The host simulation of the jitter buffer controller, without the network and the DAC. jitter_buffer.c is built
+ * 			with the C reference versions of the DSP instructions (dsp.h without __ARM_FEATURE_DSP). The stereo 44.1kHz
+ * 			sender with its clock off by the drift gives the packets with a random delay of up to two packets and the
+ * 			playback ring is emptied by the DAC blocks. The drift table shows the correction at the end and the largest
+ * 			filtered level error in the second half of the run, for the drifts up to JITTER_BUFFER_MAX_CORRECTION and the
+ * 			runs of 30s to 5min, then the packet sizes. The error must stay under BENCHMARK_MAX_ERROR frames and the buffer
+ * 			must never run empty or overflow.
+ *
+ * 			gcc -O2 -std=gnu99 -I inc host/jitter_buffer_simulation.c src/jitter_buffer.c src/resampler.c src/audio_ring.c src/pcm_convert.c -lm -o jitter_buffer_simulation
+ */
+
+#include "jitter_buffer.h"
+#include "audio_ring.h"
+#include "resampler.h"
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#define BENCHMARK_RATE				(uint32_t)44100
+#define BENCHMARK_RING_SIZE			(uint32_t)32768		//	Power of 2
+#define BENCHMARK_TARGET_MS			(uint32_t)50
+#define BENCHMARK_PACKET_FRAMES		(uint32_t)365		//	The 1460 byte TCP segment
+#define BENCHMARK_MAX_PACKET_FRAMES	(uint32_t)512
+#define BENCHMARK_MAX_ERROR			(int32_t)128		//	The largest filtered level error in frames, ~3ms
+
+typedef struct
+{
+	int32_t			correction_ppm;			/*< The correction at the end, it should follow the drift */
+	int32_t			max_error_frames;		/*< The largest filtered level error after the settling */
+	uint32_t		underruns;
+	uint32_t		overflows;
+}simulation_result_t;
+
+static const int32_t	drifts[] = {-1000, -500, -100, 0, 100, 500, 900, 1000};
+static const uint32_t	runs[] = {30, 60, 120, 300};
+static const uint32_t	packet_sizes[] = {64, 128, 256, 512};
+
+static jitter_buffer_t	jitter;
+static uint8_t			buffer[BENCHMARK_RING_SIZE];
+static uint8_t			playback_buffer[4 * JITTER_BUFFER_UPDATE_FRAMES * sizeof(uint32_t)];
+static int16_t			packet[RESAMPLER_MAX_CHANNELS * BENCHMARK_MAX_PACKET_FRAMES];
+static uint32_t			words[JITTER_BUFFER_UPDATE_FRAMES];
+
+/**
+ * \brief This function runs the sender and the DAC against the jitter buffer
+ *
+ * \param drift_ppm[IN]		-	the sender clock error, positive if it is faster than the DAC
+ * \param packet_frames[IN]	-	the frames in one packet
+ * \param seconds[IN]		-	the simulated time, the level error is checked in its second half
+ *
+ * \return	the correction at the end, the largest level error and the statistics of the buffer
+ */
+static simulation_result_t Simulation_Run(int32_t drift_ppm, uint32_t packet_frames, uint32_t seconds)
+{
+	simulation_result_t	result = {0, 0, 0, 0};
+	audio_ring_t		playback;
+	//	The times in the DAC frames, Q16
+	uint64_t			packet_period = ((uint64_t)packet_frames << 16) * 1000000 / (1000000 + drift_ppm);
+	uint64_t			send_time = 0;
+	uint64_t			arrival_time = 0;
+	uint64_t			delay;
+	uint64_t			now = 0;
+	uint64_t			end = ((uint64_t)BENCHMARK_RATE * seconds) << 16;
+	uint32_t			random = 12345;
+	uint32_t			sample = 0;
+
+	if(!Jitter_Buffer_Init(&jitter, buffer, sizeof(buffer), BENCHMARK_RATE, BENCHMARK_RATE, 2, BENCHMARK_TARGET_MS))
+	{
+		result.underruns = UINT32_MAX;
+		return result;
+	}
+
+	Audio_Ring_Init(&playback, playback_buffer, sizeof(playback_buffer));
+
+	while(now < end)
+	{
+		//	Deliver the packets which have arrived. The next one is sent a period later with the random delay of 0 - 2 periods, but never before the last one
+		while(arrival_time <= now)
+		{
+			//	The saw tooth, so the resampler has some signal
+			for(uint32_t i = 0; i < 2 * packet_frames; i++)
+				packet[i] = (int16_t)(sample++ * 64);
+			Jitter_Buffer_Put(&jitter, (uint8_t*)packet, packet_frames * 2 * sizeof(int16_t));
+
+			send_time += packet_period;
+			random = random * 1664525 + 1013904223;
+			delay = ((packet_period * 2) * (random >> 16)) >> 16;
+			if(send_time + delay > arrival_time)
+				arrival_time = send_time + delay;
+		}
+
+		Jitter_Buffer_Process(&jitter, &playback);
+
+		//	The level error is checked after the settling
+		if(now > end / 2)
+		{
+			int32_t error = jitter.filtered_error / 256;
+
+			if(error < 0)
+				error = -error;
+			if(error > result.max_error_frames)
+				result.max_error_frames = error;
+		}
+
+		//	The DAC takes one update worth of frames
+		Audio_Ring_Get(&playback, (uint8_t*)words, sizeof(words));
+		now += (uint64_t)JITTER_BUFFER_UPDATE_FRAMES << 16;
+	}
+
+	result.correction_ppm = Jitter_Buffer_Get_Correction_Ppm(&jitter);
+	result.underruns = jitter.underruns;
+	result.overflows = jitter.overflows;
+
+	return result;
+}
+
+/**
+ * \brief This function checks and prints one result
+ *
+ * \return	true if the level error is in the limit and the buffer never ran empty or overflowed
+ */
+static bool Simulation_Print(simulation_result_t* result)
+{
+	bool ok = (result->max_error_frames <= BENCHMARK_MAX_ERROR) && (result->underruns == 0) && (result->overflows == 0);
+
+	printf("  %5ld/%-3ld%s", (long)result->correction_ppm, (long)result->max_error_frames, ok ? " " : "!");
+	return ok;
+}
+
+int main(void)
+{
+	int failures = 0;
+
+	printf("Drift table, %lu frame packets: the correction in ppm / the largest level error in frames, ! - out of the limit\n",
+			(unsigned long)BENCHMARK_PACKET_FRAMES);
+	printf("drift ppm");
+	for(uint32_t d = 0; d < sizeof(drifts) / sizeof(drifts[0]); d++)
+		printf("  %10ld", (long)drifts[d]);
+	printf("\n");
+
+	for(uint32_t r = 0; r < sizeof(runs) / sizeof(runs[0]); r++)
+	{
+		printf("%7lus", (unsigned long)runs[r]);
+		for(uint32_t d = 0; d < sizeof(drifts) / sizeof(drifts[0]); d++)
+		{
+			simulation_result_t result = Simulation_Run(drifts[d], BENCHMARK_PACKET_FRAMES, runs[r]);
+
+			if(!Simulation_Print(&result))
+				failures++;
+		}
+		printf("\n");
+	}
+
+	printf("\nPacket sizes, 300ppm, 60s\n");
+	for(uint32_t p = 0; p < sizeof(packet_sizes) / sizeof(packet_sizes[0]); p++)
+	{
+		simulation_result_t result = Simulation_Run(300, packet_sizes[p], 60);
+
+		printf("%5lu frames", (unsigned long)packet_sizes[p]);
+		if(!Simulation_Print(&result))
+			failures++;
+		printf("  underruns %lu  overflows %lu\n", (unsigned long)result.underruns, (unsigned long)result.overflows);
+	}
+
+	return failures ? 1 : 0;
+}
@@ -0,0 +1,268 @@
+/**
+ * NOTE:	The host check and benchmark of the mixer. mixer.c is built with the C reference versions of the DSP
+ * 			instructions (dsp.h without __ARM_FEATURE_DSP) and fed from two playback rings of constant DAC words, so every
+ * 			output word can be computed here: the gain of the frame n of the ramp is the start gain plus n + 1 steps, in Q15
+ * 			with the Q16 fraction like in mixer.c, and the two scaled sources are summed with the saturation. Checked are the
+ * 			copy of the main source, the fade out, the crossfade to the aux source, the saturation of the full scale sum
+ * 			(the positive and the negative one), the source which runs out of data and the underrun. Then the crossfade is
+ * 			timed on the blocks of MIXER_BENCHMARK_FRAMES frames, like Mixer_Benchmark().
+ * 			The host CPU is not the Cortex-M4, MIXER_CYCLE_BUDGET is checked by Mixer_Benchmark() on the target.
+ *
+ * 			gcc -O2 -std=gnu99 -I host/stub -I inc host/mixer_benchmark.c src/mixer.c src/audio_ring.c -o mixer_benchmark
+ */
+
+#include "mixer.h"
+#include "audio_ring.h"
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <time.h>
+
+#define BENCHMARK_RING_FRAMES		(uint32_t)8192		//	Power of 2
+#define BENCHMARK_BLOCK				(uint32_t)256
+#define BENCHMARK_FADE_FRAMES		(uint32_t)1000		//	Not a multiple of the block, the ramp ends in the middle of one
+#define BENCHMARK_PASSES			(uint32_t)20000
+
+typedef struct
+{
+	int32_t		gain;			/*< Q15 with the Q16 fraction */
+	int32_t		target_gain;
+	int32_t		step;
+	uint32_t	remaining;
+}benchmark_envelope_t;
+
+static uint32_t		ring_buffers[MIXER_SOURCES][BENCHMARK_RING_FRAMES];
+static audio_ring_t	rings[MIXER_SOURCES];
+static uint32_t		words[BENCHMARK_RING_FRAMES];
+
+static double Benchmark_Now_ns(void)
+{
+	struct timespec now;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return now.tv_sec * 1e9 + now.tv_nsec;
+}
+
+/**
+ * \brief This function puts the frames of the constant DAC word in the ring of the source
+ */
+static void Benchmark_Fill(mixer_source_e source, int16_t left, int16_t right, uint32_t frames)
+{
+	uint32_t word = (uint32_t)((uint16_t)left ^ 0x8000) | ((uint32_t)((uint16_t)right ^ 0x8000) << 16);
+
+	Audio_Ring_Clear(&rings[source]);
+	for(uint32_t i = 0; i < frames; i++)
+		words[i] = word;
+	Audio_Ring_Put(&rings[source], (uint8_t*)words, frames * sizeof(uint32_t));
+}
+
+/**
+ * \brief This function starts the reference envelope like Mixer_Fade() does at the start of the next block
+ */
+static void Benchmark_Fade(benchmark_envelope_t* envelope, int16_t gain, uint32_t frames)
+{
+	envelope->target_gain = gain * 65536;
+	if(frames == 0)
+	{
+		envelope->gain = envelope->target_gain;
+		envelope->remaining = 0;
+	}
+	else
+	{
+		envelope->step = (envelope->target_gain - envelope->gain) / (int32_t)frames;
+		envelope->remaining = frames;
+	}
+}
+
+/**
+ * \brief This function gives the Q15 gain of the next frame of the reference envelope, up to 32768
+ */
+static int32_t Benchmark_Next_Gain(benchmark_envelope_t* envelope)
+{
+	int32_t gain;
+
+	//	At the unity gain after the ramp the words are not scaled, 1.0 in Q15
+	if(envelope->remaining == 0)
+		return ((envelope->gain >> 16) == MIXER_UNITY_GAIN) ? 32768 : (envelope->gain >> 16);
+
+	//	Every frame of the ramp is scaled, mixer.c moves to the exact target after its last frame
+	envelope->gain += envelope->step;
+	gain = envelope->gain >> 16;
+	if(--envelope->remaining == 0)
+		envelope->gain = envelope->target_gain;
+
+	return gain;
+}
+
+/**
+ * \brief The signed sample scaled by the Q15 gain
+ */
+static int32_t Benchmark_Scale(int16_t sample, int32_t gain)
+{
+	return (sample * gain) >> 15;
+}
+
+/**
+ * \brief The saturated sum of two lanes, moved to the unsigned range
+ */
+static uint32_t Benchmark_Sum(int32_t main_sample, int32_t aux_sample)
+{
+	int32_t sum = main_sample + aux_sample;
+
+	if(sum > 32767)
+		sum = 32767;
+	if(sum < -32768)
+		sum = -32768;
+	return (uint32_t)(sum + 32768);
+}
+
+/**
+ * \brief This function takes the blocks from the mixer and compares every word with the reference
+ *
+ * \param samples[IN]			-	the constant left and right samples of the main and the aux source
+ * \param envelopes[IN/OUT]	-	the reference gain envelopes of the sources, started like the mixer ones
+ * \param main_frames[IN]		-	the frames in the main ring
+ * \param aux_frames[IN]		-	the frames in the aux ring
+ * \param frames[IN]			-	the frames to take, the mixer must stop with the longer source
+ *
+ * \return	the number of the wrong words, the wrong block length counts too
+ */
+static uint32_t Benchmark_Check_Blocks(const int16_t samples[MIXER_SOURCES][2], benchmark_envelope_t envelopes[MIXER_SOURCES],
+		uint32_t main_frames, uint32_t aux_frames, uint32_t frames)
+{
+	static uint32_t	block[BENCHMARK_BLOCK];
+	uint32_t		wrong = 0;
+	uint32_t		frame = 0;
+
+	while(frame < frames)
+	{
+		uint32_t count = Mixer_Get(block, BENCHMARK_BLOCK);
+		uint32_t expected_count = BENCHMARK_BLOCK;
+
+		if((main_frames < frame + expected_count) && (aux_frames < frame + expected_count))
+			expected_count = ((main_frames > aux_frames) ? main_frames : aux_frames) - frame;
+		if(count != expected_count)
+			return wrong + 1;
+		if(count == 0)
+			break;
+
+		for(uint32_t i = 0; i < count; i++, frame++)
+		{
+			int32_t		main_gain = Benchmark_Next_Gain(&envelopes[MIXER_SOURCE_MAIN]);
+			int32_t		aux_gain = Benchmark_Next_Gain(&envelopes[MIXER_SOURCE_AUX]);
+			int16_t		main_left = (frame < main_frames) ? samples[MIXER_SOURCE_MAIN][0] : 0;
+			int16_t		main_right = (frame < main_frames) ? samples[MIXER_SOURCE_MAIN][1] : 0;
+			int16_t		aux_left = (frame < aux_frames) ? samples[MIXER_SOURCE_AUX][0] : 0;
+			int16_t		aux_right = (frame < aux_frames) ? samples[MIXER_SOURCE_AUX][1] : 0;
+			uint32_t	expected = Benchmark_Sum(Benchmark_Scale(main_left, main_gain), Benchmark_Scale(aux_left, aux_gain)) |
+							(Benchmark_Sum(Benchmark_Scale(main_right, main_gain), Benchmark_Scale(aux_right, aux_gain)) << 16);
+
+			if(block[i] != expected)
+				wrong++;
+		}
+	}
+
+	return wrong;
+}
+
+/**
+ * \brief This function runs one case: the rings are filled, the fades are started and the output is checked
+ *
+ * \return	the number of the wrong words
+ */
+static uint32_t Benchmark_Case(const char* name, const int16_t samples[MIXER_SOURCES][2], uint32_t main_frames, uint32_t aux_frames,
+		int16_t main_gain, int16_t aux_gain, uint32_t fade_frames)
+{
+	benchmark_envelope_t	envelopes[MIXER_SOURCES];
+	uint32_t				wrong;
+
+	//	Both sources start at the unity gain, the envelopes are set with one empty block
+	Audio_Ring_Clear(&rings[MIXER_SOURCE_MAIN]);
+	Audio_Ring_Clear(&rings[MIXER_SOURCE_AUX]);
+	Mixer_Set_Gain(MIXER_SOURCE_MAIN, MIXER_UNITY_GAIN);
+	Mixer_Set_Gain(MIXER_SOURCE_AUX, MIXER_UNITY_GAIN);
+	Mixer_Get(words, BENCHMARK_BLOCK);
+	for(uint8_t source = 0; source < MIXER_SOURCES; source++)
+	{
+		envelopes[source].gain = MIXER_UNITY_GAIN * 65536;
+		envelopes[source].remaining = 0;
+	}
+
+	Benchmark_Fill(MIXER_SOURCE_MAIN, samples[MIXER_SOURCE_MAIN][0], samples[MIXER_SOURCE_MAIN][1], main_frames);
+	Benchmark_Fill(MIXER_SOURCE_AUX, samples[MIXER_SOURCE_AUX][0], samples[MIXER_SOURCE_AUX][1], aux_frames);
+	Mixer_Fade(MIXER_SOURCE_MAIN, main_gain, fade_frames);
+	Mixer_Fade(MIXER_SOURCE_AUX, aux_gain, fade_frames);
+	Benchmark_Fade(&envelopes[MIXER_SOURCE_MAIN], main_gain, fade_frames);
+	Benchmark_Fade(&envelopes[MIXER_SOURCE_AUX], aux_gain, fade_frames);
+
+	wrong = Benchmark_Check_Blocks(samples, envelopes, main_frames, aux_frames, BENCHMARK_RING_FRAMES);
+	if(Mixer_Is_Fading(MIXER_SOURCE_MAIN) || Mixer_Is_Fading(MIXER_SOURCE_AUX))
+		wrong++;
+
+	printf("%-26s  %s\n", name, wrong ? "WRONG" : "ok");
+	return wrong;
+}
+
+int main(void)
+{
+	static const int16_t	music[MIXER_SOURCES][2] = {{12000, -9000}, {0, 0}};
+	static const int16_t	both[MIXER_SOURCES][2] = {{12000, -9000}, {-20000, 7000}};
+	static const int16_t	loud[MIXER_SOURCES][2] = {{30000, -30000}, {30000, -30000}};
+	static const int16_t	full[MIXER_SOURCES][2] = {{32767, -32768}, {32767, -32768}};
+	uint32_t				wrong = 0;
+	double					time = 0;
+	double					start;
+
+	for(uint8_t source = 0; source < MIXER_SOURCES; source++)
+	{
+		Audio_Ring_Init(&rings[source], (uint8_t*)ring_buffers[source], sizeof(ring_buffers[source]));
+		Mixer_Set_Source((mixer_source_e)source, &rings[source]);
+	}
+
+	wrong += Benchmark_Case("main copied", music, 4000, 0, MIXER_UNITY_GAIN, MIXER_UNITY_GAIN, 0);
+	wrong += Benchmark_Case("main fade out", music, 4000, 0, 0, MIXER_UNITY_GAIN, BENCHMARK_FADE_FRAMES);
+	wrong += Benchmark_Case("main to half, aux mixed", both, 4000, 4000, 16384, MIXER_UNITY_GAIN, BENCHMARK_FADE_FRAMES);
+	wrong += Benchmark_Case("sum saturated", loud, 4000, 4000, MIXER_UNITY_GAIN, MIXER_UNITY_GAIN, 0);
+	wrong += Benchmark_Case("full scale sum saturated", full, 4000, 4000, MIXER_UNITY_GAIN, MIXER_UNITY_GAIN, 0);
+	wrong += Benchmark_Case("aux runs out first", both, 4000, 1234, MIXER_UNITY_GAIN, MIXER_UNITY_GAIN, 0);
+	wrong += Benchmark_Case("main runs out first", both, 777, 3000, MIXER_UNITY_GAIN, MIXER_UNITY_GAIN, BENCHMARK_FADE_FRAMES);
+
+	//	The crossfade: the aux source starts silent and takes over
+	{
+		benchmark_envelope_t	envelopes[MIXER_SOURCES];
+		uint32_t				crossfade_wrong;
+
+		Audio_Ring_Clear(&rings[MIXER_SOURCE_MAIN]);
+		Audio_Ring_Clear(&rings[MIXER_SOURCE_AUX]);
+		Mixer_Set_Gain(MIXER_SOURCE_MAIN, MIXER_UNITY_GAIN);
+		Mixer_Set_Gain(MIXER_SOURCE_AUX, 0);
+		Mixer_Get(words, BENCHMARK_BLOCK);
+		envelopes[MIXER_SOURCE_MAIN].gain = MIXER_UNITY_GAIN * 65536;
+		envelopes[MIXER_SOURCE_MAIN].remaining = 0;
+		envelopes[MIXER_SOURCE_AUX].gain = 0;
+		envelopes[MIXER_SOURCE_AUX].remaining = 0;
+
+		Benchmark_Fill(MIXER_SOURCE_MAIN, both[MIXER_SOURCE_MAIN][0], both[MIXER_SOURCE_MAIN][1], 4000);
+		Benchmark_Fill(MIXER_SOURCE_AUX, both[MIXER_SOURCE_AUX][0], both[MIXER_SOURCE_AUX][1], 4000);
+		Mixer_Crossfade(MIXER_SOURCE_AUX, BENCHMARK_FADE_FRAMES);
+		Benchmark_Fade(&envelopes[MIXER_SOURCE_MAIN], 0, BENCHMARK_FADE_FRAMES);
+		Benchmark_Fade(&envelopes[MIXER_SOURCE_AUX], MIXER_UNITY_GAIN, BENCHMARK_FADE_FRAMES);
+		crossfade_wrong = Benchmark_Check_Blocks(both, envelopes, 4000, 4000, BENCHMARK_RING_FRAMES);
+		printf("%-26s  %s\n", "crossfade to aux", crossfade_wrong ? "WRONG" : "ok");
+		wrong += crossfade_wrong;
+	}
+
+	//	Both sources fading, like Mixer_Benchmark()
+	for(uint32_t pass = 0; pass < BENCHMARK_PASSES; pass++)
+	{
+		Benchmark_Fill(MIXER_SOURCE_MAIN, 1000, -1000, MIXER_BENCHMARK_FRAMES);
+		Benchmark_Fill(MIXER_SOURCE_AUX, -2000, 2000, MIXER_BENCHMARK_FRAMES);
+		Mixer_Crossfade((pass & 1) ? MIXER_SOURCE_MAIN : MIXER_SOURCE_AUX, MIXER_BENCHMARK_FRAMES * 2);
+		start = Benchmark_Now_ns();
+		Mixer_Get(words, MIXER_BENCHMARK_FRAMES);
+		time += Benchmark_Now_ns() - start;
+	}
+	printf("crossfade  %5.2f ns per stereo frame\n", time / ((double)BENCHMARK_PASSES * MIXER_BENCHMARK_FRAMES));
+
+	return wrong ? 1 : 0;
+}
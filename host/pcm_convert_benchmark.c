@@ -0,0 +1,178 @@
+/**
+ * NOTE:	The host check and benchmark of the PCM conversion kernels. pcm_convert.c is built with the C reference versions
+ * 			of the DSP instructions (dsp.h without __ARM_FEATURE_DSP). Every kernel is compared bit for bit with the plain
+ * 			per sample conversion below for the input at all four byte alignments and for every frame count up to
+ * 			BENCHMARK_CHECK_FRAMES, so the tails after the two and four frame loops are covered too; the word after the last
+ * 			frame must stay untouched. Then both are timed on the blocks of PCM_CONVERT_BENCHMARK_FRAMES frames.
+ * 			The host CPU is not the Cortex-M4, the numbers show the gain of the lane packing, Pcm_Convert_Benchmark() gives
+ * 			the cycles on the target.
+ *
+ * 			gcc -O2 -std=gnu99 -I inc host/pcm_convert_benchmark.c src/pcm_convert.c -o pcm_convert_benchmark
+ */
+
+#include "pcm_convert.h"
+#include <stdio.h>
+#include <stdint.h>
+#include <time.h>
+
+#define BENCHMARK_CHECK_FRAMES		(uint32_t)67		//	Frame counts checked at every alignment: 0 to 67
+#define BENCHMARK_PASSES			(uint32_t)100000
+#define BENCHMARK_GUARD				(uint32_t)0xDEADBEEF
+
+typedef struct
+{
+	const char*		name;
+	pcm_convert_f	kernel;
+	pcm_convert_f	reference;
+	uint8_t			frame_size;		/*< Bytes of one input frame */
+}benchmark_kernel_t;
+
+static uint8_t	input[PCM_CONVERT_BENCHMARK_FRAMES * 6 + 3];	//	The longest frame - 24 bit stereo, and the alignment offset
+static uint32_t	output[PCM_CONVERT_BENCHMARK_FRAMES + 1];
+static uint32_t	expected[PCM_CONVERT_BENCHMARK_FRAMES + 1];
+
+/**
+ * \brief The DAC word of two unsigned 16 bit samples
+ */
+static uint32_t Reference_Word(uint32_t left, uint32_t right)
+{
+	return (left & 0xFFFF) | ((right & 0xFFFF) << 16);
+}
+
+/**
+ * \brief The signed 16 bit sample (little endian) moved to the unsigned range
+ */
+static uint32_t Reference_S16(const uint8_t* sample)
+{
+	return ((uint32_t)sample[0] | ((uint32_t)sample[1] << 8)) ^ 0x8000;
+}
+
+static void Reference_U8_Mono(const uint8_t* in, uint32_t* out, uint32_t frames)
+{
+	for(uint32_t i = 0; i < frames; i++)
+		out[i] = Reference_Word(in[i] << 8, in[i] << 8);
+}
+
+static void Reference_U8_Stereo(const uint8_t* in, uint32_t* out, uint32_t frames)
+{
+	for(uint32_t i = 0; i < frames; i++)
+		out[i] = Reference_Word(in[2*i] << 8, in[2*i + 1] << 8);
+}
+
+static void Reference_S16_Mono(const uint8_t* in, uint32_t* out, uint32_t frames)
+{
+	for(uint32_t i = 0; i < frames; i++)
+		out[i] = Reference_Word(Reference_S16(in + 2*i), Reference_S16(in + 2*i));
+}
+
+static void Reference_S16_Stereo(const uint8_t* in, uint32_t* out, uint32_t frames)
+{
+	for(uint32_t i = 0; i < frames; i++)
+		out[i] = Reference_Word(Reference_S16(in + 4*i), Reference_S16(in + 4*i + 2));
+}
+
+static void Reference_S24_Mono(const uint8_t* in, uint32_t* out, uint32_t frames)
+{
+	for(uint32_t i = 0; i < frames; i++)
+		out[i] = Reference_Word(Reference_S16(in + 3*i + 1), Reference_S16(in + 3*i + 1));
+}
+
+static void Reference_S24_Stereo(const uint8_t* in, uint32_t* out, uint32_t frames)
+{
+	for(uint32_t i = 0; i < frames; i++)
+		out[i] = Reference_Word(Reference_S16(in + 6*i + 1), Reference_S16(in + 6*i + 4));
+}
+
+static const benchmark_kernel_t kernels[] =
+{
+	{"U8 mono",			Pcm_Convert_U8_Mono,		Reference_U8_Mono,			1},
+	{"U8 stereo",		Pcm_Convert_U8_Stereo,		Reference_U8_Stereo,		2},
+	{"S16 mono",		Pcm_Convert_S16_Mono,		Reference_S16_Mono,			2},
+	{"S16 stereo",		Pcm_Convert_S16_Stereo,		Reference_S16_Stereo,		4},
+	{"S24 mono",		Pcm_Convert_S24_Mono,		Reference_S24_Mono,			3},
+	{"S24 stereo",		Pcm_Convert_S24_Stereo,		Reference_S24_Stereo,		6},
+};
+
+static double Benchmark_Now_ns(void)
+{
+	struct timespec now;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return now.tv_sec * 1e9 + now.tv_nsec;
+}
+
+/**
+ * \brief This function compares the kernel with its reference at every alignment and frame count
+ *
+ * \return	the number of the wrong words, the overwritten guard word counts too
+ */
+static uint32_t Benchmark_Check(const benchmark_kernel_t* kernel)
+{
+	uint32_t wrong = 0;
+
+	for(uint32_t alignment = 0; alignment < 4; alignment++)
+	{
+		for(uint32_t frames = 0; frames <= BENCHMARK_CHECK_FRAMES; frames++)
+		{
+			for(uint32_t i = 0; i <= frames; i++)
+				output[i] = expected[i] = BENCHMARK_GUARD;
+
+			kernel->kernel(input + alignment, output, frames);
+			kernel->reference(input + alignment, expected, frames);
+
+			for(uint32_t i = 0; i <= frames; i++)
+			{
+				if(output[i] != expected[i])
+					wrong++;
+			}
+		}
+	}
+
+	return wrong;
+}
+
+/**
+ * \brief This function times the conversion of the unaligned input
+ *
+ * \return	ns per frame
+ */
+static double Benchmark_Time(pcm_convert_f convert)
+{
+	double		start = Benchmark_Now_ns();
+
+	for(uint32_t pass = 0; pass < BENCHMARK_PASSES; pass++)
+	{
+		convert(input + 1, output, PCM_CONVERT_BENCHMARK_FRAMES);
+		//	The output is used, so the passes are not removed
+		__asm__ volatile("" : : "r"(output) : "memory");
+	}
+
+	return (Benchmark_Now_ns() - start) / ((double)BENCHMARK_PASSES * PCM_CONVERT_BENCHMARK_FRAMES);
+}
+
+int main(void)
+{
+	uint32_t	random = 0xACE1;
+	uint32_t	failures = 0;
+
+	for(uint32_t i = 0; i < sizeof(input); i++)
+	{
+		random = random * 1103515245 + 12345;
+		input[i] = (uint8_t)(random >> 16);
+	}
+	if(BENCHMARK_CHECK_FRAMES > PCM_CONVERT_BENCHMARK_FRAMES)
+		return 1;
+
+	for(uint32_t k = 0; k < sizeof(kernels) / sizeof(kernels[0]); k++)
+	{
+		uint32_t	wrong = Benchmark_Check(&kernels[k]);
+		double		reference_ns = Benchmark_Time(kernels[k].reference);
+		double		kernel_ns = Benchmark_Time(kernels[k].kernel);
+
+		printf("%-10s  reference %5.2f ns  kernel %5.2f ns per frame  gain %5.2fx  %s\n", kernels[k].name, reference_ns, kernel_ns,
+				reference_ns / kernel_ns, wrong ? "DIFFERENT" : "bit-exact");
+		failures += wrong;
+	}
+
+	return failures ? 1 : 0;
+}
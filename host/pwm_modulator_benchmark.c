@@ -0,0 +1,201 @@
+/**
+ * NOTE:	The host check and benchmark of the PWM modulator. pwm_modulator.c is built with the C reference versions of
+ * 			the DSP instructions (dsp.h without __ARM_FEATURE_DSP) and the carrier period of the target: TIM1 at 168MHz and
+ * 			4 x 44.1kHz give 952 steps. The duty quantization error (the duty minus the wanted Q16 level) is taken at the
+ * 			carrier rate, windowed and transformed, and its power in the audio band (20Hz - 20kHz) is compared for the
+ * 			plain rounding and the noise shaping. The full scale sine must keep every duty inside 0 - period. Then both
+ * 			modes are timed. The host CPU is not the Cortex-M4, the numbers compare the modes.
+ *
+ * 			gcc -O2 -std=gnu99 -I inc host/pwm_modulator_benchmark.c src/pwm_modulator.c -lm -o pwm_modulator_benchmark
+ */
+
+#include "pwm_modulator.h"
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <math.h>
+#include <time.h>
+
+#define BENCHMARK_SAMPLE_RATE		44100.0
+#define BENCHMARK_CARRIER_RATE		(BENCHMARK_SAMPLE_RATE * PWM_MODULATOR_OVERSAMPLING)
+#define BENCHMARK_PERIOD			(uint32_t)952		//	168MHz / 176.4kHz
+#define BENCHMARK_FRAMES			(uint32_t)16384		//	Samples of one run, the carrier gets 4 times more
+#define BENCHMARK_POINTS			(BENCHMARK_FRAMES * PWM_MODULATOR_OVERSAMPLING)	//	Power of 2, the FFT length
+#define BENCHMARK_BAND_LOW			20.0
+#define BENCHMARK_BAND_HIGH			20000.0
+#define BENCHMARK_MIN_GAIN			15.0				//	The smallest in-band error reduction in dB, about 18 is measured
+#define BENCHMARK_PASSES			(uint32_t)200
+#define BENCHMARK_PI				3.14159265358979
+
+typedef struct
+{
+	const char*	name;
+	double		frequency;		/*< In Hz */
+	double		amplitude;		/*< Of the full scale */
+}benchmark_tone_t;
+
+static const benchmark_tone_t tones[] =
+{
+	{"1 kHz full scale",	1000.0,		1.0},
+	{"1 kHz -20 dBFS",		1000.0,		0.1},
+	{"5 kHz -6 dBFS",		5000.0,		0.5},
+	{"100 Hz -40 dBFS",		100.0,		0.01},
+};
+
+static uint32_t	words[BENCHMARK_FRAMES];
+static uint16_t	duties[BENCHMARK_POINTS];
+static double	real[BENCHMARK_POINTS];
+static double	imaginary[BENCHMARK_POINTS];
+
+static double Benchmark_Now_ns(void)
+{
+	struct timespec now;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return now.tv_sec * 1e9 + now.tv_nsec;
+}
+
+/**
+ * \brief The radix-2 FFT in place, the length is BENCHMARK_POINTS
+ */
+static void Benchmark_FFT(double* re, double* im)
+{
+	for(uint32_t i = 1, j = 0; i < BENCHMARK_POINTS; i++)
+	{
+		uint32_t bit = BENCHMARK_POINTS >> 1;
+
+		for(; j & bit; bit >>= 1)
+			j ^= bit;
+		j ^= bit;
+		if(i < j)
+		{
+			double t = re[i]; re[i] = re[j]; re[j] = t;
+			t = im[i]; im[i] = im[j]; im[j] = t;
+		}
+	}
+	for(uint32_t length = 2; length <= BENCHMARK_POINTS; length <<= 1)
+	{
+		double angle = -2 * BENCHMARK_PI / length;
+
+		for(uint32_t start = 0; start < BENCHMARK_POINTS; start += length)
+		{
+			for(uint32_t k = 0; k < length / 2; k++)
+			{
+				double w_re = cos(angle * k);
+				double w_im = sin(angle * k);
+				double t_re = re[start + k + length / 2] * w_re - im[start + k + length / 2] * w_im;
+				double t_im = re[start + k + length / 2] * w_im + im[start + k + length / 2] * w_re;
+
+				re[start + k + length / 2] = re[start + k] - t_re;
+				im[start + k + length / 2] = im[start + k] - t_im;
+				re[start + k] += t_re;
+				im[start + k] += t_im;
+			}
+		}
+	}
+}
+
+/**
+ * \brief This function fills the words with the tone, the same on both channels
+ */
+static void Benchmark_Fill(const benchmark_tone_t* tone)
+{
+	for(uint32_t i = 0; i < BENCHMARK_FRAMES; i++)
+	{
+		int32_t sample = (int32_t)lrint(32767 * tone->amplitude * sin(2 * BENCHMARK_PI * tone->frequency * i / BENCHMARK_SAMPLE_RATE));
+		uint32_t lane = (uint32_t)(sample + 32768);
+
+		words[i] = lane | (lane << 16);
+	}
+}
+
+/**
+ * \brief This function modulates the tone and measures the duty error in the audio band
+ *
+ * \param in_range[OUT]	-	false if any duty was outside 0 - period
+ *
+ * \return	the in-band error power in dB (of one duty step squared)
+ */
+static double Benchmark_In_Band_Error(bool noise_shaping, bool* in_range)
+{
+	double	scale = BENCHMARK_PERIOD - 2 * PWM_MODULATOR_GUARD_STEPS;
+	double	power = 0;
+	double	window_power = 0;
+
+	PWM_Modulator_Init(BENCHMARK_PERIOD);
+	PWM_Modulator_Set_Noise_Shaping(noise_shaping);
+	//	One run to settle the error feedback, the second one is measured
+	PWM_Modulator_Process(words, duties, BENCHMARK_FRAMES);
+	PWM_Modulator_Process(words, duties, BENCHMARK_FRAMES);
+
+	*in_range = true;
+	for(uint32_t n = 0; n < BENCHMARK_POINTS; n++)
+	{
+		//	The wanted level of the sample, the same (L + R) / 2 as the modulator
+		int32_t		left = (int32_t)(words[n / PWM_MODULATOR_OVERSAMPLING] & 0xFFFF) - 32768;
+		int32_t		right = (int32_t)(words[n / PWM_MODULATOR_OVERSAMPLING] >> 16) - 32768;
+		double		level = PWM_MODULATOR_GUARD_STEPS + (((left + right) >> 1) + 32768) * scale / 65536.0;
+		//	Hann window
+		double		window = 0.5 - 0.5 * cos(2 * BENCHMARK_PI * n / BENCHMARK_POINTS);
+
+		if(duties[n] > BENCHMARK_PERIOD)
+			*in_range = false;
+		real[n] = (duties[n] - level) * window;
+		imaginary[n] = 0;
+		window_power += window * window;
+	}
+
+	Benchmark_FFT(real, imaginary);
+	for(uint32_t bin = 1; bin < BENCHMARK_POINTS / 2; bin++)
+	{
+		double frequency = bin * BENCHMARK_CARRIER_RATE / BENCHMARK_POINTS;
+
+		if((frequency >= BENCHMARK_BAND_LOW) && (frequency <= BENCHMARK_BAND_HIGH))
+			power += 2 * (real[bin] * real[bin] + imaginary[bin] * imaginary[bin]);
+	}
+
+	return 10 * log10(power / (window_power * BENCHMARK_POINTS) + 1e-30);
+}
+
+int main(void)
+{
+	int failures = 0;
+
+	for(uint32_t t = 0; t < sizeof(tones) / sizeof(tones[0]); t++)
+	{
+		bool	rounding_in_range;
+		bool	shaped_in_range;
+		double	rounding;
+		double	shaped;
+		bool	ok;
+
+		Benchmark_Fill(&tones[t]);
+		rounding = Benchmark_In_Band_Error(false, &rounding_in_range);
+		shaped = Benchmark_In_Band_Error(true, &shaped_in_range);
+		ok = (rounding - shaped >= BENCHMARK_MIN_GAIN) && rounding_in_range && shaped_in_range;
+		if(!ok)
+			failures++;
+
+		printf("%-18s  in-band error  rounding %6.1f dB  shaped %6.1f dB  gain %5.1f dB  %s\n", tones[t].name, rounding, shaped,
+				rounding - shaped, ok ? "ok" : ((rounding_in_range && shaped_in_range) ? "GAIN TOO LOW" : "DUTY OUT OF RANGE"));
+	}
+
+	for(int mode = 0; mode < 2; mode++)
+	{
+		double time = 0;
+		double start;
+
+		PWM_Modulator_Init(BENCHMARK_PERIOD);
+		PWM_Modulator_Set_Noise_Shaping(mode != 0);
+		for(uint32_t pass = 0; pass < BENCHMARK_PASSES; pass++)
+		{
+			start = Benchmark_Now_ns();
+			PWM_Modulator_Process(words, duties, BENCHMARK_FRAMES);
+			time += Benchmark_Now_ns() - start;
+			__asm__ volatile("" : : "r"(duties) : "memory");
+		}
+		printf("%-8s  %5.2f ns per sample\n", mode ? "shaped" : "rounding", time / ((double)BENCHMARK_PASSES * BENCHMARK_FRAMES));
+	}
+
+	return failures ? 1 : 0;
+}
@@ -0,0 +1,338 @@
+/**
+ * NOTE:	The host check and benchmark of the software timers. soft_timer.c is built against host/stub/timebase.h and this
+ * 			program is its timebase: a simulated 64 bit microsecond clock and the one shot compare alarm on its lower 32
+ * 			bits, as TIM5 does it - the alarm set at the time which has already passed is pending at once, otherwise it
+ * 			comes when the lower 32 bits reach it. The alarm is called back only with the interrupts enabled and never
+ * 			nested, like the timebase interrupt.
+ * 			The stress test runs BENCHMARK_TIMERS timers through random starts (one shot and periodic, from 0 to the
+ * 			maximum timeout), restarts from their own callbacks, stops and time jumps over many counter wraps. Each timer
+ * 			must expire once per start (or once per period), never before its time and at most one tick later.
+ * 			The early expiry test restarts the timer from its callback which runs for many ticks, so the wheel is behind
+ * 			the clock when the timer is started. Then Soft_Timer_Start and Soft_Timer_Stop are timed with all the timers
+ * 			running. The host CPU is not the Cortex-M4, the numbers show the cost does not grow with the timer count.
+ *
+ * 			gcc -O2 -std=gnu99 -I host/stub -I inc host/soft_timer_benchmark.c src/soft_timer.c -o soft_timer_benchmark
+ */
+
+#include "soft_timer.h"
+#include "timebase.h"
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <time.h>
+
+#define BENCHMARK_TIMERS			(uint32_t)200
+#define BENCHMARK_STRESS_STEPS		(uint32_t)3000000
+#define BENCHMARK_EARLY_RESTARTS	(uint32_t)1000
+#define BENCHMARK_PASSES			(uint32_t)1000000
+#define BENCHMARK_TICK_US			((uint64_t)1 << SOFT_TIMER_TICK_SHIFT)
+
+typedef struct
+{
+	soft_timer_t	timer;
+	uint64_t		due_us;			/*< The time the timer has to expire at */
+	uint32_t		period_us;
+	bool			running;		/*< Started and not stopped or expired */
+}benchmark_timer_t;
+
+uint32_t						timebase_primask;
+
+static uint64_t					clock_us;
+static uint32_t					alarm_at_us;
+static bool						alarm_armed;
+static bool						alarm_pending;
+static bool						alarm_in_interrupt;
+static time_alarm_callback_f	alarm_callback;
+
+static benchmark_timer_t		timers[BENCHMARK_TIMERS];
+static uint32_t					random_state = 0xACE1;
+static uint64_t					expiries;
+static uint64_t					max_late_us;
+static uint32_t					errors;
+
+void Time_Init(void)
+{
+}
+
+uint64_t Time_Now_us64(void)
+{
+	return clock_us;
+}
+
+void Time_Alarm_Set(uint32_t at_us, time_alarm_callback_f callback)
+{
+	alarm_callback = callback;
+	alarm_at_us = at_us;
+	alarm_armed = true;
+	alarm_pending = Time_Is_Expired(at_us);
+}
+
+void Time_Alarm_Cancel(void)
+{
+	alarm_armed = false;
+	alarm_pending = false;
+}
+
+/**
+ * \brief This function takes the pending alarm as the timebase interrupt would: with the interrupts enabled and not nested
+ */
+static void Clock_Service(void)
+{
+	if(alarm_in_interrupt)
+		return;
+
+	while(alarm_armed && alarm_pending && (timebase_primask == 0))
+	{
+		alarm_armed = false;
+		alarm_pending = false;
+		alarm_in_interrupt = true;
+		alarm_callback();
+		alarm_in_interrupt = false;
+	}
+	if(timebase_primask)
+	{
+		printf("the interrupts are left disabled\n");
+		errors++;
+		timebase_primask = 0;
+	}
+}
+
+/**
+ * \brief This function moves the clock, the alarm is taken at its compare match
+ */
+static void Clock_Advance(uint64_t delay_us)
+{
+	while(delay_us)
+	{
+		uint64_t to_match = (uint32_t)(alarm_at_us - (uint32_t)clock_us);
+		uint64_t step = delay_us;
+
+		//	The match at the current time has been taken already, the next one is after the wrap
+		if(to_match == 0)
+			to_match = (uint64_t)1 << 32;
+		if(!alarm_armed || (step < to_match))
+		{
+			clock_us += step;
+			return;
+		}
+
+		clock_us += to_match;
+		delay_us -= to_match;
+		alarm_pending = true;
+		Clock_Service();
+	}
+}
+
+static uint32_t Benchmark_Random(void)
+{
+	random_state = random_state * 1103515245 + 12345;
+	return random_state >> 8;
+}
+
+static double Benchmark_Now_ns(void)
+{
+	struct timespec now;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return now.tv_sec * 1e9 + now.tv_nsec;
+}
+
+/**
+ * \brief The timeouts of all the ranges - the current tick, the wheel levels and beyond the wheel
+ */
+static uint32_t Benchmark_Random_Timeout(void)
+{
+	switch(Benchmark_Random() & 3)
+	{
+	case 0:
+		return Benchmark_Random() % 2000;
+	case 1:
+		return Benchmark_Random() % 200000;
+	case 2:
+		return Benchmark_Random() % 40000000;
+	default:
+		return (uint32_t)(((uint64_t)Benchmark_Random() << 8) % ((uint64_t)SOFT_TIMER_MAX_TIMEOUT_US + 1));
+	}
+}
+
+static void Benchmark_Start(benchmark_timer_t* timer, uint32_t timeout_us, uint32_t period_us)
+{
+	timer->due_us = clock_us + timeout_us;
+	timer->period_us = period_us;
+	timer->running = true;
+	Soft_Timer_Start(&timer->timer, timeout_us, period_us);
+}
+
+static void Stress_Callback(void* context)
+{
+	benchmark_timer_t*	timer = (benchmark_timer_t*)context;
+	uint64_t			late_us = clock_us - timer->due_us;
+
+	expiries++;
+	if(!timer->running || (clock_us < timer->due_us) || (late_us > BENCHMARK_TICK_US))
+	{
+		if(errors < 10)
+			printf("timer %u: %s, due %llu us, now %llu us\n", (unsigned)(timer - timers), !timer->running ? "not running" :
+					((clock_us < timer->due_us) ? "early" : "late"), (unsigned long long)timer->due_us, (unsigned long long)clock_us);
+		errors++;
+	}
+	else if(late_us > max_late_us)
+		max_late_us = late_us;
+
+	if(timer->period_us)
+		timer->due_us += timer->period_us;
+	else
+		timer->running = false;
+
+	//	Some timers are restarted from their callback
+	if(Benchmark_Random() % 7 == 0)
+		Benchmark_Start(timer, Benchmark_Random() % 5000, 0);
+}
+
+/**
+ * \brief This function runs the random starts, stops and time jumps
+ */
+static void Benchmark_Stress(void)
+{
+	Soft_Timer_Init();
+	for(uint32_t i = 0; i < BENCHMARK_TIMERS; i++)
+	{
+		Soft_Timer_Create(&timers[i].timer, Stress_Callback, &timers[i]);
+		timers[i].running = false;
+	}
+
+	for(uint32_t step = 0; step < BENCHMARK_STRESS_STEPS; step++)
+	{
+		benchmark_timer_t*	timer = &timers[Benchmark_Random() % BENCHMARK_TIMERS];
+		uint32_t			operation = Benchmark_Random() % 10;
+		uint32_t			range_us;
+
+		if(operation < 3)
+		{
+			uint32_t period_us = (Benchmark_Random() % 5 == 0) ? (uint32_t)(BENCHMARK_TICK_US + Benchmark_Random() % 300000) : 0;
+
+			Benchmark_Start(timer, Benchmark_Random_Timeout(), period_us);
+			Clock_Service();
+		}
+		else if(operation < 4)
+		{
+			Soft_Timer_Stop(&timer->timer);
+			timer->running = false;
+		}
+		//	Mostly short steps, sometimes the jumps of up to ~50s
+		range_us = (Benchmark_Random() % 100 == 0) ? 50000000 : 3000;
+		Clock_Advance(Benchmark_Random() % range_us);
+
+		//	No running timer may be overdue
+		for(uint32_t i = 0; (step % 1000 == 0) && (i < BENCHMARK_TIMERS); i++)
+		{
+			if(timers[i].running != Soft_Timer_Is_Running(&timers[i].timer) || (timers[i].running && (clock_us > timers[i].due_us + BENCHMARK_TICK_US)))
+			{
+				if(errors < 10)
+					printf("timer %u: overdue or in the wrong state at %llu us\n", (unsigned)i, (unsigned long long)clock_us);
+				errors++;
+			}
+		}
+	}
+
+	for(uint32_t i = 0; i < BENCHMARK_TIMERS; i++)
+		Soft_Timer_Stop(&timers[i].timer);
+}
+
+static uint32_t early_expiries;
+static uint32_t early_restarts;
+
+static void Early_Callback(void* context)
+{
+	benchmark_timer_t*	timer = (benchmark_timer_t*)context;
+	uint64_t			busy_us;
+	uint32_t			timeout_us;
+
+	if(clock_us < timer->due_us)
+	{
+		if(early_expiries < 10)
+			printf("early by %llu us\n", (unsigned long long)(timer->due_us - clock_us));
+		early_expiries++;
+	}
+	if(++early_restarts > BENCHMARK_EARLY_RESTARTS)
+		return;
+
+	//	The callback runs for 20 - 31 ticks, the wheel stays at the tick of the expiry meanwhile
+	busy_us = (20 + Benchmark_Random() % 12) * BENCHMARK_TICK_US;
+	Clock_Advance(busy_us + Benchmark_Random() % BENCHMARK_TICK_US);
+	timeout_us = (uint32_t)((1 + Benchmark_Random() % 8) * BENCHMARK_TICK_US);
+	timeout_us -= Benchmark_Random() % BENCHMARK_TICK_US;
+	Benchmark_Start(timer, timeout_us, 0);
+}
+
+/**
+ * \brief This function restarts the timer from its long callback
+ */
+static void Benchmark_Early(void)
+{
+	Soft_Timer_Init();
+	Soft_Timer_Create(&timers[0].timer, Early_Callback, &timers[0]);
+	Benchmark_Start(&timers[0], 5000, 0);
+	Clock_Service();
+
+	for(uint32_t i = 0; (i < 100 * BENCHMARK_EARLY_RESTARTS) && (early_restarts <= BENCHMARK_EARLY_RESTARTS); i++)
+		Clock_Advance(100);
+
+	if(early_restarts <= BENCHMARK_EARLY_RESTARTS)
+	{
+		printf("the timer stopped after %u restarts\n", (unsigned)early_restarts);
+		errors++;
+	}
+	errors += early_expiries;
+}
+
+static void Timing_Callback(void* context)
+{
+	(void)context;
+}
+
+/**
+ * \brief This function times the restart and the stop with all the timers running
+ *
+ * \return	ns per Soft_Timer_Start and Soft_Timer_Stop pair
+ */
+static double Benchmark_Time(void)
+{
+	double start;
+
+	Soft_Timer_Init();
+	for(uint32_t i = 0; i < BENCHMARK_TIMERS; i++)
+	{
+		Soft_Timer_Create(&timers[i].timer, Timing_Callback, NULL);
+		Soft_Timer_Start(&timers[i].timer, Benchmark_Random_Timeout() + 1000, 0);
+	}
+
+	start = Benchmark_Now_ns();
+	for(uint32_t pass = 0; pass < BENCHMARK_PASSES; pass++)
+	{
+		soft_timer_t* timer = &timers[pass % BENCHMARK_TIMERS].timer;
+
+		Soft_Timer_Stop(timer);
+		Soft_Timer_Start(timer, 1000 + (pass & 0xFFFFF), 0);
+	}
+
+	return (Benchmark_Now_ns() - start) / BENCHMARK_PASSES;
+}
+
+int main(void)
+{
+	double time;
+
+	Benchmark_Stress();
+	printf("stress: %llu expiries in %.1f simulated hours (%llu counter wraps), latest %llu us after the due time\n",
+			(unsigned long long)expiries, clock_us / 3.6e9, (unsigned long long)(clock_us >> 32), (unsigned long long)max_late_us);
+
+	Benchmark_Early();
+	printf("restart from the long callback: %u restarts, %u early expiries\n", (unsigned)(early_restarts - 1), (unsigned)early_expiries);
+
+	time = Benchmark_Time();
+	printf("stop and start with %u timers running: %.1f ns\n", (unsigned)BENCHMARK_TIMERS, time);
+
+	printf("%s\n", errors ? "FAILED" : "ok");
+	return errors ? 1 : 0;
+}
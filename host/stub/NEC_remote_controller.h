@@ -0,0 +1,19 @@
+#ifndef NEC_REMOTE_CONTROLLER_H_INCLUDED
+#define NEC_REMOTE_CONTROLLER_H_INCLUDED
+
+/**
+ * NOTE:	The host stand-in of inc/NEC_remote_controller.h for the host programs: only the command list, which the audio
+ * 			stages compare with, without the GPIO, EXTI and timer part. host/stub is given before inc on the gcc command line.
+ */
+
+//  List of commands
+#define NEC_CH_MINUS                                  186
+#define NEC_CH                                 	      185
+#define NEC_CH_PLUS                                   184
+#define NEC_PREV                                 	  187
+#define NEC_NEXT                                      191
+#define NEC_PLAY_PAUSE                                188
+#define NEC_VOL_MINUS                                 248
+#define NEC_VOL_PLUS                                  234
+
+#endif /* NEC_REMOTE_CONTROLLER_H_INCLUDED */
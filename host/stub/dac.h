@@ -0,0 +1,17 @@
+#ifndef INC_DAC_H_
+#define INC_DAC_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/**
+ * NOTE:	The host stand-in of inc/dac.h for the host programs: only the playback block size, the silence and the refill
+ * 			function type, which the audio stages use, without the DAC, TIM6 and DMA registers.
+ */
+
+#define DAC_PLAYBACK_HALF_BUFFER_SAMPLES	(uint32_t)512	//	Samples refilled in one interrupt
+#define DAC_PLAYBACK_SILENCE				(uint16_t)0x8000	//	The middle of the range, left aligned
+
+typedef uint32_t (*dac_playback_refill_f)(void* buffer, uint32_t samples);
+
+#endif /* INC_DAC_H_ */
@@ -0,0 +1,94 @@
+#ifndef INC_TIMEBASE_H_
+#define INC_TIMEBASE_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/**
+ * NOTE:	The host stand-in of inc/timebase.h for the host programs: the time and the alarm functions are only declared,
+ * 			the program defines them over its simulated clock, without TIM5 and the NVIC. The CMSIS intrinsics used by the
+ * 			drivers are the C versions below, the interrupt mask is timebase_primask, which the program defines too and
+ * 			checks before it calls the alarm back.
+ */
+
+/**
+ * The function called from the timebase interrupt when the alarm time comes.
+ */
+typedef void (*time_alarm_callback_f)(void);
+
+extern uint32_t timebase_primask;		/*< 1 - the interrupts are disabled */
+
+void		Time_Init(void);
+uint64_t	Time_Now_us64(void);
+void		Time_Alarm_Set(uint32_t at_us, time_alarm_callback_f callback);
+void		Time_Alarm_Cancel(void);
+
+/**
+ * \brief	Returns the lower 32 bits of the time since Time_Init.
+ */
+static inline uint32_t Time_Now_us(void)
+{
+	return (uint32_t)Time_Now_us64();
+}
+
+/**
+ * \brief	Wrap-safe comparison of two timestamps.
+ * \return	true if the time a_us is later than b_us
+ */
+static inline bool Time_Is_After(uint32_t a_us, uint32_t b_us)
+{
+	return (int32_t)(a_us - b_us) > 0;
+}
+
+/**
+ * \brief	Wrap-safe comparison of two timestamps.
+ * \return	true if the time a_us is earlier than b_us
+ */
+static inline bool Time_Is_Before(uint32_t a_us, uint32_t b_us)
+{
+	return (int32_t)(a_us - b_us) < 0;
+}
+
+/**
+ * \brief	Checks if the deadline has passed.
+ */
+static inline bool Time_Is_Expired(uint32_t deadline_us)
+{
+	return (int32_t)(Time_Now_us() - deadline_us) >= 0;
+}
+
+static inline uint32_t __get_PRIMASK(void)
+{
+	return timebase_primask;
+}
+
+static inline void __set_PRIMASK(uint32_t primask)
+{
+	timebase_primask = primask;
+}
+
+static inline void __disable_irq(void)
+{
+	timebase_primask = 1;
+}
+
+static inline void __enable_irq(void)
+{
+	timebase_primask = 0;
+}
+
+static inline uint32_t __CLZ(uint32_t value)
+{
+	return value ? (uint32_t)__builtin_clz(value) : 32;
+}
+
+static inline uint32_t __RBIT(uint32_t value)
+{
+	uint32_t result = 0;
+
+	for(uint8_t i = 0; i < 32; i++, value >>= 1)
+		result = (result << 1) | (value & 1);
+	return result;
+}
+
+#endif /* INC_TIMEBASE_H_ */
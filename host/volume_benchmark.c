@@ -0,0 +1,143 @@
+/**
+ * NOTE:	The host check and benchmark of the volume stage. volume.c is built with the C reference versions of the DSP
+ * 			instructions (dsp.h without __ARM_FEATURE_DSP). Every 16 bit sample value goes through Volume_Process() at every
+ * 			volume step and through the ramps between the steps, in both lanes, and is compared with the plain per sample
+ * 			product. The output must never be further from the middle of the range than the input or on its other side,
+ * 			which is what a wrapped lane would give. Then the ramp is timed on blocks of 256 frames, like Volume_Benchmark().
+ * 			The host CPU is not the Cortex-M4, VOLUME_CYCLE_BUDGET is checked by Volume_Benchmark() on the target.
+ *
+ * 			gcc -O2 -std=gnu99 -I host/stub -I inc host/volume_benchmark.c src/volume.c -lm -o volume_benchmark
+ */
+
+#include "volume.h"
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <math.h>
+#include <time.h>
+
+#define BENCHMARK_FRAMES		(uint32_t)65536		//	Every lane value once
+#define BENCHMARK_BLOCK			(uint32_t)256
+#define BENCHMARK_PASSES		(uint32_t)200
+
+static uint32_t	words[BENCHMARK_FRAMES];
+
+static double Benchmark_Now_ns(void)
+{
+	struct timespec now;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return now.tv_sec * 1e9 + now.tv_nsec;
+}
+
+/**
+ * \brief The Q15 gain of the step, 2dB apart, the step 0 is mute
+ */
+static int32_t Reference_Gain(uint8_t step)
+{
+	return (step == 0) ? 0 : (int32_t)lround(32767 * pow(10, -(VOLUME_STEPS - 1 - step) / 10.0));
+}
+
+/**
+ * \brief The unsigned 16 bit sample scaled by the Q15 gain around the middle of the range
+ */
+static uint32_t Reference_Scale(uint32_t sample, int32_t gain)
+{
+	int32_t signed_sample = (int32_t)sample - 32768;
+
+	return (uint32_t)(((signed_sample * gain) >> 15) + 32768);
+}
+
+/**
+ * \brief This function fills the block with every lane value, the right channel runs the other way
+ */
+static void Benchmark_Fill(void)
+{
+	for(uint32_t i = 0; i < BENCHMARK_FRAMES; i++)
+		words[i] = i | ((65535 - i) << 16);
+}
+
+/**
+ * \brief This function checks one lane of the output
+ *
+ * \return	true if the lane is the reference and did not wrap
+ */
+static bool Benchmark_Check_Lane(uint32_t input, uint32_t output, int32_t gain)
+{
+	int32_t in = (int32_t)input - 32768;
+	int32_t out = (int32_t)output - 32768;
+
+	if(output != Reference_Scale(input, gain))
+		return false;
+	//	The same side of the middle and not louder
+	return ((in >= 0) ? ((out >= 0) && (out <= in)) : ((out <= 0) && (out >= in)));
+}
+
+/**
+ * \brief This function processes the whole block in BENCHMARK_BLOCK parts from the step from to the step to and checks it.
+ * 			The ramp takes the first part, the gain of its frame i is the one of Volume_Process().
+ *
+ * \return	the number of the wrong lanes
+ */
+static uint32_t Benchmark_Check(uint8_t from, uint8_t to)
+{
+	int32_t		from_gain = Reference_Gain(from);
+	int32_t		to_gain = Reference_Gain(to);
+	int32_t		step = ((to_gain - from_gain) * 65536) / (int32_t)BENCHMARK_BLOCK;
+	uint32_t	wrong = 0;
+
+	//	The gain of the step from is reached with one block
+	Volume_Set_Step(from);
+	Benchmark_Fill();
+	Volume_Process(words, BENCHMARK_BLOCK);
+
+	Benchmark_Fill();
+	Volume_Set_Step(to);
+	for(uint32_t block = 0; block < BENCHMARK_FRAMES; block += BENCHMARK_BLOCK)
+		Volume_Process(words + block, BENCHMARK_BLOCK);
+
+	for(uint32_t i = 0; i < BENCHMARK_FRAMES; i++)
+	{
+		int32_t gain = (i < BENCHMARK_BLOCK) ? ((from_gain * 65536 + (int32_t)(i + 1) * step) >> 16) : to_gain;
+
+		//	At 0dB without the ramp the block is not touched
+		if(((from == to) || (i >= BENCHMARK_BLOCK)) && (gain == VOLUME_UNITY_GAIN))
+			gain = 32768;
+		if(!Benchmark_Check_Lane(i, words[i] & 0xFFFF, gain))
+			wrong++;
+		if(!Benchmark_Check_Lane(65535 - i, words[i] >> 16, gain))
+			wrong++;
+	}
+
+	return wrong;
+}
+
+int main(void)
+{
+	uint32_t	wrong = 0;
+	double		time = 0;
+	double		start;
+
+	for(uint8_t from = 0; from < VOLUME_STEPS; from++)
+	{
+		for(uint8_t to = 0; to < VOLUME_STEPS; to++)
+			wrong += Benchmark_Check(from, to);
+	}
+	printf("%u steps, %u ramps of every lane value: %u wrong lanes\n", VOLUME_STEPS, VOLUME_STEPS * VOLUME_STEPS, wrong);
+
+	//	Every block is a ramp
+	for(uint32_t pass = 0; pass < BENCHMARK_PASSES; pass++)
+	{
+		Benchmark_Fill();
+		start = Benchmark_Now_ns();
+		for(uint32_t block = 0; block < BENCHMARK_FRAMES; block += BENCHMARK_BLOCK)
+		{
+			Volume_Set_Step((block / BENCHMARK_BLOCK) & 1 ? VOLUME_STEPS - 1 : VOLUME_STEPS / 2);
+			Volume_Process(words + block, BENCHMARK_BLOCK);
+		}
+		time += Benchmark_Now_ns() - start;
+	}
+	printf("ramp  %5.2f ns per stereo frame\n", time / ((double)BENCHMARK_FRAMES * BENCHMARK_PASSES));
+
+	return wrong ? 1 : 0;
+}
@@ -38,6 +38,8 @@
 #define	LCD_CURSOR_HOME										(char)0b00000010
 #define LCD_ENTRY_MODE_UP									(char)0b00000110
 #define LCD_GOTO_COMMAND									(char)0b10000000
+#define LCD_SET_CGRAM_ADDRESS								(char)0b01000000
+#define LCD_CUSTOM_CHARACTERS								(unsigned char)8	//	Character codes 0 to 7
 
 
 void 			LCD_Config(void);
@@ -45,5 +47,6 @@ void 			LCD_WriteData(char data);
 void 			LCD_WriteCommand(char command);
 void 			LCD_WriteText(char* text);
 void 			LCD_GoTo(unsigned char line, unsigned char position);
+void 			LCD_Define_Character(unsigned char code, const char* rows);
 
 #endif /* HD44780_H_ */
@@ -16,8 +16,8 @@
 //  **********************************************************
 #define NEC_GPIO_PORT                       GPIOA          //*
 #define NEC_GPIO_PIN                        PIN_10         //*
-#define NEC_TIMERx                          TIM6           //*
-#define NEC_TIMERx_PERIOD					TIM6_PERIOD	   //*
+#define NEC_TIMERx                          TIM7           //*	TIM6 paces the DAC playback
+#define NEC_TIMERx_PERIOD					TIM7_PERIOD	   //*
 #define NEC_EXTI                            EXTI_LINE_10   //*
 #define NEC_EXTI_IRQn                       EXTI15_10_IRQn //*
 #define NEC_PRIOR                          	0            //*
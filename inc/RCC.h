@@ -34,8 +34,12 @@
     #define APB2 CPU_FREQ/1
 #endif
 
+//	The input of the PLL and the PLLI2S (HSE / PLLM)
+#define RCC_PLL_INPUT_FREQ_HZ	(uint32_t)(CRYSTAL_FREQ*1000000/RCC_PLLM)
+
 //void ResetRCC(void);
 void RCC_SetClockFrequency(uint32_t PLLM, uint32_t PLLN, uint32_t PLLQ, uint32_t PLLP);
+void RCC_SetI2SClockFrequency(uint32_t PLLI2SN, uint32_t PLLI2SR);
 
 #endif /* RCC_H_ */
 
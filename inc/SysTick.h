@@ -11,14 +11,25 @@
 #include "RCC.h"
 #include <stdbool.h>
 
-extern uint32_t 			systick_delay;
+/**
+ * NOTE:	The delays are tickless - SysTick counts the core clock and is loaded once with the whole delay, so there is
+ * 			one interrupt at its end (one per SYSTICK_MAX_LOAD cycles, ~99.8ms, for the longer delays). Between the delays
+ * 			SysTick is stopped. The waits shorter than SYSTICK_SPIN_CYCLES spin on the DWT cycle counter, the sleep and the
+ * 			interrupt would be a large part of them.
+ * 			SysTick must not be configured with SysTick_Config, the delay programs it itself.
+ */
+
+extern volatile uint64_t	systick_delay;
 extern volatile bool		systick_delay_completed;
 
-#define SYSTICK_CLK_DIVIDER			(uint32_t)(CPU_FREQ)
-#define SYSTICK_FREQ				(uint32_t)(CPU_FREQ*1000000/SYSTICK_CLK_DIVIDER)
+#define SYSTICK_FREQ				(uint32_t)1000000				//	The unit of SysTick_Delay - 1us
 #define SYSTICK_US_TO_TICKS(x) 		(uint32_t)(x*0.000001/(1.0/SYSTICK_FREQ))
+#define SYSTICK_CYCLES_PER_US		(uint32_t)CPU_FREQ
+#define SYSTICK_MAX_LOAD			(uint32_t)0x01000000			//	The 24 bit counter range
+#define SYSTICK_SPIN_CYCLES			(uint32_t)(10*CPU_FREQ)			//	10us
 
 void SysTick_Delay(uint32_t delay_us);
+void SysTick_Delay_Cycles(uint32_t cycles);
 void SysTick_Handler(void);
 
 #endif /* INC_SYSTICK_H_ */
@@ -0,0 +1,49 @@
+#ifndef INC_ADC_H_
+#define INC_ADC_H_
+
+#include "stm32f4xx.h"
+#include <stdbool.h>
+
+/**
+ * NOTE:	The ADC capture is the input side of the playback engines: ADC_CAPTURE_TIMER TRGO starts one scan of the
+ * 			regular sequence every sample period and the DMA moves the conversions to the circular ping-pong buffer,
+ * 			so no interrupt per sample is needed. The half and complete transfer interrupts give the finished half to
+ * 			the callback, which has to take the data before the DMA comes back to it (the time of one half).
+ * 			TIM6 and TIM7 can not trigger the ADC on the F4, so the trigger is TIM3 (EXTSEL 1000). TIM2 and TIM5 are
+ * 			left free for the 32 bit timers.
+ * 			The sequence can hold the pins PA0-PA7 (channels 0-7), PB0-PB1 (8-9), PC0-PC5 (10-15) and the internal
+ * 			temperature sensor (16), Vrefint (17) and Vbat (18), so the same driver serves the microphone and the sensor logging.
+ */
+
+#define ADC_CAPTURE_ADC						ADC1
+#define ADC_CAPTURE_TIMER					TIM3			//	The timer which TRGO triggers the sequence
+#define ADC_CAPTURE_TIMER_CLOCK_HZ			(uint32_t)(2*APB1*1000000)
+#define ADC_CAPTURE_TIMER_TRIGGER			(uint32_t)8		//	EXTSEL value of TIM3 TRGO
+#define ADC_CAPTURE_DMA						DMA2
+#define ADC_CAPTURE_DMA_STREAM				DMA2_Stream0	//	ADC1 is mapped to DMA2 stream 0 channel 0
+#define ADC_CAPTURE_DMA_CHANNEL				(uint32_t)0
+#define ADC_CAPTURE_DMA_IRQn				DMA2_Stream0_IRQn
+#define ADC_CAPTURE_HALF_BUFFER_SAMPLES		(uint32_t)512	//	Conversions given to the callback at once, rounded down to whole frames
+#define ADC_CAPTURE_MAX_CHANNELS			(uint8_t)6		//	The length of the sequence kept in SQR3
+#define ADC_CAPTURE_SAMPLE_TIME				(uint32_t)4		//	84 ADC clocks, 4us at 21MHz, for the sources up to ~50kOhm
+
+#define ADC_CHANNEL_TEMPERATURE				(uint8_t)16
+#define ADC_CHANNEL_VREFINT					(uint8_t)17
+#define ADC_CHANNEL_VBAT					(uint8_t)18
+
+/**
+ * The function which takes the finished half of the capture buffer. It is called from the DMA interrupt.
+ *
+ * \param samples	-	the right aligned 12 bit conversions, interleaved in the sequence order
+ * \param frames	-	the number of the sequences in the half
+ */
+typedef void (*adc_capture_callback_f)(const uint16_t* samples, uint32_t frames);
+
+uint32_t	ADC_Capture_Init(uint32_t sample_rate_hz, const uint8_t* channels, uint8_t channel_count, adc_capture_callback_f callback);
+void		ADC_Capture_Start(void);
+void		ADC_Capture_Stop(void);
+uint32_t	ADC_Capture_Get_Overruns(void);
+void		DMA2_Stream0_IRQHandler(void);
+void		ADC_IRQHandler(void);
+
+#endif /* INC_ADC_H_ */
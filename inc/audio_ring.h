@@ -0,0 +1,30 @@
+#ifndef _AUDIO_RING_H_
+#define _AUDIO_RING_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/**
+ * NOTE:	The audio ring is a single producer / single consumer byte queue for PCM data. The producer (SD card streaming)
+ * 			moves only the write_index and the consumer (output refill interrupt) moves only the read_index, so no
+ * 			interrupt locking is needed. Both indices run freely and are wrapped with the mask, therefore the buffer size
+ * 			MUST be a power of 2.
+ */
+
+typedef struct
+{
+	uint8_t*				buffer;
+	uint32_t				buffer_size;
+	uint32_t				index_mask;
+	volatile uint32_t		write_index;
+	volatile uint32_t		read_index;
+}audio_ring_t;
+
+bool		Audio_Ring_Init(audio_ring_t* ring, uint8_t* buffer, uint32_t buffer_size);
+void		Audio_Ring_Clear(audio_ring_t* ring);
+uint32_t	Audio_Ring_Get_Data_Size(audio_ring_t* ring);
+uint32_t	Audio_Ring_Get_Free_Space(audio_ring_t* ring);
+uint32_t	Audio_Ring_Put(audio_ring_t* ring, const uint8_t* data, uint32_t data_size);
+uint32_t	Audio_Ring_Get(audio_ring_t* ring, uint8_t* data, uint32_t data_size);
+
+#endif
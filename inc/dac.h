@@ -11,6 +11,25 @@
 #include "stm32f4xx.h"
 #include <stdbool.h>
 
+#define DAC_PLAYBACK_TIMER					TIM6			//	The timer which TRGO triggers the conversions
+#define DAC_PLAYBACK_TIMER_CLOCK_HZ			(uint32_t)(2*APB1*1000000)
+#define DAC_PLAYBACK_DMA_STREAM				DMA1_Stream5	//	DAC channel 1 request is mapped to DMA1 stream 5 channel 7
+#define DAC_PLAYBACK_DMA_CHANNEL			(uint32_t)7
+#define DAC_PLAYBACK_DMA_IRQn				DMA1_Stream5_IRQn
+#define DAC_PLAYBACK_HALF_BUFFER_SAMPLES	(uint32_t)512	//	Samples refilled in one interrupt
+#define DAC_PLAYBACK_SILENCE				(uint16_t)0x8000	//	The middle of the range, left aligned
+
+/**
+ * The function which refills a half of the playback buffer. The samples are left aligned 16 bit values, the DAC converts
+ * the upper 12 bits and ignores the lower 4 (they are left for the dither). For stereo they are packed as channel 1
+ * in bits [15:0] and channel 2 in bits [31:16] (DHR12LD layout).
+ *
+ * \param buffer	-	the half of the buffer to fill, uint16_t samples for mono or uint32_t samples for stereo
+ * \param samples	-	the number of the samples to put in the buffer
+ *
+ * \return	the number of the samples put, the rest of the half is filled with silence
+ */
+typedef uint32_t (*dac_playback_refill_f)(void* buffer, uint32_t samples);
 
 typedef enum
 {
@@ -38,6 +57,13 @@ typedef enum
 	dac_trigger_software
 }dac_trigger_source_e;
 
+typedef enum
+{
+	dac_wave_none,
+	dac_wave_noise,				//	The LFSR output is added to DHR on every trigger
+	dac_wave_triangle			//	The up-down counter is added to DHR on every trigger
+}dac_wave_e;
+
 void DAC_DeInit(void);
 void DAC_Init(uint8_t conv_trig_sel, dac_channels_conf_e channel_conf, bool output_buffer_used);
 void DAC_Put_Data_Single_8bit(uint8_t data);
@@ -46,6 +72,13 @@ void DAC_Put_Data_Single_12bit_L(uint16_t data);
 void DAC_Put_Data_Dual_12bit_R(uint32_t data);
 void DAC_Put_Data_Dual_12bit_L(uint32_t data);
 void DAC_Put_Data_Dual_8bit(uint16_t data);
+void DAC_Set_Wave(dac_channels_conf_e channel_conf, dac_wave_e wave, uint8_t amplitude_bits);
+
+void DAC_Playback_Init(uint32_t sample_rate_hz, bool stereo, dac_playback_refill_f refill);
+void DAC_Playback_Set_Sample_Rate(uint32_t sample_rate_hz);
+void DAC_Playback_Start(void);
+void DAC_Playback_Stop(void);
+void DMA1_Stream5_IRQHandler(void);
 
 
 
@@ -0,0 +1,46 @@
+#ifndef _DDS_H_
+#define _DDS_H_
+
+#include "dac.h"
+#include <stdint.h>
+#include <stdbool.h>
+
+/**
+ * NOTE:	The DDS generator is the test signal source of the DAC playback: it is the refill function of the DAC
+ * 			ping-pong buffer, so the samples are computed a block at a time in the DMA interrupt. The 32 bit phase
+ * 			accumulator advances by the frequency word every sample, its top DDS_TABLE_BITS bits select the wavetable
+ * 			entry and the next DDS_FRACTION_BITS bits interpolate linearly to the next one, so one table serves every
+ * 			frequency with the error below 1 LSB of the DAC. The tables have one guard entry (equal to the first one)
+ * 			for the interpolation. The square and the triangle tables are not band limited, they alias above ~1kHz.
+ * 			The frequency word may be swept linearly or exponentially (the same time per octave), sample by sample.
+ * 			The DAC can also make the noise and the triangle by itself (DAC_CR WAVE bits), then no CPU time is used at all.
+ */
+
+#define DDS_TABLE_BITS				(uint8_t)8
+#define DDS_TABLE_SIZE				(uint32_t)(1 << DDS_TABLE_BITS)
+#define DDS_FRACTION_BITS			(uint8_t)15
+#define DDS_FULL_SCALE				(int16_t)32767
+#define DDS_CYCLE_BUDGET			(uint32_t)20		//	Max. CPU cycles per stereo frame, during the sweep
+#define DDS_BENCHMARK_FRAMES		(uint32_t)256
+
+typedef enum
+{
+	DDS_WAVE_SINE,
+	DDS_WAVE_SQUARE,
+	DDS_WAVE_TRIANGLE,
+	DDS_WAVE_ARBITRARY				//	The table given to Dds_Set_Wavetable()
+}dds_wave_e;
+
+void		Dds_Start(uint32_t sample_rate_hz);
+void		Dds_Stop(void);
+void		Dds_Set_Wave(dds_wave_e wave);
+void		Dds_Set_Wavetable(const int16_t* table);
+void		Dds_Set_Frequency(uint32_t frequency_hz);
+void		Dds_Set_Amplitude(int16_t amplitude);
+void		Dds_Sweep(uint32_t start_hz, uint32_t end_hz, uint32_t duration_ms, bool exponential);
+bool		Dds_Is_Sweeping(void);
+uint32_t	Dds_Start_Hardware(dac_wave_e wave, uint8_t amplitude_bits, uint32_t frequency_hz);
+uint32_t	Dds_Refill(void* buffer, uint32_t frames);
+uint32_t	Dds_Benchmark(void);
+
+#endif
@@ -0,0 +1,32 @@
+#ifndef _DITHER_H_
+#define _DITHER_H_
+
+#include <stdint.h>
+
+/**
+ * NOTE:	The dither stage works on the DAC words (DHR12LD layout) in the DAC refill interrupt, after the volume. The DAC
+ * 			drops the lower 4 bits of the 16 bit samples - without the dither it is the truncation, which error follows the
+ * 			signal and is heard as the distortion. The stage adds the TPDF noise of +-1 DAC step (two uniform values from
+ * 			the xorshift LFSR) and rounds to 12 bits, so the error is the constant white noise. The error feedback of the
+ * 			first or the second order moves that noise up to the high frequencies, where it is heard less. Both channels
+ * 			are processed at once in the 16 bit lanes.
+ */
+
+#define DITHER_DEFAULT_MODE			DITHER_MODE_TPDF
+#define DITHER_CYCLE_BUDGET			(uint32_t)20	//	Max. CPU cycles per stereo frame
+#define DITHER_BENCHMARK_FRAMES		(uint32_t)256
+
+typedef enum
+{
+	DITHER_MODE_OFF,				//	The truncation by the DAC
+	DITHER_MODE_TPDF,				//	TPDF dither, flat noise
+	DITHER_MODE_TPDF_SHAPED_1,		//	TPDF dither with the first order noise shaping (1 - z^-1)
+	DITHER_MODE_TPDF_SHAPED_2		//	TPDF dither with the second order noise shaping (1 - z^-1)^2
+}dither_mode_e;
+
+void			Dither_Set_Mode(dither_mode_e mode);
+dither_mode_e	Dither_Get_Mode(void);
+void			Dither_Process(uint32_t* words, uint32_t frames);
+uint32_t		Dither_Benchmark(dither_mode_e mode);
+
+#endif
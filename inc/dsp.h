@@ -0,0 +1,270 @@
+#ifndef _DSP_H_
+#define _DSP_H_
+
+#include <stdint.h>
+#include <string.h>
+
+/**
+ * NOTE:	The Cortex-M4 DSP instructions used by the audio processing. On the target they map to the CMSIS intrinsics,
+ * 			on the host (when __ARM_FEATURE_DSP is not defined) the plain C reference versions are compiled instead,
+ * 			so the audio modules can be checked on a PC and give the same results.
+ */
+
+#if defined(__ARM_FEATURE_DSP) && (__ARM_FEATURE_DSP == 1)
+
+#include "stm32f4xx.h"
+
+#define Dsp_Smlad(x, y, acc)			(int32_t)__SMLAD((x), (y), (uint32_t)(acc))
+#define Dsp_Saturate_Q15(value)			(int16_t)__SSAT((value), 16)
+#define Dsp_Sadd16(x, y)				__SADD16((x), (y))
+#define Dsp_Shadd16(x, y)				__SHADD16((x), (y))
+#define Dsp_Uxtb16(x)					__UXTB16(x)
+#define Dsp_Pkhbt(x, y, shift)			__PKHBT((x), (y), (shift))
+#define Dsp_Pkhtb(x, y, shift)			__PKHTB((x), (y), (shift))
+#define Dsp_Ssub16(x, y)				__SSUB16((x), (y))
+#define Dsp_Qadd16(x, y)				__QADD16((x), (y))
+#define Dsp_Qsub16(x, y)				__QSUB16((x), (y))
+#define Dsp_Shsub16(x, y)				__SHSUB16((x), (y))
+#define Dsp_Shasx(x, y)					__SHASX((x), (y))
+#define Dsp_Shsax(x, y)					__SHSAX((x), (y))
+#define Dsp_Smuad(x, y)					(int32_t)__SMUAD((x), (y))
+#define Dsp_Smuadx(x, y)				(int32_t)__SMUADX((x), (y))
+#define Dsp_Smusd(x, y)					(int32_t)__SMUSD((x), (y))
+
+/**
+ * \brief SMLAWB - acc + ((a * b[15:0]) >> 16). CMSIS has no intrinsic for it.
+ */
+static inline int32_t Dsp_Smlawb(int32_t a, int32_t b, int32_t acc)
+{
+	int32_t result;
+
+	__asm ("smlawb %0, %1, %2, %3" : "=r" (result) : "r" (a), "r" (b), "r" (acc));
+	return result;
+}
+
+/**
+ * \brief SMULBB - x[15:0] * y[15:0]. CMSIS has no intrinsic for it.
+ */
+static inline int32_t Dsp_Smulbb(uint32_t x, uint32_t y)
+{
+	int32_t result;
+
+	__asm ("smulbb %0, %1, %2" : "=r" (result) : "r" (x), "r" (y));
+	return result;
+}
+
+/**
+ * \brief SMULTB - x[31:16] * y[15:0]. CMSIS has no intrinsic for it.
+ */
+static inline int32_t Dsp_Smultb(uint32_t x, uint32_t y)
+{
+	int32_t result;
+
+	__asm ("smultb %0, %1, %2" : "=r" (result) : "r" (x), "r" (y));
+	return result;
+}
+
+/**
+ * \brief This function turns on the DWT cycle counter (DWT->CYCCNT) for the benchmarks and the short waits
+ */
+static inline void Dsp_Enable_Cycle_Counter(void)
+{
+	CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+	DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+}
+
+#else
+
+/**
+ * \brief SMLAD - acc + x[15:0] * y[15:0] + x[31:16] * y[31:16]
+ */
+static inline int32_t Dsp_Smlad(uint32_t x, uint32_t y, int32_t acc)
+{
+	return acc + (int16_t)x * (int16_t)y + (int16_t)(x >> 16) * (int16_t)(y >> 16);
+}
+
+/**
+ * \brief SSAT #16
+ */
+static inline int16_t Dsp_Saturate_Q15(int32_t value)
+{
+	return (int16_t)((value > 32767) ? 32767 : ((value < -32768) ? -32768 : value));
+}
+
+/**
+ * \brief SMLAWB - acc + ((a * b[15:0]) >> 16)
+ */
+static inline int32_t Dsp_Smlawb(int32_t a, int32_t b, int32_t acc)
+{
+	return acc + (int32_t)(((int64_t)a * (int16_t)b) >> 16);
+}
+
+/**
+ * \brief SADD16 - two 16 bit additions, the results wrap around
+ */
+static inline uint32_t Dsp_Sadd16(uint32_t x, uint32_t y)
+{
+	return ((x + y) & 0x0000FFFF) | (((x & 0xFFFF0000) + (y & 0xFFFF0000)) & 0xFFFF0000);
+}
+
+/**
+ * \brief SHADD16 - two 16 bit signed additions with the results halved
+ */
+static inline uint32_t Dsp_Shadd16(uint32_t x, uint32_t y)
+{
+	uint32_t low = (uint32_t)(((int16_t)x + (int16_t)y) >> 1) & 0x0000FFFF;
+	uint32_t high = (uint32_t)(((int16_t)(x >> 16) + (int16_t)(y >> 16)) >> 1) << 16;
+
+	return high | low;
+}
+
+/**
+ * \brief SHSUB16 - two 16 bit signed subtractions with the results halved
+ */
+static inline uint32_t Dsp_Shsub16(uint32_t x, uint32_t y)
+{
+	uint32_t low = (uint32_t)(((int16_t)x - (int16_t)y) >> 1) & 0x0000FFFF;
+	uint32_t high = (uint32_t)(((int16_t)(x >> 16) - (int16_t)(y >> 16)) >> 1) << 16;
+
+	return high | low;
+}
+
+/**
+ * \brief SHASX - (x[15:0] - y[31:16]) / 2 in the bottom half word, (x[31:16] + y[15:0]) / 2 in the top one
+ */
+static inline uint32_t Dsp_Shasx(uint32_t x, uint32_t y)
+{
+	uint32_t low = (uint32_t)(((int16_t)x - (int16_t)(y >> 16)) >> 1) & 0x0000FFFF;
+	uint32_t high = (uint32_t)(((int16_t)(x >> 16) + (int16_t)y) >> 1) << 16;
+
+	return high | low;
+}
+
+/**
+ * \brief SHSAX - (x[15:0] + y[31:16]) / 2 in the bottom half word, (x[31:16] - y[15:0]) / 2 in the top one
+ */
+static inline uint32_t Dsp_Shsax(uint32_t x, uint32_t y)
+{
+	uint32_t low = (uint32_t)(((int16_t)x + (int16_t)(y >> 16)) >> 1) & 0x0000FFFF;
+	uint32_t high = (uint32_t)(((int16_t)(x >> 16) - (int16_t)y) >> 1) << 16;
+
+	return high | low;
+}
+
+/**
+ * \brief SMUAD - x[15:0] * y[15:0] + x[31:16] * y[31:16]
+ */
+static inline int32_t Dsp_Smuad(uint32_t x, uint32_t y)
+{
+	return (int16_t)x * (int16_t)y + (int16_t)(x >> 16) * (int16_t)(y >> 16);
+}
+
+/**
+ * \brief SMUADX - x[15:0] * y[31:16] + x[31:16] * y[15:0]
+ */
+static inline int32_t Dsp_Smuadx(uint32_t x, uint32_t y)
+{
+	return (int16_t)x * (int16_t)(y >> 16) + (int16_t)(x >> 16) * (int16_t)y;
+}
+
+/**
+ * \brief SMUSD - x[15:0] * y[15:0] - x[31:16] * y[31:16]
+ */
+static inline int32_t Dsp_Smusd(uint32_t x, uint32_t y)
+{
+	return (int16_t)x * (int16_t)y - (int16_t)(x >> 16) * (int16_t)(y >> 16);
+}
+
+/**
+ * \brief SSUB16 - two 16 bit subtractions, the results wrap around
+ */
+static inline uint32_t Dsp_Ssub16(uint32_t x, uint32_t y)
+{
+	return ((x - y) & 0x0000FFFF) | (((x & 0xFFFF0000) - (y & 0xFFFF0000)) & 0xFFFF0000);
+}
+
+/**
+ * \brief QADD16 - two 16 bit signed additions with the saturation
+ */
+static inline uint32_t Dsp_Qadd16(uint32_t x, uint32_t y)
+{
+	uint32_t low = (uint16_t)Dsp_Saturate_Q15((int16_t)x + (int16_t)y);
+	uint32_t high = (uint16_t)Dsp_Saturate_Q15((int16_t)(x >> 16) + (int16_t)(y >> 16));
+
+	return low | (high << 16);
+}
+
+/**
+ * \brief QSUB16 - two 16 bit signed subtractions with the saturation
+ */
+static inline uint32_t Dsp_Qsub16(uint32_t x, uint32_t y)
+{
+	uint32_t low = (uint16_t)Dsp_Saturate_Q15((int16_t)x - (int16_t)y);
+	uint32_t high = (uint16_t)Dsp_Saturate_Q15((int16_t)(x >> 16) - (int16_t)(y >> 16));
+
+	return low | (high << 16);
+}
+
+/**
+ * \brief SMULBB - x[15:0] * y[15:0]
+ */
+static inline int32_t Dsp_Smulbb(uint32_t x, uint32_t y)
+{
+	return (int16_t)x * (int16_t)y;
+}
+
+/**
+ * \brief SMULTB - x[31:16] * y[15:0]
+ */
+static inline int32_t Dsp_Smultb(uint32_t x, uint32_t y)
+{
+	return (int16_t)(x >> 16) * (int16_t)y;
+}
+
+/**
+ * \brief UXTB16 - bytes 0 and 2 zero extended to the half words
+ */
+static inline uint32_t Dsp_Uxtb16(uint32_t x)
+{
+	return x & 0x00FF00FF;
+}
+
+/**
+ * \brief PKHBT - the bottom half word of x and the top half word of (y << shift)
+ */
+static inline uint32_t Dsp_Pkhbt(uint32_t x, uint32_t y, uint32_t shift)
+{
+	return (x & 0x0000FFFF) | ((y << shift) & 0xFFFF0000);
+}
+
+/**
+ * \brief PKHTB - the top half word of x and the bottom half word of (y >> shift), arithmetic shift
+ */
+static inline uint32_t Dsp_Pkhtb(uint32_t x, uint32_t y, uint32_t shift)
+{
+	return (x & 0xFFFF0000) | ((uint32_t)((int32_t)y >> shift) & 0x0000FFFF);
+}
+
+#endif
+
+/**
+ * \brief This function loads two Q15 values as one word for the dual 16 bit instructions. The address does not have to be
+ * 			word aligned (the Cortex-M4 LDR allows it), memcpy is compiled to a single LDR.
+ */
+static inline uint32_t Dsp_Read_Q15x2(const int16_t* data)
+{
+	uint32_t word;
+
+	memcpy(&word, data, sizeof(word));
+	return word;
+}
+
+/**
+ * \brief This function adds the 64 bit product of two 32 bit values to the accumulator. GCC compiles it to a single SMLAL.
+ */
+static inline int64_t Dsp_Smlal(int64_t acc, int32_t x, int32_t y)
+{
+	return acc + (int64_t)x * y;
+}
+
+#endif
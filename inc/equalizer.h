@@ -0,0 +1,43 @@
+#ifndef _EQUALIZER_H_
+#define _EQUALIZER_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/**
+ * NOTE:	The equalizer works on the DAC words (DHR12LD layout) in the DAC refill interrupt, before the volume. Every band
+ * 			is one Direct Form I biquad per channel. The samples and the filter state are Q31 with EQUALIZER_HEADROOM_BITS
+ * 			for the boost, the coefficients are Q28 (the shelving filters need more than +-2) and all five products are
+ * 			summed in the 64 bit accumulator with SMLAL. The long state keeps the low frequency poles precise, which Q15
+ * 			could not. The Direct Form I keeps the input and the output history, so the coefficients can be changed
+ * 			between two blocks without the clicks. The coefficients are computed (the RBJ cookbook formulas) in the main
+ * 			context and swapped in at the start of the next block. The bands at 0dB are skipped.
+ */
+
+#define EQUALIZER_BANDS				(uint8_t)3
+#define EQUALIZER_MAX_GAIN			(int8_t)12		//	In dB, both the boost and the cut
+#define EQUALIZER_GAIN_STEP			(int8_t)2		//	In dB
+#define EQUALIZER_HEADROOM_BITS		(uint8_t)4		//	24dB above the full scale before the filters overflow
+#define EQUALIZER_CYCLE_BUDGET		(uint32_t)16	//	Max. CPU cycles per sample per band
+#define EQUALIZER_DEFAULT_RATE		(uint32_t)44100
+#define EQUALIZER_BENCHMARK_FRAMES	(uint32_t)256
+
+typedef enum
+{
+	EQUALIZER_FILTER_LOW_SHELF,		//	The gain below the frequency (bass)
+	EQUALIZER_FILTER_PEAKING,		//	The gain around the frequency
+	EQUALIZER_FILTER_HIGH_SHELF		//	The gain above the frequency (treble)
+}equalizer_filter_e;
+
+void	Equalizer_Set_Sample_Rate(uint32_t sample_rate);
+void	Equalizer_Configure_Band(uint8_t band, equalizer_filter_e filter, uint16_t frequency, float q);
+void	Equalizer_Set_Gain(uint8_t band, int8_t gain);
+int8_t	Equalizer_Get_Gain(uint8_t band);
+void	Equalizer_Set_Enabled(bool enabled);
+bool	Equalizer_Is_Enabled(void);
+uint8_t	Equalizer_Get_Selected_Band(void);
+bool	Equalizer_Execute_Remote_Command(uint8_t command);
+void	Equalizer_Process(uint32_t* words, uint32_t frames);
+uint32_t	Equalizer_Benchmark(void);
+
+#endif
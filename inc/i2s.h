@@ -0,0 +1,39 @@
+#ifndef INC_I2S_H_
+#define INC_I2S_H_
+
+#include "stm32f4xx.h"
+#include "dac.h"
+#include <stdbool.h>
+
+/**
+ * NOTE:	The I2S playback drives an external codec from SPI3 in the I2S master mode. It works like the DAC playback: the
+ * 			circular DMA reads a ping-pong buffer and the half transfer interrupts call the same refill function
+ * 			(dac_playback_refill_f), which gives the DHR12LD words, so the whole audio pipeline feeds either output. The
+ * 			words are moved to the signed range (the top bit of both lanes flipped) before they are sent, the channel 1
+ * 			(bits [15:0]) is the left one. The codec gets all 16 bits, the DAC dither is not needed.
+ * 			The I2S clock comes from the PLLI2S. Its multiplier and dividers are searched for the rate closest to the
+ * 			requested one, e.g. 44.1kHz and 48kHz are both within 0.02% with the master clock (256 x Fs) output.
+ */
+
+#define I2S_PLAYBACK_SPI					SPI3
+#define I2S_PLAYBACK_DMA_STREAM				DMA1_Stream7	//	SPI3_TX is mapped to DMA1 stream 7 channel 0 (stream 5 is used by the DAC)
+#define I2S_PLAYBACK_DMA_CHANNEL			(uint32_t)0
+#define I2S_PLAYBACK_DMA_IRQn				DMA1_Stream7_IRQn
+#define I2S_PLAYBACK_HALF_BUFFER_SAMPLES	(uint32_t)512	//	Stereo frames refilled in one interrupt
+#define I2S_PLAYBACK_MASTER_CLOCK			1				//	1 - MCK (256 x Fs) is output for the codec
+#define I2S_PLAYBACK_FRAME_32_BIT			0				//	1 - the 16 bit samples are sent in the 32 bit channel frames (the 24 and 32 bit codecs)
+
+#define I2S_WS_PORT							GPIOA			//*
+#define I2S_WS_PIN							PIN_15			//*	PA4 (the other WS pin) is the DAC channel 1 output
+#define I2S_CLOCK_PORT						GPIOC			//*
+#define I2S_CK_PIN							PIN_10			//*
+#define I2S_SD_PIN							PIN_12			//*
+#define I2S_MCK_PIN							PIN_7			//*
+#define I2S_ALTERNATE_FUNCTION				AF6
+
+uint32_t	I2S_Playback_Init(uint32_t sample_rate_hz, dac_playback_refill_f refill);
+void		I2S_Playback_Start(void);
+void		I2S_Playback_Stop(void);
+void		DMA1_Stream7_IRQHandler(void);
+
+#endif /* INC_I2S_H_ */
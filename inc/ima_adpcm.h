@@ -0,0 +1,28 @@
+#ifndef _IMA_ADPCM_H_
+#define _IMA_ADPCM_H_
+
+#include <stdint.h>
+
+/**
+ * NOTE:	The IMA/DVI ADPCM decoder for the WAV format 0x11. The block starts with the header of every channel (4 bytes:
+ * 			the first sample, the step index and a reserved byte), then the 4 byte groups of 8 samples follow, one group of
+ * 			every channel in turn. Both the header and the group take 4 bytes per channel, IMA_ADPCM_UNIT_SIZE(channels),
+ * 			so the block can be decoded unit by unit as it comes from the card.
+ */
+
+#define IMA_ADPCM_MAX_CHANNELS				(uint8_t)2
+#define IMA_ADPCM_UNIT_SIZE(channels)		(uint32_t)(4 * (channels))		//	Bytes of the block header or of one group
+#define IMA_ADPCM_GROUP_FRAMES				(uint32_t)8						//	Frames decoded from one group
+
+typedef struct
+{
+	int32_t		predictor[IMA_ADPCM_MAX_CHANNELS];
+	int32_t		step_index[IMA_ADPCM_MAX_CHANNELS];
+	uint8_t		channels;
+}ima_adpcm_t;
+
+void		Ima_Adpcm_Init(ima_adpcm_t* decoder, uint8_t channels);
+void		Ima_Adpcm_Decode_Header(ima_adpcm_t* decoder, const uint8_t* header, int16_t* output);
+void		Ima_Adpcm_Decode_Groups(ima_adpcm_t* decoder, const uint8_t* data, uint32_t groups, int16_t* output);
+
+#endif
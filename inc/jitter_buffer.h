@@ -0,0 +1,55 @@
+#ifndef _JITTER_BUFFER_H_
+#define _JITTER_BUFFER_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "audio_ring.h"
+#include "resampler.h"
+
+/**
+ * NOTE:	The jitter buffer is the stage between the network receiver (e.g. the ESP8266 data) and the playback ring. The
+ * 			sender clock and the TIM6 clock of the DAC are never equal, so a fixed rate would empty or overflow any buffer
+ * 			in the end. The buffered audio is measured every JITTER_BUFFER_UPDATE_FRAMES output frames, low-pass filtered
+ * 			(the packets come in bursts) and a PI controller trims the step of the polyphase resampler around its nominal
+ * 			value. The correction is kept in 1/256 LSB of the step, the part below 1 LSB (15ppm) is carried from update to
+ * 			update, so the mean step follows it finely. The resampler position runs on, no sample is dropped or repeated
+ * 			and there is no click.
+ * 			The correction is limited to JITTER_BUFFER_MAX_CORRECTION, so the clocks may differ by up to 1000ppm and the
+ * 			proportional part still has the room above the drift. The integral stops while the correction is at the limit.
+ * 			Trimming the TIM6 ARR instead would move the DAC by 1 timer clock (~525ppm at 44.1kHz) per step.
+ * 			The input is 16 bit signed PCM, the output - the DAC words (DHR12LD layout).
+ * 			host/jitter_buffer_simulation.c checks the controller against the clock drift.
+ */
+
+#define JITTER_BUFFER_BLOCK_FRAMES			RESAMPLER_BLOCK_SIZE	//	Frames resampled at once
+#define JITTER_BUFFER_UPDATE_FRAMES			(uint32_t)512			//	Output frames between the controller updates
+#define JITTER_BUFFER_FILTER_SHIFT			(uint8_t)7				//	Level filter time constant: 2^7 updates (~1.5s at 44.1kHz)
+#define JITTER_BUFFER_PROPORTIONAL_SHIFT	(uint8_t)1				//	1/2 LSB of the step per frame of the error
+#define JITTER_BUFFER_INTEGRAL_SHIFT		(uint8_t)11				//	1/2048 LSB of the step per frame of the error per update
+#define JITTER_BUFFER_CORRECTION_BITS		(uint8_t)8				//	The correction is kept in 1/256 LSB of the step
+#define JITTER_BUFFER_MAX_CORRECTION		(int32_t)(100 << JITTER_BUFFER_CORRECTION_BITS)	//	~1500ppm
+
+typedef struct
+{
+	audio_ring_t	ring;					/*< The received PCM bytes */
+	resampler_t		resampler;
+	uint32_t		nominal_step;			/*< The resampler step for the nominal rates, Q16.16 */
+	uint32_t		target_frames;			/*< The buffered input frames to keep */
+	uint8_t			frame_size;				/*< Bytes of one input frame */
+	bool			buffering;				/*< True until the target is reached after the start or the underrun */
+	int32_t			filtered_error;			/*< The low-pass filtered level error, Q8 frames */
+	int32_t			integral;				/*< The sum of the filtered errors, the integral part of the correction is its >> JITTER_BUFFER_INTEGRAL_SHIFT */
+	int32_t			correction;				/*< The last correction, 1/256 LSB of the step */
+	uint32_t		step_fraction;			/*< The part of the correction below 1 LSB carried to the next update */
+	uint32_t		update_frames;			/*< Output frames since the last update */
+	uint32_t		underruns;				/*< The times the buffer ran empty */
+	uint32_t		overflows;				/*< Bytes dropped because the ring was full */
+}jitter_buffer_t;
+
+bool		Jitter_Buffer_Init(jitter_buffer_t* jitter, uint8_t* buffer, uint32_t buffer_size, uint32_t input_rate, uint32_t output_rate, uint8_t channels, uint32_t target_ms);
+void		Jitter_Buffer_Reset(jitter_buffer_t* jitter);
+uint32_t	Jitter_Buffer_Put(jitter_buffer_t* jitter, const uint8_t* data, uint32_t data_size);
+uint32_t	Jitter_Buffer_Process(jitter_buffer_t* jitter, audio_ring_t* output);
+int32_t		Jitter_Buffer_Get_Correction_Ppm(jitter_buffer_t* jitter);
+
+#endif
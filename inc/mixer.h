@@ -0,0 +1,36 @@
+#ifndef _MIXER_H_
+#define _MIXER_H_
+
+#include "audio_ring.h"
+#include <stdint.h>
+#include <stdbool.h>
+
+/**
+ * NOTE:	The mixer takes the DAC words (DHR12LD layout) from up to MIXER_SOURCES playback rings in the DAC refill
+ * 			interrupt and adds them, so one output path plays the track crossfades or the UI sounds over the music. Every
+ * 			source has its own Q15 gain envelope, which goes linearly to the target over the given number of frames. The
+ * 			scaled lanes are summed with QADD16, so the loud mix saturates instead of wrapping around. The source which
+ * 			runs out of data is mixed as silence; the block is short (the DAC underrun) only when all sources are empty.
+ * 			With only the main source at the unity gain the words are just copied from its ring.
+ */
+
+#define MIXER_UNITY_GAIN			(int16_t)32767
+#define MIXER_CYCLE_BUDGET			(uint32_t)24		//	Max. CPU cycles per stereo frame, both sources fading
+#define MIXER_BENCHMARK_FRAMES		(uint32_t)256
+
+typedef enum
+{
+	MIXER_SOURCE_MAIN,				//	The WAV playback
+	MIXER_SOURCE_AUX,				//	The UI sounds or the second stream
+	MIXER_SOURCES
+}mixer_source_e;
+
+void		Mixer_Set_Source(mixer_source_e source, audio_ring_t* ring);
+void		Mixer_Set_Gain(mixer_source_e source, int16_t gain);
+void		Mixer_Fade(mixer_source_e source, int16_t gain, uint32_t frames);
+void		Mixer_Crossfade(mixer_source_e to, uint32_t frames);
+bool		Mixer_Is_Fading(mixer_source_e source);
+uint32_t	Mixer_Get(uint32_t* words, uint32_t frames);
+uint32_t	Mixer_Benchmark(void);
+
+#endif
@@ -0,0 +1,32 @@
+#ifndef _PCM_CONVERT_H_
+#define _PCM_CONVERT_H_
+
+#include <stdint.h>
+
+/**
+ * NOTE:	The conversion kernels from the PCM formats to the dual channel left aligned DAC words (DHR12LD layout: channel 1
+ * 			in bits [15:0], channel 2 in bits [31:16]). The samples keep 16 bits, the DAC truncation is left to the output. They work on two 16 bit lanes with the SIMD instructions, so every
+ * 			offset and pack handles two samples. Mono input is put on both channels. The input does not have to be aligned.
+ */
+
+#define PCM_CONVERT_BENCHMARK_FRAMES		(uint32_t)256
+
+/**
+ * The conversion kernel
+ *
+ * \param input		-	the PCM frames
+ * \param output	-	the DAC words, one per frame
+ * \param frames	-	the number of the frames to convert
+ */
+typedef void (*pcm_convert_f)(const uint8_t* input, uint32_t* output, uint32_t frames);
+
+void			Pcm_Convert_U8_Mono(const uint8_t* input, uint32_t* output, uint32_t frames);
+void			Pcm_Convert_U8_Stereo(const uint8_t* input, uint32_t* output, uint32_t frames);
+void			Pcm_Convert_S16_Mono(const uint8_t* input, uint32_t* output, uint32_t frames);
+void			Pcm_Convert_S16_Stereo(const uint8_t* input, uint32_t* output, uint32_t frames);
+void			Pcm_Convert_S24_Mono(const uint8_t* input, uint32_t* output, uint32_t frames);
+void			Pcm_Convert_S24_Stereo(const uint8_t* input, uint32_t* output, uint32_t frames);
+pcm_convert_f	Pcm_Convert_Get_Kernel(uint16_t bits_per_sample, uint16_t channels);
+uint32_t		Pcm_Convert_Benchmark(pcm_convert_f kernel);
+
+#endif
@@ -0,0 +1,46 @@
+#ifndef _PLAYLIST_H_
+#define _PLAYLIST_H_
+
+#include "sd_card_reader.h"
+#include "audio_ring.h"
+#include "wav.h"
+#include <stdint.h>
+#include <stdbool.h>
+
+/**
+ * NOTE:	The playlist plays the WAV files of one directory one after another without the gaps. The current track and the
+ * 			next one have their own SD streams and input rings. The next track is opened as soon as the current one starts:
+ * 			its first sectors are read and its headers are parsed ahead (Wav_Parser_Queue()), so at the end of the current
+ * 			track its parser only goes on filling the same playback ring and the DAC never runs dry. NEC_NEXT and NEC_PREV
+ * 			switch the tracks the same way - the samples already in the playback ring are played out, no buffer is
+ * 			refilled from scratch. After the last track the playback stops, once its last samples are played
+ * 			(Wav_Playback_Is_Drained()).
+ */
+
+#define PLAYLIST_MAX_TRACKS				FILE_ARRAY_SIZE
+#define PLAYLIST_INPUT_RING_SIZE		(uint16_t)(2 * SD_STREAM_BUFFER_SIZE)	//	Power of 2, two stream reads
+#define PLAYLIST_OUTPUT_RING_SIZE		(uint16_t)4096							//	Power of 2, ~23ms of the DAC words at 44.1kHz
+#define PLAYLIST_PATH_SIZE				(uint8_t)64								//	The directory path with the file name
+#define PLAYLIST_NO_TRACK				(uint8_t)0xFF
+
+/**
+ * The track which is played or prefetched. The slot number is also the number of its SD stream.
+ */
+typedef struct
+{
+	wav_parser_t	parser;
+	audio_ring_t	input;											/*< The raw file data from the SD stream */
+	uint8_t			input_buffer[PLAYLIST_INPUT_RING_SIZE];
+	uint8_t			track;											/*< The track number, PLAYLIST_NO_TRACK if the slot is free */
+}playlist_slot_t;
+
+FRESULT		Playlist_Open(const TCHAR* dir_path);
+FRESULT		Playlist_Play(uint8_t track);
+FRESULT		Playlist_Next(void);
+FRESULT		Playlist_Previous(void);
+FRESULT		Playlist_Process(void);
+uint8_t		Playlist_Get_Track(void);
+uint8_t		Playlist_Get_Track_Count(void);
+bool		Playlist_Execute_Remote_Command(uint8_t command);
+
+#endif
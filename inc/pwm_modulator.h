@@ -0,0 +1,22 @@
+#ifndef INC_PWM_MODULATOR_H_
+#define INC_PWM_MODULATOR_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/**
+ * NOTE:	The PWM modulator turns the DAC words (DHR12LD layout) into the duty values of the PWM playback. The mono mix
+ * 			(L + R) / 2 is mapped to the duty in Q16 steps of the timer clock and every sample gives
+ * 			PWM_MODULATOR_OVERSAMPLING duty values, one per carrier period. The second order error feedback (1 - z^-1)^2 of
+ * 			the duty quantization, at the carrier rate, moves the error above the audio band. It has no hardware part, so
+ * 			the host programs run the same code as the DMA interrupt of pwm_playback.c.
+ */
+
+#define PWM_MODULATOR_OVERSAMPLING			(uint32_t)4		//	Carrier periods per sample
+#define PWM_MODULATOR_GUARD_STEPS			(uint32_t)2		//	The duty range left at both ends for the noise shaping
+
+void	PWM_Modulator_Init(uint32_t period);
+void	PWM_Modulator_Set_Noise_Shaping(bool enabled);
+void	PWM_Modulator_Process(const uint32_t* words, uint16_t* duties, uint32_t frames);
+
+#endif /* INC_PWM_MODULATOR_H_ */
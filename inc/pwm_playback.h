@@ -0,0 +1,40 @@
+#ifndef INC_PWM_PLAYBACK_H_
+#define INC_PWM_PLAYBACK_H_
+
+#include "stm32f4xx.h"
+#include "dac.h"
+#include "pwm_modulator.h"
+#include <stdbool.h>
+
+/**
+ * NOTE:	The PWM playback is the output for the boards without the DAC pin: the mono mix (L + R) / 2 of the samples sets
+ * 			the duty cycle of TIM1 channel 1, which is filtered by the RC (or the class-D speaker) outside. The timer is set
+ * 			by TIM_PWMConfigure() and its update event requests the DMA, which writes the next CCR1 value from the ping-pong
+ * 			buffer, so no interrupt per sample is needed. Like for the DAC and the I2S, the half transfer interrupts call
+ * 			the refill function (dac_playback_refill_f).
+ * 			The carrier runs at PWM_PLAYBACK_OVERSAMPLING times the sample rate, every sample gives that many duty values.
+ * 			The timer clock gives only about 10 bits per carrier period (952 steps at 44.1kHz), the second order noise
+ * 			shaping (1 - z^-1)^2 of the duty quantization, at the carrier rate, moves the error above the audio band. The
+ * 			duty values are computed by pwm_modulator.c.
+ */
+
+#define PWM_PLAYBACK_TIMER					TIM1
+#define PWM_PLAYBACK_TIMER_CLOCK_HZ			(uint32_t)(2*APB2*1000000)
+#define PWM_PLAYBACK_DMA					DMA2
+#define PWM_PLAYBACK_DMA_STREAM				DMA2_Stream5	//	TIM1_UP is mapped to DMA2 stream 5 channel 6
+#define PWM_PLAYBACK_DMA_CHANNEL			(uint32_t)6
+#define PWM_PLAYBACK_DMA_IRQn				DMA2_Stream5_IRQn
+#define PWM_PLAYBACK_HALF_BUFFER_SAMPLES	(uint32_t)256	//	Frames refilled in one interrupt
+#define PWM_PLAYBACK_OVERSAMPLING			PWM_MODULATOR_OVERSAMPLING	//	Carrier periods per sample
+
+#define PWM_PLAYBACK_PORT					GPIOA			//*
+#define PWM_PLAYBACK_PIN					PIN_8			//*	TIM1_CH1
+#define PWM_PLAYBACK_ALTERNATE_FUNCTION		AF1
+
+uint32_t	PWM_Playback_Init(uint32_t sample_rate_hz, dac_playback_refill_f refill);
+void		PWM_Playback_Set_Noise_Shaping(bool enabled);
+void		PWM_Playback_Start(void);
+void		PWM_Playback_Stop(void);
+void		DMA2_Stream5_IRQHandler(void);
+
+#endif /* INC_PWM_PLAYBACK_H_ */
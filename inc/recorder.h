@@ -0,0 +1,28 @@
+#ifndef _RECORDER_H_
+#define _RECORDER_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "ff.h"
+
+/**
+ * NOTE:	The recorder writes the ADC capture to a 16 bit PCM WAV file. The capture callback (DMA interrupt) only converts
+ * 			the 12 bit conversions to signed samples and puts them in the ring, the main loop takes them in bursts of
+ * 			RECORDER_BURST_SECTORS sectors. The 44 byte header is sent with the first burst, so every f_write() is sector
+ * 			aligned and FatFS gives the whole burst to the card with one multiple block write (CMD25).
+ * 			When the ring can not take a half of the capture buffer, the whole half is dropped, so the channels never shift.
+ * 			The RIFF sizes are written by Recorder_Stop(), an unstopped file has them equal to 0.
+ */
+
+#define RECORDER_RING_SIZE				(uint32_t)16384	//	Power of 2, ~0.19s of the stereo capture at 44.1kHz
+#define RECORDER_BURST_SECTORS			(uint8_t)8		//	Sectors written with one multiple block write
+#define RECORDER_BURST_SIZE				(RECORDER_BURST_SECTORS * 512)
+#define RECORDER_WAV_HEADER_SIZE		(uint32_t)44	//	RIFF, fmt and data chunk headers of the PCM file
+
+FRESULT		Recorder_Start(const TCHAR* path, uint32_t sample_rate_hz, const uint8_t* channels, uint8_t channel_count);
+FRESULT		Recorder_Process(void);
+FRESULT		Recorder_Stop(void);
+bool		Recorder_Is_Recording(void);
+uint32_t	Recorder_Get_Dropped_Frames(void);
+
+#endif
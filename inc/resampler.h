@@ -0,0 +1,37 @@
+#ifndef _RESAMPLER_H_
+#define _RESAMPLER_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/**
+ * NOTE:	The polyphase sample rate converter for Q15 PCM. The windowed sinc filter is split in RESAMPLER_PHASES phases
+ * 			of RESAMPLER_TAPS taps, the output between two phases is linearly interpolated. The filter is computed
+ * 			once in Resampler_Init() and the processing is done only with the SMLAD/SMLAWB instructions.
+ * 			The position of the output sample is kept in Q16.16 format in the input sample units.
+ */
+
+#define RESAMPLER_PHASES				(uint16_t)64
+#define RESAMPLER_PHASE_BITS			(uint8_t)6		//	log2(RESAMPLER_PHASES)
+#define RESAMPLER_TAPS					(uint16_t)32	//	Must be even - two taps per SMLAD
+#define RESAMPLER_BLOCK_SIZE			(uint16_t)128	//	Input frames buffered by the resampler
+#define RESAMPLER_HISTORY_SIZE			(RESAMPLER_TAPS + RESAMPLER_BLOCK_SIZE)
+#define RESAMPLER_MAX_CHANNELS			(uint8_t)2
+
+typedef struct
+{
+	int16_t			coefficients[RESAMPLER_PHASES + 1][RESAMPLER_TAPS];			/*< The last phase is the first one moved by one sample */
+	int16_t			history[RESAMPLER_MAX_CHANNELS][RESAMPLER_HISTORY_SIZE];	/*< The input samples, deinterleaved */
+	uint32_t		history_size;												/*< Number of valid frames in the history */
+	uint32_t		position;													/*< The next output sample position in the history, Q16.16 */
+	uint32_t		step;														/*< Input frames per one output frame, Q16.16 */
+	uint8_t			channels;
+}resampler_t;
+
+bool		Resampler_Init(resampler_t* resampler, uint32_t input_rate, uint32_t output_rate, uint8_t channels);
+void		Resampler_Reset(resampler_t* resampler);
+uint32_t	Resampler_Get_Input_Space(resampler_t* resampler);
+uint32_t	Resampler_Process(resampler_t* resampler, const int16_t* input, uint32_t input_frames, int16_t* output, uint32_t output_frames);
+uint32_t	Resampler_Benchmark(uint32_t input_rate, uint32_t output_rate);
+
+#endif
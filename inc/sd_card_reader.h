@@ -6,6 +6,7 @@
 #include "GPIO.h"
 #include "integer.h"
 #include "ff.h"
+#include "audio_ring.h"
 #include <stdbool.h>
 
 /**
@@ -147,6 +148,8 @@ extern r1_response_u r1_response;
 #define SD_READ_OCR_RESPONSE                    r3_response
 
 #define SD_RESPONSE_1_NO_ERROR                  (uint8_t)0
+#define SD_DATA_RESPONSE_MASK					(uint8_t)0x1F	//	The data response token after the written block: xxx0sss1
+#define SD_DATA_RESPONSE_ACCEPTED				(uint8_t)0x05
 
 
 #define SD_CARD_OP_OK							(uint8_t)0
@@ -155,9 +158,28 @@ extern r1_response_u r1_response;
 
 #define FILE_ARRAY_SIZE							(uint8_t)40
 
+#define SD_STREAM_MAX_FILES						(uint8_t)2		//	Number of files which can be streamed at the same time
+#define SD_STREAM_BUFFER_SECTORS				(uint8_t)4		//	Sectors read from the card with one multiple block read
+#define SD_STREAM_BUFFER_SIZE					(SD_STREAM_BUFFER_SECTORS * 512)
+
+/**
+ * The streamed file with its own sector buffer. The file is always read in whole sectors, so FatFS transfers the data
+ * straight from the card to the buffer and the streams do not share (and thrash) the FatFS sector window.
+ */
+typedef struct
+{
+	FIL				file;											/*< The streamed file */
+	audio_ring_t*	ring;											/*< The ring which is fed with the file data */
+	uint32_t		buffer[SD_STREAM_BUFFER_SIZE / sizeof(uint32_t)];	/*< Sector buffer, uint32_t keeps it word aligned */
+	UINT			data_size;										/*< Number of valid bytes in the buffer */
+	UINT			data_index;										/*< Index of the first byte not yet put in the ring */
+	bool			opened;											/*< True if the stream is in use */
+	bool			end_of_file;									/*< True if the whole file was read from the card */
+}sd_stream_t;
+
 extern uint16_t					sd_number_of_files_in_dir;
 extern DIR						sd_current_directory;					/*< The current directory	*/
-extern FIL						sd_current_file;						/*< The current file */
+extern sd_stream_t				sd_streams[SD_STREAM_MAX_FILES];		/*< The streamed files */
 extern FILINFO					sd_current_file_information;			/*< The current checked file informations	*/
 extern TCHAR					sd_files_list[FILE_ARRAY_SIZE][13];
 extern BYTE						sd_data_buffer[512];
@@ -168,6 +190,11 @@ extern uint16_t					read_data_byte_counter;
 bool 		SD_Check_If_File_Opened(FIL* file);
 FRESULT 	SD_Find_File_Name_Containing(TCHAR* directory_path, TCHAR* name_pattern);
 FRESULT 	SD_Get_File_List(const TCHAR* dir_path);
+FRESULT 	SD_Forward_To_Audio_Ring(FIL* file, audio_ring_t* ring, UINT* bytes_forwarded);
+FRESULT 	SD_Stream_Open(uint8_t stream_number, const TCHAR* path, audio_ring_t* ring);
+FRESULT 	SD_Stream_Close(uint8_t stream_number);
+FRESULT 	SD_Stream_Service(void);
+bool 		SD_Stream_Is_Finished(uint8_t stream_number);
 
 
 /***		LOW LEVEL API	***/
@@ -176,5 +203,8 @@ uint32_t	SD_Send_Command(uint8_t command, uint8_t* argument_array);
 uint32_t	SD_Card_Init(void);
 uint16_t 	SD_Get_Block_Size(void);
 uint16_t 	SD_Read_Single_Block(DWORD sector_number, BYTE* data_buffer);
+uint16_t 	SD_Read_Multiple_Blocks(DWORD sector_number, BYTE* data_buffer, UINT number_of_blocks);
+uint16_t 	SD_Write_Single_Block(DWORD sector_number, const BYTE* data_buffer);
+uint16_t 	SD_Write_Multiple_Blocks(DWORD sector_number, const BYTE* data_buffer, UINT number_of_blocks);
 
 #endif
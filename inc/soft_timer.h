@@ -0,0 +1,59 @@
+#ifndef INC_SOFT_TIMER_H_
+#define INC_SOFT_TIMER_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/**
+ * NOTE:	The software timers let any number of timeouts run at once on the single alarm of the timebase (timebase.h),
+ * 			e.g. the SD card command timeout, the periodic LCD refresh, the ESP8266 AT command timeout and the IR repeat
+ * 			detection (restarted by each NEC frame, the expiry means the key was released).
+ * 			The timers are kept in a hierarchical timing wheel: SOFT_TIMER_LEVELS levels of SOFT_TIMER_SLOTS slots, the
+ * 			level 0 slot is one tick (2^SOFT_TIMER_TICK_SHIFT us), each higher level slot - all the slots of the level
+ * 			below. The level of the timer is the highest group of the tick bits in which its expiry differs from the
+ * 			current tick, so the start and the stop are O(1) - a few bit operations and a list link. When the current tick
+ * 			reaches the slot of the higher level, its timers move (cascade) to the lower levels. The timers beyond the
+ * 			wheel (~17.9 minutes) wait in one list, which is checked each wheel turn.
+ * 			The wheel is tickless - each level keeps a mask of its used slots, so the next event is found with one CLZ
+ * 			per level and the alarm is programmed only for it. The wheel jumps from event to event, there is no
+ * 			interrupt per tick.
+ * 			The timer never expires before its timeout, it may expire up to one tick later. The period is at least one tick.
+ * 			The callbacks are called from the timebase interrupt (TIMEBASE_IRQ_PRIORITY), so they should only set the flags
+ * 			or start the work. They may start and stop the timers, also their own.
+ * 			The soft_timer_t structures are owned by the users and must stay valid while the timer runs.
+ */
+
+#define SOFT_TIMER_TICK_SHIFT				(uint8_t)10		//	1 tick = 1024us
+#define SOFT_TIMER_LEVEL_BITS				(uint8_t)5		//	Tick bits per level - the used slots fit a 32 bit mask
+#define SOFT_TIMER_LEVELS					(uint8_t)4
+#define SOFT_TIMER_SLOTS					(uint8_t)(1 << SOFT_TIMER_LEVEL_BITS)
+#define SOFT_TIMER_WHEEL_BITS				(uint8_t)(SOFT_TIMER_LEVELS*SOFT_TIMER_LEVEL_BITS)	//	2^20 ticks
+#define SOFT_TIMER_MAX_TIMEOUT_US			(uint32_t)0x7FFFFFFF
+
+/**
+ * The function called when the timer expires.
+ *
+ * \param context	-	the pointer given to Soft_Timer_Create
+ */
+typedef void (*soft_timer_callback_f)(void* context);
+
+typedef struct soft_timer_t
+{
+	struct soft_timer_t*	next;
+	struct soft_timer_t**	prev_next;		/*< The pointer which points to this timer, NULL if the timer does not run */
+	uint64_t				expiry_us;		/*< The exact expiry, the periodic timers add the period to it */
+	uint64_t				expiry_tick;
+	uint32_t				period_us;		/*< 0 - one shot timer */
+	soft_timer_callback_f	callback;
+	void*					context;
+	uint8_t					level;			/*< SOFT_TIMER_LEVELS - the list beyond the wheel */
+	uint8_t					slot;
+} soft_timer_t;
+
+void		Soft_Timer_Init(void);
+void		Soft_Timer_Create(soft_timer_t* timer, soft_timer_callback_f callback, void* context);
+void		Soft_Timer_Start(soft_timer_t* timer, uint32_t timeout_us, uint32_t period_us);
+void		Soft_Timer_Stop(soft_timer_t* timer);
+bool		Soft_Timer_Is_Running(const soft_timer_t* timer);
+
+#endif /* INC_SOFT_TIMER_H_ */
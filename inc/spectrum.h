@@ -0,0 +1,31 @@
+#ifndef _SPECTRUM_H_
+#define _SPECTRUM_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/**
+ * NOTE:	The spectrum analyser shows the outgoing samples as 16 bars on the 16x2 HD44780. The DAC refill interrupt only
+ * 			copies SPECTRUM_FFT_SIZE mono samples (L + R) / 2 every SPECTRUM_CAPTURE_PERIOD frames, all the rest is done
+ * 			by Spectrum_Process() in the main loop: the Hann window, the radix-4 Q15 FFT (every stage is scaled by 1/4, so
+ * 			it never overflows), 16 bands of the log spaced bins (3dB per bar level) and the bars drawn with 8 custom
+ * 			characters over two lines. The main loop work is preempted by the refill interrupt, so it can never starve
+ * 			the DAC; its length is bounded by SPECTRUM_CYCLE_BUDGET and by SPECTRUM_LCD_WRITES_PER_CALL (each LCD write
+ * 			waits for the display), so the SD card streaming is not held up for long either.
+ */
+
+#define SPECTRUM_FFT_SIZE				(uint16_t)256			//	Power of 4
+#define SPECTRUM_FFT_STAGES				(uint8_t)4				//	log4(SPECTRUM_FFT_SIZE)
+#define SPECTRUM_BANDS					(uint8_t)16				//	One per LCD column
+#define SPECTRUM_LEVELS					(uint8_t)16				//	Two lines of 8 pixel rows
+#define SPECTRUM_CAPTURE_PERIOD			(uint32_t)2205			//	Frames between the captures, 20 refreshes per second at 44.1kHz
+#define SPECTRUM_FLOOR_BITS				(uint8_t)8				//	log2 of the band power shown as the level 0, the level step is 1 bit (3dB)
+#define SPECTRUM_LCD_WRITES_PER_CALL	(uint8_t)8				//	Characters updated by one Spectrum_Process() call
+#define SPECTRUM_CYCLE_BUDGET			(uint32_t)40000			//	Max. CPU cycles of the analysis of one capture
+
+void		Spectrum_Init(void);
+void		Spectrum_Capture(const uint32_t* words, uint32_t frames);
+void		Spectrum_Process(void);
+uint32_t	Spectrum_Benchmark(void);
+
+#endif
@@ -0,0 +1,93 @@
+#ifndef INC_TIMEBASE_H_
+#define INC_TIMEBASE_H_
+
+#include "stm32f4xx.h"
+#include "RCC.h"
+#include <stdbool.h>
+
+/**
+ * NOTE:	The timebase is a free running microsecond counter shared by all the drivers, so a driver can timestamp an
+ * 			event or wait for a timeout without owning a timer (TIM_Delay takes the whole basic timer, counts only up to
+ * 			655ms and serves one caller at a time). TIMEBASE_TIMER is one of the 32 bit timers (TIM2 or TIM5), its counter
+ * 			is the lower 32 bits of the time and wraps every ~71.6 minutes. The update interrupt counts the wraps, which
+ * 			are the upper 32 bits of Time_Now_us64().
+ * 			The 32 bit values are compared modulo 2^32 (Time_Is_After etc.), so they stay right across the wrap as long
+ * 			as the compared times are less than 2^31us (~35.8 minutes) apart.
+ * 			Time_Init may be called by each driver which uses the timebase, only the first call starts the timer.
+ * 			The compare channel 1 of the timer is the alarm - a single one shot compare which calls back at the given time.
+ * 			It belongs to the software timers (soft_timer.h), which reprogram it to their nearest expiry.
+ * 			The interrupt runs below the audio DMA interrupts, the wrap which is still pending is counted by Time_Now_us64
+ * 			itself, so the time read in the higher priority interrupts is right too.
+ */
+
+#define TIMEBASE_TIMER						TIM5			//	TIM2 or TIM5, TIM5_IRQHandler has to follow the change
+#define TIMEBASE_TIMER_IRQn					TIM5_IRQn
+#define TIMEBASE_TIMER_CLOCK_HZ				(uint32_t)(2*APB1*1000000)
+#define TIMEBASE_PRESCALER					(uint32_t)(TIMEBASE_TIMER_CLOCK_HZ/1000000 - 1)	//	1us resolution
+#define TIMEBASE_IRQ_PRIORITY				2				//	The audio DMA streams use 1
+
+/**
+ * The function called from the timebase interrupt when the alarm time comes.
+ */
+typedef void (*time_alarm_callback_f)(void);
+
+void		Time_Init(void);
+uint64_t	Time_Now_us64(void);
+void		Time_Busy_Wait_us(uint32_t delay_us);
+void		Time_Alarm_Set(uint32_t at_us, time_alarm_callback_f callback);
+void		Time_Alarm_Cancel(void);
+void		TIM5_IRQHandler(void);
+
+/**
+ * \brief	Returns the lower 32 bits of the time since Time_Init.
+ */
+static inline uint32_t Time_Now_us(void)
+{
+	return TIMEBASE_TIMER->CNT;
+}
+
+/**
+ * \brief	Returns the time which passed since the start timestamp. Valid up to ~71.6 minutes.
+ * \param start_us[IN]	-	the timestamp taken with Time_Now_us
+ */
+static inline uint32_t Time_Elapsed_us(uint32_t start_us)
+{
+	return Time_Now_us() - start_us;
+}
+
+/**
+ * \brief	Wrap-safe comparison of two timestamps.
+ * \return	true if the time a_us is later than b_us
+ */
+static inline bool Time_Is_After(uint32_t a_us, uint32_t b_us)
+{
+	return (int32_t)(a_us - b_us) > 0;
+}
+
+/**
+ * \brief	Wrap-safe comparison of two timestamps.
+ * \return	true if the time a_us is earlier than b_us
+ */
+static inline bool Time_Is_Before(uint32_t a_us, uint32_t b_us)
+{
+	return (int32_t)(a_us - b_us) < 0;
+}
+
+/**
+ * \brief	Returns the deadline of the timeout started now, for Time_Is_Expired.
+ * \param timeout_us[IN]	-	the timeout, less than 2^31us
+ */
+static inline uint32_t Time_Deadline_us(uint32_t timeout_us)
+{
+	return Time_Now_us() + timeout_us;
+}
+
+/**
+ * \brief	Checks if the deadline given by Time_Deadline_us has passed.
+ */
+static inline bool Time_Is_Expired(uint32_t deadline_us)
+{
+	return (int32_t)(Time_Now_us() - deadline_us) >= 0;
+}
+
+#endif /* INC_TIMEBASE_H_ */
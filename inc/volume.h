@@ -0,0 +1,26 @@
+#ifndef _VOLUME_H_
+#define _VOLUME_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/**
+ * NOTE:	The volume stage works on the DAC words (DHR12LD layout) in the DAC refill interrupt, so the volume change is
+ * 			heard after one buffer half. The gain is Q15 and changes linearly over one refilled block, which removes the
+ * 			zipper noise of the step changes. The volume has VOLUME_STEPS steps of 2dB, the step 0 is mute.
+ */
+
+#define VOLUME_STEPS				(uint8_t)32
+#define VOLUME_DEFAULT_STEP			(uint8_t)(VOLUME_STEPS - 1)		//	0dB - the samples are not changed
+#define VOLUME_UNITY_GAIN			(int32_t)32767
+#define VOLUME_CYCLE_BUDGET			(uint32_t)16					//	Max. CPU cycles per stereo frame, during the ramp
+
+void		Volume_Set_Step(uint8_t step);
+uint8_t		Volume_Get_Step(void);
+void		Volume_Up(void);
+void		Volume_Down(void);
+bool		Volume_Execute_Remote_Command(uint8_t command);
+void		Volume_Process(uint32_t* words, uint32_t frames);
+uint32_t	Volume_Benchmark(void);
+
+#endif
@@ -0,0 +1,83 @@
+#ifndef _WAV_H_
+#define _WAV_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "audio_ring.h"
+#include "resampler.h"
+#include "ima_adpcm.h"
+
+/**
+ * NOTE:	The WAV parser is a streaming stage between the SD card stream ring (raw file bytes) and the playback ring
+ * 			(DAC samples). It takes only as many bytes from the input as it can handle at once, so the RIFF headers and the
+ * 			samples may be split at any place, e.g. on the sector boundaries. Only the header fields are buffered.
+ * 			The playback ring holds the samples in the DAC format: uint32_t DHR12LD words, mono files are played on both
+ * 			channels. IMA ADPCM files are decoded here too, group by group, so the card reads a quarter of the bytes.
+ */
+
+#define WAV_FORMAT_PCM					(uint16_t)0x0001
+#define WAV_FORMAT_IMA_ADPCM			(uint16_t)0x0011
+#define WAV_FORMAT_EXTENSIBLE			(uint16_t)0xFFFE
+
+#define WAV_FMT_SIZE					(uint8_t)16		//	The PCM part of the fmt chunk
+#define WAV_FMT_EXTENSIBLE_SIZE			(uint8_t)40		//	The fmt chunk of WAV_FORMAT_EXTENSIBLE, ends with the SubFormat GUID
+#define WAV_HEADER_BUFFER_SIZE			WAV_FMT_EXTENSIBLE_SIZE	//	The longest parsed header
+#define WAV_WORK_BUFFER_SIZE			(uint16_t)192	//	Multiple of every supported block align (1, 2, 3, 4, 6)
+#define WAV_OUTPUT_SAMPLE_RATE			44100			//	The fixed DAC rate, other rates are resampled. 0 - the DAC follows the file rate
+#define WAV_OUTPUT_DAC					0				//	The on-chip DAC, both channels
+#define WAV_OUTPUT_I2S					1				//	The external codec on I2S
+#define WAV_OUTPUT_PWM					2				//	The PWM on TIM1 channel 1, mono
+#define WAV_OUTPUT						WAV_OUTPUT_DAC	//	The playback output
+
+typedef enum
+{
+	WAV_STATE_RIFF_HEADER,		//	Waiting for "RIFF" <size> "WAVE"
+	WAV_STATE_CHUNK_HEADER,		//	Waiting for <id> <size> of the next chunk
+	WAV_STATE_FMT,				//	Reading the fmt chunk fields
+	WAV_STATE_SKIP,				//	Skipping the rest of the chunk
+	WAV_STATE_DATA,				//	Converting the samples
+	WAV_STATE_FLUSH,			//	Putting the rest of the resampler history in the playback ring
+	WAV_STATE_DONE,				//	All the samples were put in the playback ring
+	WAV_STATE_ERROR				//	Not a WAV file or not supported format
+}wav_state_e;
+
+typedef struct
+{
+	uint16_t		format_tag;
+	uint16_t		channels;
+	uint32_t		sample_rate;
+	uint16_t		block_align;
+	uint16_t		bits_per_sample;
+}wav_format_t;
+
+typedef struct
+{
+	wav_state_e		state;
+	wav_format_t	format;
+	audio_ring_t*	output;								/*< The playback ring */
+	uint8_t			header[WAV_HEADER_BUFFER_SIZE];		/*< The fields of the header which is read */
+	uint8_t			header_index;						/*< Number of header bytes already collected */
+	uint8_t			header_size;						/*< Number of header bytes to collect */
+	uint32_t		chunk_remaining;					/*< Bytes left in the current chunk (with the pad byte) */
+	uint16_t		unit_size;							/*< The smallest decodable part of the data: PCM frame or ADPCM group */
+	uint32_t		block_remaining;					/*< Bytes left in the current ADPCM block */
+	ima_adpcm_t		adpcm;
+	bool			format_found;						/*< True if the fmt chunk was parsed */
+	bool			resample;							/*< True if the file rate differs from WAV_OUTPUT_SAMPLE_RATE */
+	resampler_t		resampler;
+	uint16_t		flush_frames;						/*< The silent frames still to push through the resampler at the end */
+	bool			playing;							/*< True if the playback was started by the parser or goes on from the previous file */
+	bool			configured;							/*< True if the DAC playback was configured for the file */
+	bool			queued;								/*< True if the file follows the previous one in the playback ring */
+	bool			held;								/*< True if the queued file waits for the previous one */
+}wav_parser_t;
+
+void			Wav_Parser_Init(wav_parser_t* parser, audio_ring_t* output);
+void			Wav_Parser_Queue(wav_parser_t* parser, audio_ring_t* output);
+void			Wav_Parser_Release(wav_parser_t* parser);
+void			Wav_Playback_Stop(void);
+bool			Wav_Playback_Is_Drained(void);
+wav_state_e		Wav_Parser_Process(wav_parser_t* parser, audio_ring_t* input);
+uint32_t		Wav_Playback_Refill(void* buffer, uint32_t samples);
+
+#endif
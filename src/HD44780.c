@@ -151,6 +151,23 @@ void LCD_GoTo(unsigned char line, unsigned char position)
 	LCD_WriteCommand(LCD_GOTO_COMMAND + position + line*0x40);
 }
 
+/**
+ * 	This function defines the custom 5x8 character in the CGRAM.
+ * 	The character is displayed by writing its code with LCD_WriteData().
+ * 	Afterwards the cursor must be set again with LCD_GoTo(),
+ * 	because the data are written to the CGRAM until then.
+ *
+ * 	@param code - the character code, 0 to LCD_CUSTOM_CHARACTERS - 1
+ * 	@param rows - 8 rows of the character, from the top. The lower 5 bits are the pixels
+ */
+void LCD_Define_Character(unsigned char code, const char* rows)
+{
+	//	Each character takes 8 bytes of the CGRAM
+	LCD_WriteCommand(LCD_SET_CGRAM_ADDRESS + (code & 0x07) * 8);
+	for(unsigned char row = 0; row < 8; row++)
+		LCD_WriteData(rows[row] & 0x1F);
+}
+
 /**
  * 	This functions writes a string (char array) to the LCD Display.
  *
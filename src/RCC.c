@@ -119,4 +119,26 @@ void RCC_SetClockFrequency(uint32_t PLLM, uint32_t PLLN, uint32_t PLLQ, uint32_t
 
 }
 
+/**
+ *	@brief This function configures and turns on the PLLI2S which clocks the I2S. It takes the same input as the main PLL
+ *	(HSE / PLLM), so RCC_SetClockFrequency must be called first.
+ *	@param PLLI2SN - the value of PLLI2SN multiplier, the VCO output must be 100 to 432MHz
+ *	@param PLLI2SR - the value of PLLI2SR divider (2 to 7), the I2S clock must not exceed 192MHz
+ */
+void RCC_SetI2SClockFrequency(uint32_t PLLI2SN, uint32_t PLLI2SR)
+{
+	//	The PLLI2S can be configured only when it is off
+	RCC->CR &= ~RCC_CR_PLLI2SON;
+	do
+	{}while((RCC->CR & RCC_CR_PLLI2SRDY) == RCC_CR_PLLI2SRDY);
+
+	RCC->PLLI2SCFGR = (PLLI2SN << 6) | (PLLI2SR << 28);
+	//	The I2S is clocked by the PLLI2S, not by the external I2S_CKIN
+	RCC->CFGR &= ~RCC_CFGR_I2SSRC;
+	//	Turn on the PLLI2S and wait till it is locked
+	RCC->CR |= RCC_CR_PLLI2SON;
+	do
+	{}while((RCC->CR & RCC_CR_PLLI2SRDY) != RCC_CR_PLLI2SRDY);
+}
+
 
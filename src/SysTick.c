@@ -6,21 +6,64 @@
  */
 
 #include "SysTick.h"
+#include "dsp.h"
 #include <stdbool.h>
 
 
-uint32_t 			systick_delay;
+volatile uint64_t	systick_delay;				/*< The core clock cycles left after the current SysTick load */
 volatile bool		systick_delay_completed;
 
+/**
+ *  \brief	This function waits actively the given number of the core clock cycles, counted by the DWT cycle counter.
+ *  		It is meant for the waits too short for SysTick_Delay to sleep, also the ones below a microsecond.
+ *  \param cycles - the requested delay, given in the core clock cycles
+ */
+void SysTick_Delay_Cycles(uint32_t cycles)
+{
+	uint32_t start;
+
+	Dsp_Enable_Cycle_Counter();
+
+	start = DWT->CYCCNT;
+	while(DWT->CYCCNT - start < cycles);
+}
+
 /**
  *  \brief	This function implements a simple delay function using the system timer - SysTick.
+ *  		SysTick is loaded once with the delay and the core sleeps until its interrupt.
  *  \param delay_us - the requested delay, given in microseconds
  */
 void SysTick_Delay(uint32_t delay_us)
 {
+	uint64_t cycles = (uint64_t)delay_us * SYSTICK_CYCLES_PER_US;
+	uint32_t first_load;
+
+	if(cycles < SYSTICK_SPIN_CYCLES)
+	{
+		SysTick_Delay_Cycles((uint32_t)cycles);
+		return;
+	}
+
+	//	The part which does not fill the whole counter goes first, the full loads follow
+	first_load = (uint32_t)(cycles % SYSTICK_MAX_LOAD);
+	if(first_load == 0)
+		first_load = SYSTICK_MAX_LOAD;
+	systick_delay = cycles - first_load;
+	//	SysTick can not count less than 2 cycles and such a short load would only cost an interrupt
+	if(first_load < SYSTICK_SPIN_CYCLES)
+	{
+		SysTick_Delay_Cycles(first_load);
+		first_load = SYSTICK_MAX_LOAD;
+		systick_delay -= SYSTICK_MAX_LOAD;
+	}
+
 	systick_delay_completed = false;
-	// Load the delay value in the working variable
-	systick_delay = delay_us;
+	SysTick->CTRL = 0;
+	SysTick->LOAD = first_load - 1;
+	SysTick->VAL = 0;
+	//	Count the core clock
+	SysTick->CTRL = SysTick_CTRL_CLKSOURCE_Msk | SysTick_CTRL_TICKINT_Msk | SysTick_CTRL_ENABLE_Msk;
+
 	//	Wait until the requested time passes
 	while(!systick_delay_completed)
 	{
@@ -29,17 +72,21 @@ void SysTick_Delay(uint32_t delay_us)
 }
 
 /**
- * \brief SysTick interrupt handler. It's only job is to decrease the systick_delay variable
+ * \brief SysTick interrupt handler. It comes once per SysTick load and stops SysTick at the end of the delay.
  */
 void SysTick_Handler()
 {
-	/*if(sd_card_timer_proc_counter == 10)
+	if(systick_delay == 0)
 	{
-		disk_timerproc();
-		sd_card_timer_proc_counter = 0;
-	}*/
-
-	systick_delay--;
-	if(systick_delay == 0)	//	Set the flag indicating that delay time passed. It is more safe than just decreasing systick_delay if by some way the while loop in SysTick_Delay function skips 2 ticks because of IRQ overload
+		//	No interrupt comes until the next delay
+		SysTick->CTRL = 0;
 		systick_delay_completed = true;
+	}
+	else
+	{
+		//	The counter has already reloaded the previous load, it is restarted with the full range
+		SysTick->LOAD = SYSTICK_MAX_LOAD - 1;
+		SysTick->VAL = 0;
+		systick_delay -= SYSTICK_MAX_LOAD;
+	}
 }
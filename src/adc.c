@@ -0,0 +1,217 @@
+#include "stm32f4xx.h"
+#include <stdbool.h>
+#include "adc.h"
+#include "GPIO.h"
+#include "RCC.h"
+#include "TIM.h"
+
+static uint16_t					adc_capture_buffer[2 * ADC_CAPTURE_HALF_BUFFER_SAMPLES];	/*< Ping-pong buffer, both halves written by one circular DMA transfer */
+static adc_capture_callback_f	adc_capture_callback;										/*< Function taking the finished half of the buffer */
+static uint32_t					adc_capture_half_frames;									/*< Sequences in one half of the buffer */
+static uint8_t					adc_capture_channel_count;									/*< Conversions in one sequence */
+static volatile uint32_t		adc_capture_overruns;										/*< Sequences lost because the DMA was late */
+
+
+/**
+ * \brief This function sets the pin of the ADC channel as analog. The internal channels have no pin, they are switched on in the common register.
+ */
+static void ADC_Capture_Configure_Channel(uint8_t channel)
+{
+	if(channel < 8)
+	{
+		RCC->AHB1ENR |= RCC_AHB1ENR_GPIOAEN;
+		GPIO_Analog_Configure(GPIOA, PIN_0 << (2 * channel));
+	}
+	else if(channel < 10)
+	{
+		RCC->AHB1ENR |= RCC_AHB1ENR_GPIOBEN;
+		GPIO_Analog_Configure(GPIOB, PIN_0 << (2 * (channel - 8)));
+	}
+	else if(channel < 16)
+	{
+		RCC->AHB1ENR |= RCC_AHB1ENR_GPIOCEN;
+		GPIO_Analog_Configure(GPIOC, PIN_0 << (2 * (channel - 10)));
+	}
+	else if(channel == ADC_CHANNEL_VBAT)
+	{
+		ADC->CCR |= ADC_CCR_VBATE;
+	}
+	else
+	{
+		ADC->CCR |= ADC_CCR_TSVREFE;
+	}
+
+	//	The same sample time for all channels, SMPR2 keeps the channels 0-9 and SMPR1 the channels 10-18
+	if(channel < 10)
+		ADC_CAPTURE_ADC->SMPR2 |= ADC_CAPTURE_SAMPLE_TIME << (3 * channel);
+	else
+		ADC_CAPTURE_ADC->SMPR1 |= ADC_CAPTURE_SAMPLE_TIME << (3 * (channel - 10));
+}
+
+/**
+ * \brief This function stops the stream. The stream sets the complete transfer flag when it is disabled, so its interrupts are
+ * 			turned off first and the flags are cleared after, otherwise the callback would get the unfinished half.
+ */
+static void ADC_Capture_Stop_Stream(void)
+{
+	ADC_CAPTURE_DMA_STREAM->CR &= ~(DMA_SxCR_EN | DMA_SxCR_HTIE | DMA_SxCR_TCIE | DMA_SxCR_TEIE);
+	while(ADC_CAPTURE_DMA_STREAM->CR & DMA_SxCR_EN);
+	//	Clear the stream 0 flags
+	ADC_CAPTURE_DMA->LIFCR = DMA_LIFCR_CTCIF0 | DMA_LIFCR_CHTIF0 | DMA_LIFCR_CTEIF0 | DMA_LIFCR_CDMEIF0 | DMA_LIFCR_CFEIF0;
+}
+
+/**
+ * \brief This function (re)starts the stream at the beginning of the buffer
+ */
+static void ADC_Capture_Start_Stream(void)
+{
+	ADC_Capture_Stop_Stream();
+	ADC_CAPTURE_DMA_STREAM->NDTR = 2 * adc_capture_half_frames * adc_capture_channel_count;
+	ADC_CAPTURE_DMA_STREAM->CR |= DMA_SxCR_HTIE | DMA_SxCR_TCIE | DMA_SxCR_TEIE | DMA_SxCR_EN;
+}
+
+/**
+ * \brief This function configures the capture engine: ADC_CAPTURE_TIMER starts the scan of the given channels at the sample rate
+ * 			and the DMA moves the conversions from the ADC to the ping-pong buffer. The CPU is interrupted only when a half of the buffer
+ * 			has been written, so the callback can take it while the DMA writes the other half.
+ *
+ * \param sample_rate_hz[IN]	-	the rate of the sequences (frames)
+ * \param channels[IN]			-	the channels in the sequence order
+ * \param channel_count[IN]		-	the length of the sequence, 1 to ADC_CAPTURE_MAX_CHANNELS
+ * \param callback[IN]			-	the function which takes the conversions
+ *
+ * \return	the real sample rate in Hz, the trigger period is a whole number of the timer clocks, 0 if the sequence length is wrong
+ */
+uint32_t ADC_Capture_Init(uint32_t sample_rate_hz, const uint8_t* channels, uint8_t channel_count, adc_capture_callback_f callback)
+{
+	uint32_t period;
+	uint32_t prescaler;
+
+	if((channel_count == 0) || (channel_count > ADC_CAPTURE_MAX_CHANNELS))
+		return 0;
+
+	//	Turn on the clock for the timer, the ADC and DMA2
+	RCC->APB1ENR |= RCC_APB1ENR_TIM3EN;
+	RCC->APB2ENR |= RCC_APB2ENR_ADC1EN;
+	RCC->AHB1ENR |= RCC_AHB1ENR_DMA2EN;
+
+	ADC_Capture_Stop();
+	adc_capture_callback = callback;
+	adc_capture_channel_count = channel_count;
+	//	Every half holds whole sequences, so the callback never gets a broken frame
+	adc_capture_half_frames = ADC_CAPTURE_HALF_BUFFER_SAMPLES / channel_count;
+	adc_capture_overruns = 0;
+
+	//	ADC clock = PCLK2 / 4, 21MHz at 84MHz APB2 (36MHz max)
+	ADC->CCR = ADC_CCR_ADCPRE_0;
+	ADC_CAPTURE_ADC->CR2 = 0;
+	ADC_CAPTURE_ADC->SMPR1 = 0;
+	ADC_CAPTURE_ADC->SMPR2 = 0;
+	ADC_CAPTURE_ADC->SQR3 = 0;
+	for(uint8_t i = 0; i < channel_count; i++)
+	{
+		ADC_Capture_Configure_Channel(channels[i]);
+		ADC_CAPTURE_ADC->SQR3 |= (uint32_t)channels[i] << (5 * i);
+	}
+	ADC_CAPTURE_ADC->SQR1 = (uint32_t)(channel_count - 1) << 20;
+	//	12 bit resolution, scan of the whole sequence on one trigger, interrupt on the overrun
+	ADC_CAPTURE_ADC->CR1 = ADC_CR1_SCAN | ADC_CR1_OVRIE;
+	//	Start on the rising edge of the trigger, DMA request after every conversion, also after the DMA transfer is complete (circular mode)
+	ADC_CAPTURE_ADC->CR2 = ADC_CR2_EXTEN_0 | (ADC_CAPTURE_TIMER_TRIGGER << 24) | ADC_CR2_DMA | ADC_CR2_DDS | ADC_CR2_ADON;
+
+	//	Configure the trigger timer, TRGO on every update. The prescaler is used only when the period does not fit in 16 bits
+	TIM_Basic_Continuous_Counting(ADC_CAPTURE_TIMER, 0xFFFF);
+	period = (ADC_CAPTURE_TIMER_CLOCK_HZ + sample_rate_hz/2) / sample_rate_hz;
+	prescaler = (period - 1) >> 16;
+	period = ((ADC_CAPTURE_TIMER_CLOCK_HZ / (prescaler + 1)) + sample_rate_hz/2) / sample_rate_hz;
+	ADC_CAPTURE_TIMER->PSC = prescaler;
+	ADC_CAPTURE_TIMER->ARR = period - 1;
+	ADC_CAPTURE_TIMER->EGR = TIM_EGR_UG;
+
+	//	Configure the stream: peripheral to memory, circular, memory increment, 16 bit transfers. The interrupts are enabled at the start
+	ADC_CAPTURE_DMA_STREAM->CR = (ADC_CAPTURE_DMA_CHANNEL << 25) | DMA_SxCR_PL_1 | DMA_SxCR_MINC | DMA_SxCR_CIRC
+								| DMA_SxCR_MSIZE_0 | DMA_SxCR_PSIZE_0;
+	ADC_CAPTURE_DMA_STREAM->PAR = (uint32_t)&ADC_CAPTURE_ADC->DR;
+	ADC_CAPTURE_DMA_STREAM->M0AR = (uint32_t)adc_capture_buffer;
+	//	Direct mode, no FIFO
+	ADC_CAPTURE_DMA_STREAM->FCR = 0;
+
+	NVIC_SetPriority(ADC_CAPTURE_DMA_IRQn, 1);
+	NVIC_EnableIRQ(ADC_CAPTURE_DMA_IRQn);
+	NVIC_SetPriority(ADC_IRQn, 1);
+	NVIC_EnableIRQ(ADC_IRQn);
+
+	return ADC_CAPTURE_TIMER_CLOCK_HZ / ((prescaler + 1) * period);
+}
+
+/**
+ * \brief This function starts the DMA and the trigger timer. The first half is given to the callback after ADC_CAPTURE_HALF_BUFFER_SAMPLES conversions.
+ */
+void ADC_Capture_Start(void)
+{
+	ADC_Capture_Start_Stream();
+
+	TIM_Clear(ADC_CAPTURE_TIMER);
+	TIM_Start(ADC_CAPTURE_TIMER);
+}
+
+/**
+ * \brief This function stops the trigger timer and the DMA. The conversions of the unfinished half are lost.
+ */
+void ADC_Capture_Stop(void)
+{
+	TIM_Stop(ADC_CAPTURE_TIMER);
+	ADC_Capture_Stop_Stream();
+}
+
+/**
+ * \brief This function returns the number of the overruns since the init. Every overrun loses the unfinished half of the buffer.
+ */
+uint32_t ADC_Capture_Get_Overruns(void)
+{
+	return adc_capture_overruns;
+}
+
+/**
+ * \brief The DMA interrupt. After the half transfer the DMA writes the second half, so the first one is given to the callback and after the complete transfer - the second one.
+ */
+void DMA2_Stream0_IRQHandler(void)
+{
+	uint32_t flags = ADC_CAPTURE_DMA->LISR;
+
+	if(flags & DMA_LISR_HTIF0)
+	{
+		ADC_CAPTURE_DMA->LIFCR = DMA_LIFCR_CHTIF0;
+		if(adc_capture_callback != 0)
+			adc_capture_callback(adc_capture_buffer, adc_capture_half_frames);
+	}
+	if(flags & DMA_LISR_TCIF0)
+	{
+		ADC_CAPTURE_DMA->LIFCR = DMA_LIFCR_CTCIF0;
+		if(adc_capture_callback != 0)
+			adc_capture_callback(adc_capture_buffer + adc_capture_half_frames * adc_capture_channel_count, adc_capture_half_frames);
+	}
+	if(flags & DMA_LISR_TEIF0)
+	{
+		//	Transfer error disables the stream, start it again
+		ADC_CAPTURE_DMA->LIFCR = DMA_LIFCR_CTEIF0;
+		ADC_CAPTURE_DMA_STREAM->CR |= DMA_SxCR_EN;
+	}
+}
+
+/**
+ * \brief The ADC interrupt, only the overrun is enabled. The ADC stops the DMA requests after the overrun, so the DMA bit and the stream
+ * 			are set again. The next trigger starts the sequence from its first channel and the stream from the first half, so the frames
+ * 			stay aligned. The conversions of the unfinished half are lost.
+ */
+void ADC_IRQHandler(void)
+{
+	if(ADC_CAPTURE_ADC->SR & ADC_SR_OVR)
+	{
+		adc_capture_overruns++;
+		ADC_CAPTURE_ADC->CR2 &= ~ADC_CR2_DMA;
+		ADC_CAPTURE_ADC->SR &= ~ADC_SR_OVR;
+		ADC_Capture_Start_Stream();
+		ADC_CAPTURE_ADC->CR2 |= ADC_CR2_DMA;
+	}
+}
@@ -0,0 +1,112 @@
+#include "audio_ring.h"
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+
+/**
+ * \brief This function initializes the audio ring. It should be done only once for one ring.
+ *
+ * \param ring[IN]			-	the ring to initialize
+ * \param buffer[IN]		-	the buffer which will be connected with the ring. It must be a global array
+ * \param buffer_size[IN]	-	the size of the buffer in bytes. It must be a power of 2
+ *
+ * \return	true	-	if the ring was initialized
+ * 			false	-	if the buffer size is not a power of 2
+ */
+bool Audio_Ring_Init(audio_ring_t* ring, uint8_t* buffer, uint32_t buffer_size)
+{
+	//	The indices are wrapped with a mask, so only the power of 2 sizes are allowed
+	if((buffer_size == 0) || (buffer_size & (buffer_size - 1)))
+		return false;
+
+	ring->buffer = buffer;
+	ring->buffer_size = buffer_size;
+	ring->index_mask = buffer_size - 1;
+	Audio_Ring_Clear(ring);
+
+	return true;
+}
+
+/**
+ * \brief This function discards all the data held in the ring
+ */
+void Audio_Ring_Clear(audio_ring_t* ring)
+{
+	ring->write_index = 0;
+	ring->read_index = 0;
+}
+
+/**
+ * \brief This function returns the number of bytes which can be taken from the ring
+ */
+uint32_t Audio_Ring_Get_Data_Size(audio_ring_t* ring)
+{
+	//	The indices run freely, so the unsigned difference is valid even after they wrap
+	return ring->write_index - ring->read_index;
+}
+
+/**
+ * \brief This function returns the number of bytes which can be put in the ring
+ */
+uint32_t Audio_Ring_Get_Free_Space(audio_ring_t* ring)
+{
+	return ring->buffer_size - Audio_Ring_Get_Data_Size(ring);
+}
+
+/**
+ * \brief This function copies the data in the ring. If there is not enough free space only the part which fits is copied.
+ *
+ * \param ring[IN]		-	the ring to be filled
+ * \param data[IN]		-	the data to put in the ring
+ * \param data_size[IN]	-	the number of bytes to put
+ *
+ * \return	the number of bytes which were really put in the ring
+ */
+uint32_t Audio_Ring_Put(audio_ring_t* ring, const uint8_t* data, uint32_t data_size)
+{
+	uint32_t free_space = Audio_Ring_Get_Free_Space(ring);
+	uint32_t offset = ring->write_index & ring->index_mask;
+	uint32_t first_part;
+
+	if(data_size > free_space)
+		data_size = free_space;
+	//	Copy the data till the end of the buffer and the rest from its beginning
+	first_part = ring->buffer_size - offset;
+	if(first_part > data_size)
+		first_part = data_size;
+	memcpy(ring->buffer + offset, data, first_part);
+	memcpy(ring->buffer, data + first_part, data_size - first_part);
+	//	Publish the data only after it is copied
+	ring->write_index += data_size;
+
+	return data_size;
+}
+
+/**
+ * \brief This function takes the data from the ring. If there is not enough data only the available part is copied.
+ *
+ * \param ring[IN]		-	the ring to be read
+ * \param data[OUT]		-	the buffer where the data is to be stored
+ * \param data_size[IN]	-	the number of bytes to get
+ *
+ * \return	the number of bytes which were really taken from the ring
+ */
+uint32_t Audio_Ring_Get(audio_ring_t* ring, uint8_t* data, uint32_t data_size)
+{
+	uint32_t available = Audio_Ring_Get_Data_Size(ring);
+	uint32_t offset = ring->read_index & ring->index_mask;
+	uint32_t first_part;
+
+	if(data_size > available)
+		data_size = available;
+	//	Copy the data till the end of the buffer and the rest from its beginning
+	first_part = ring->buffer_size - offset;
+	if(first_part > data_size)
+		first_part = data_size;
+	memcpy(data, ring->buffer + offset, first_part);
+	memcpy(data + first_part, ring->buffer, data_size - first_part);
+	//	Release the space only after the data is copied
+	ring->read_index += data_size;
+
+	return data_size;
+}
@@ -9,6 +9,12 @@
 #include <stdbool.h>
 #include "dac.h"
 #include "GPIO.h"
+#include "RCC.h"
+#include "TIM.h"
+
+static uint32_t					dac_playback_buffer[2 * DAC_PLAYBACK_HALF_BUFFER_SAMPLES];	/*< Ping-pong buffer, both halves read by one circular DMA transfer */
+static dac_playback_refill_f	dac_playback_refill;										/*< Function filling the half of the buffer which is free */
+static bool						dac_playback_stereo;										/*< True if DHR12LD is fed, false if DHR12L1 */
 
 
 /**
@@ -27,7 +33,7 @@ void DAC_DeInit(void)
  * \param[IN]	-	channel_conf  - the channel which is to be configured (1, 2 or both)
  * \param[IN]	-	output_buffer_used - true if the output buffer is required
  */
-void DAC_Init( dac_channels_conf_e channel_conf, uint8_t conv_trig_sel, bool output_buffer_used)
+void DAC_Init(uint8_t conv_trig_sel, dac_channels_conf_e channel_conf, bool output_buffer_used)
 {
 	//	Set the DAC out pins as analog pins
 	GPIO_Analog_Configure(GPIOA, PIN_4 | PIN_5);
@@ -114,3 +120,179 @@ inline void DAC_Put_Data_Dual_8bit(uint16_t data)
 {
 	DAC->DHR8RD = data;
 }
+
+/**
+ * \brief This function sets the wave generated by the DAC itself. The wave is added to the DHR value on every conversion trigger,
+ * 			so the trigger must not be the software one and the DHR value sets the offset of the wave.
+ *
+ * \param[IN]	-	channel_conf - the channel which is to be configured (1, 2 or both)
+ * \param[IN]	-	wave - the generated wave, dac_wave_none for the normal conversion
+ * \param[IN]	-	amplitude_bits - the bits of the LFSR taken for the noise or the triangle amplitude 2^amplitude_bits - 1, from 1 to 12
+ */
+void DAC_Set_Wave(dac_channels_conf_e channel_conf, dac_wave_e wave, uint8_t amplitude_bits)
+{
+	uint32_t settings = ((uint32_t)wave << 6) | ((uint32_t)(amplitude_bits - 1) << 8);
+	uint32_t mask = DAC_CR_WAVE1 | DAC_CR_MAMP1;
+
+	if(wave == dac_wave_none)
+		settings = 0;
+
+	if(channel_conf == dac_dual_channel_simultanous)
+	{
+		settings |= settings << 16;
+		mask |= mask << 16;
+	}
+	else
+	{
+		settings <<= channel_conf;
+		mask <<= channel_conf;
+	}
+
+	DAC->CR = (DAC->CR & ~mask) | settings;
+}
+
+/**
+ * \brief This function fills the given half of the playback buffer using the refill function. The samples it did not give are replaced with silence.
+ */
+static void DAC_Playback_Refill(uint32_t half)
+{
+	uint32_t filled = 0;
+
+	if(dac_playback_stereo)
+	{
+		uint32_t* buffer = dac_playback_buffer + half * DAC_PLAYBACK_HALF_BUFFER_SAMPLES;
+
+		if(dac_playback_refill != 0)
+			filled = dac_playback_refill(buffer, DAC_PLAYBACK_HALF_BUFFER_SAMPLES);
+		for(; filled < DAC_PLAYBACK_HALF_BUFFER_SAMPLES; filled++)
+			buffer[filled] = ((uint32_t)DAC_PLAYBACK_SILENCE << 16) | DAC_PLAYBACK_SILENCE;
+	}
+	else
+	{
+		//	Mono samples are half words, so the buffer halves are half as long in bytes
+		uint16_t* buffer = (uint16_t*)dac_playback_buffer + half * DAC_PLAYBACK_HALF_BUFFER_SAMPLES;
+
+		if(dac_playback_refill != 0)
+			filled = dac_playback_refill(buffer, DAC_PLAYBACK_HALF_BUFFER_SAMPLES);
+		for(; filled < DAC_PLAYBACK_HALF_BUFFER_SAMPLES; filled++)
+			buffer[filled] = DAC_PLAYBACK_SILENCE;
+	}
+}
+
+/**
+ * \brief This function configures the playback engine: DAC_PLAYBACK_TIMER generates the conversion trigger at the sample rate and the DMA
+ * 			moves the samples from the ping-pong buffer to DHR12L1 (mono) or DHR12LD (stereo). The CPU is interrupted only when a half of the buffer
+ * 			has been sent, so it can be refilled while the DMA reads the other half.
+ *
+ * \param sample_rate_hz[IN]	-	the output sample rate
+ * \param stereo[IN]			-	true to drive both DAC channels
+ * \param refill[IN]			-	the function which gives the samples
+ */
+void DAC_Playback_Init(uint32_t sample_rate_hz, bool stereo, dac_playback_refill_f refill)
+{
+	//	Turn on the clock for the DAC and DMA1
+	RCC->APB1ENR |= RCC_APB1ENR_DACEN;
+	RCC->AHB1ENR |= RCC_AHB1ENR_DMA1EN;
+
+	DAC_Playback_Stop();
+	dac_playback_refill = refill;
+	dac_playback_stereo = stereo;
+
+	//	Configure the trigger timer, TRGO on every update. The update is forced before the DAC is enabled, to load the prescaler
+	TIM_Basic_Continuous_Counting(DAC_PLAYBACK_TIMER, 0xFFFF);
+	DAC_Playback_Set_Sample_Rate(sample_rate_hz);
+	DAC_PLAYBACK_TIMER->EGR = TIM_EGR_UG;
+
+	//	The conversions are triggered by TIM6 TRGO, the DMA request is generated by the channel 1 for both modes
+	DAC_DeInit();
+	DAC_Init(dac_trigger_tim6, stereo ? dac_dual_channel_simultanous : dac_channel_1, false);
+	DAC->CR |= DAC_CR_DMAEN1;
+
+	//	Configure the stream: memory to peripheral, circular, memory increment, half and complete interrupts
+	DAC_PLAYBACK_DMA_STREAM->CR = 0;
+	while(DAC_PLAYBACK_DMA_STREAM->CR & DMA_SxCR_EN);
+	DAC_PLAYBACK_DMA_STREAM->CR = (DAC_PLAYBACK_DMA_CHANNEL << 25) | DMA_SxCR_PL_1 | DMA_SxCR_MINC | DMA_SxCR_CIRC | DMA_SxCR_DIR_0
+								| DMA_SxCR_HTIE | DMA_SxCR_TCIE | DMA_SxCR_TEIE;
+	if(stereo)
+	{
+		//	32 bit transfers, both channels at once
+		DAC_PLAYBACK_DMA_STREAM->CR |= DMA_SxCR_MSIZE_1 | DMA_SxCR_PSIZE_1;
+		DAC_PLAYBACK_DMA_STREAM->PAR = (uint32_t)&DAC->DHR12LD;
+	}
+	else
+	{
+		//	16 bit transfers
+		DAC_PLAYBACK_DMA_STREAM->CR |= DMA_SxCR_MSIZE_0 | DMA_SxCR_PSIZE_0;
+		DAC_PLAYBACK_DMA_STREAM->PAR = (uint32_t)&DAC->DHR12L1;
+	}
+	DAC_PLAYBACK_DMA_STREAM->M0AR = (uint32_t)dac_playback_buffer;
+	DAC_PLAYBACK_DMA_STREAM->NDTR = 2 * DAC_PLAYBACK_HALF_BUFFER_SAMPLES;
+	//	Direct mode, no FIFO
+	DAC_PLAYBACK_DMA_STREAM->FCR = 0;
+
+	NVIC_SetPriority(DAC_PLAYBACK_DMA_IRQn, 1);
+	NVIC_EnableIRQ(DAC_PLAYBACK_DMA_IRQn);
+}
+
+/**
+ * \brief This function sets the sample rate of the playback. The trigger timer runs with the full timer clock, so the rate error
+ * 			is below 0.03% at 44.1kHz.
+ *
+ * \param sample_rate_hz[IN]	-	the output sample rate
+ */
+void DAC_Playback_Set_Sample_Rate(uint32_t sample_rate_hz)
+{
+	//	No prescaler, the period is rounded to the nearest timer clock cycle
+	DAC_PLAYBACK_TIMER->PSC = 0;
+	DAC_PLAYBACK_TIMER->ARR = (DAC_PLAYBACK_TIMER_CLOCK_HZ + sample_rate_hz/2) / sample_rate_hz - 1;
+}
+
+/**
+ * \brief This function fills both halves of the buffer and starts the DMA and the trigger timer
+ */
+void DAC_Playback_Start(void)
+{
+	DAC_Playback_Refill(0);
+	DAC_Playback_Refill(1);
+
+	//	Clear the stream 5 flags and enable the stream
+	DMA1->HIFCR = DMA_HIFCR_CTCIF5 | DMA_HIFCR_CHTIF5 | DMA_HIFCR_CTEIF5 | DMA_HIFCR_CDMEIF5 | DMA_HIFCR_CFEIF5;
+	DAC_PLAYBACK_DMA_STREAM->CR |= DMA_SxCR_EN;
+
+	TIM_Clear(DAC_PLAYBACK_TIMER);
+	TIM_Start(DAC_PLAYBACK_TIMER);
+}
+
+/**
+ * \brief This function stops the trigger timer and the DMA. The DAC holds the last sample.
+ */
+void DAC_Playback_Stop(void)
+{
+	TIM_Stop(DAC_PLAYBACK_TIMER);
+	DAC_PLAYBACK_DMA_STREAM->CR &= ~DMA_SxCR_EN;
+}
+
+/**
+ * \brief The DMA interrupt. After the half transfer the DMA reads the second half, so the first one is refilled and after the complete transfer - the second one.
+ */
+void DMA1_Stream5_IRQHandler(void)
+{
+	uint32_t flags = DMA1->HISR;
+
+	if(flags & DMA_HISR_HTIF5)
+	{
+		DMA1->HIFCR = DMA_HIFCR_CHTIF5;
+		DAC_Playback_Refill(0);
+	}
+	if(flags & DMA_HISR_TCIF5)
+	{
+		DMA1->HIFCR = DMA_HIFCR_CTCIF5;
+		DAC_Playback_Refill(1);
+	}
+	if(flags & DMA_HISR_TEIF5)
+	{
+		//	Transfer error disables the stream, start it again
+		DMA1->HIFCR = DMA_HIFCR_CTEIF5;
+		DAC_PLAYBACK_DMA_STREAM->CR |= DMA_SxCR_EN;
+	}
+}
@@ -0,0 +1,307 @@
+#include "dds.h"
+#include "dac.h"
+#include "TIM.h"
+#include "dsp.h"
+#include <stdint.h>
+#include <stdbool.h>
+#include <math.h>
+
+#define DDS_SAMPLE_OFFSET			(uint16_t)0x8000	//	The middle of the DAC range, left aligned
+#define DDS_SWEEP_FACTOR_BITS		(uint8_t)30			//	Q30 growth of the frequency word per sample
+#define DDS_DAC_RANGE				(uint32_t)4096
+
+static int16_t				dds_sine[DDS_TABLE_SIZE + 1];						/*< The tables with the guard entry */
+static int16_t				dds_square[DDS_TABLE_SIZE + 1];
+static int16_t				dds_triangle[DDS_TABLE_SIZE + 1];
+static const int16_t*		dds_arbitrary = dds_sine;							/*< The table given by the user */
+static const int16_t*		dds_table = dds_sine;								/*< The table of the current wave */
+static uint32_t				dds_sample_rate;									/*< The DAC rate, the frequency word is relative to it */
+static uint32_t				dds_frequency = 1000;								/*< The last set frequency in Hz */
+static uint32_t				dds_phase;											/*< The phase accumulator, the full turn is 2^32 */
+static volatile uint32_t	dds_increment;										/*< The frequency word, added to the phase every sample */
+static volatile int16_t		dds_amplitude = DDS_FULL_SCALE;						/*< Q15 gain of the table */
+static int32_t				dds_sweep_step;										/*< The change of the frequency word per sample, linear sweep */
+static uint32_t				dds_sweep_factor;									/*< Q30 factor of the frequency word per sample, 0 for the linear sweep */
+static uint32_t				dds_sweep_end;										/*< The frequency word at the end of the sweep */
+static volatile uint32_t	dds_sweep_remaining;								/*< The samples to the end of the sweep, 0 if not sweeping */
+
+
+/**
+ * \brief This function converts the frequency to the frequency word at the current sample rate
+ */
+static uint32_t Dds_Frequency_To_Increment(uint32_t frequency_hz)
+{
+	if(dds_sample_rate == 0)
+		return 0;
+
+	return (uint32_t)((((uint64_t)frequency_hz << 32) + dds_sample_rate/2) / dds_sample_rate);
+}
+
+/**
+ * \brief This function fills the built-in tables, one period each, the guard entry repeats the first one
+ */
+static void Dds_Compute_Tables(void)
+{
+	const float pi = 3.14159265f;
+
+	for(uint32_t i = 0; i <= DDS_TABLE_SIZE; i++)
+	{
+		uint32_t index = i % DDS_TABLE_SIZE;
+
+		dds_sine[i] = (int16_t)lrintf(DDS_FULL_SCALE * sinf(2 * pi * index / DDS_TABLE_SIZE));
+		dds_square[i] = (index < DDS_TABLE_SIZE / 2) ? DDS_FULL_SCALE : -DDS_FULL_SCALE;
+		//	Starts at 0 and goes up, like the sine
+		if(index < DDS_TABLE_SIZE / 4)
+			dds_triangle[i] = (int16_t)((int32_t)DDS_FULL_SCALE * 4 * index / DDS_TABLE_SIZE);
+		else if(index < 3 * DDS_TABLE_SIZE / 4)
+			dds_triangle[i] = (int16_t)((int32_t)DDS_FULL_SCALE * (2 * (int32_t)DDS_TABLE_SIZE - 4 * (int32_t)index) / (int32_t)DDS_TABLE_SIZE);
+		else
+			dds_triangle[i] = (int16_t)((int32_t)DDS_FULL_SCALE * (4 * (int32_t)index - 4 * (int32_t)DDS_TABLE_SIZE) / (int32_t)DDS_TABLE_SIZE);
+	}
+}
+
+/**
+ * \brief This function starts the generator on the DAC playback, it takes the DAC from the other users (e.g. the WAV playback).
+ * 			Both DAC channels give the same signal.
+ *
+ * \param sample_rate_hz[IN]	-	the DAC rate, the highest generated frequency is half of it
+ */
+void Dds_Start(uint32_t sample_rate_hz)
+{
+	DAC_Playback_Stop();
+	Dds_Compute_Tables();
+
+	dds_sample_rate = sample_rate_hz;
+	dds_sweep_remaining = 0;
+	dds_increment = Dds_Frequency_To_Increment(dds_frequency);
+	dds_phase = 0;
+
+	//	The DAC init turns off the hardware wave, if it was on
+	DAC_Playback_Init(sample_rate_hz, true, Dds_Refill);
+	DAC_Playback_Start();
+}
+
+/**
+ * \brief This function stops the DAC, both the table and the hardware generation
+ */
+void Dds_Stop(void)
+{
+	DAC_Playback_Stop();
+	DAC_Set_Wave(dac_dual_channel_simultanous, dac_wave_none, 1);
+}
+
+/**
+ * \brief This function selects the table, the phase goes on, so the wave changes without a gap
+ */
+void Dds_Set_Wave(dds_wave_e wave)
+{
+	switch(wave)
+	{
+		case DDS_WAVE_SQUARE:
+			dds_table = dds_square;
+			break;
+		case DDS_WAVE_TRIANGLE:
+			dds_table = dds_triangle;
+			break;
+		case DDS_WAVE_ARBITRARY:
+			dds_table = dds_arbitrary;
+			break;
+		default:
+			dds_table = dds_sine;
+			break;
+	}
+}
+
+/**
+ * \brief This function sets the table of DDS_WAVE_ARBITRARY and selects it. The table is used in place, so it must stay valid while it is played.
+ *
+ * \param table[IN]	-	one period in DDS_TABLE_SIZE samples and the guard entry equal to the first one
+ */
+void Dds_Set_Wavetable(const int16_t* table)
+{
+	dds_arbitrary = table;
+	dds_table = table;
+}
+
+/**
+ * \brief This function sets the frequency, the sweep in progress is stopped
+ */
+void Dds_Set_Frequency(uint32_t frequency_hz)
+{
+	dds_sweep_remaining = 0;
+	dds_frequency = frequency_hz;
+	dds_increment = Dds_Frequency_To_Increment(frequency_hz);
+}
+
+/**
+ * \brief This function sets the Q15 gain of the table, DDS_FULL_SCALE for the full DAC range
+ */
+void Dds_Set_Amplitude(int16_t amplitude)
+{
+	dds_amplitude = amplitude;
+}
+
+/**
+ * \brief This function starts the sweep of the frequency. The frequency word changes every sample, it is exactly the end one when the sweep ends.
+ * 			The generator has to be started, the rate is needed for the frequency words.
+ *
+ * \param start_hz[IN]		-	the frequency at the beginning
+ * \param end_hz[IN]		-	the frequency at the end, it stays after the sweep
+ * \param duration_ms[IN]	-	the time of the sweep
+ * \param exponential[IN]	-	true for the same time per octave (the log sweep), false for the same Hz per sample
+ */
+void Dds_Sweep(uint32_t start_hz, uint32_t end_hz, uint32_t duration_ms, bool exponential)
+{
+	uint32_t	samples = (uint32_t)(((uint64_t)dds_sample_rate * duration_ms) / 1000);
+	uint32_t	start = Dds_Frequency_To_Increment(start_hz);
+
+	//	The interrupt does not sweep while the parameters are changed
+	dds_sweep_remaining = 0;
+	dds_frequency = end_hz;
+	dds_sweep_end = Dds_Frequency_To_Increment(end_hz);
+
+	if((samples == 0) || (start == 0) || (start == dds_sweep_end))
+	{
+		dds_increment = dds_sweep_end;
+		return;
+	}
+
+	if(exponential)
+	{
+		//	The factor is so close to 1 that the float would lose the sweep rate, it is computed once in double
+		dds_sweep_factor = (uint32_t)(exp(log((double)dds_sweep_end / start) / samples) * (1 << DDS_SWEEP_FACTOR_BITS) + 0.5);
+	}
+	else
+	{
+		dds_sweep_factor = 0;
+		dds_sweep_step = ((int32_t)dds_sweep_end - (int32_t)start) / (int32_t)samples;
+	}
+	dds_increment = start;
+	dds_sweep_remaining = samples;
+}
+
+/**
+ * \brief This function checks whether the sweep is in progress
+ */
+bool Dds_Is_Sweeping(void)
+{
+	return (dds_sweep_remaining != 0);
+}
+
+/**
+ * \brief This function makes the DAC generate the noise or the triangle by itself, the CPU does not take part. Both channels
+ * 			get the wave, centred in the DAC range. The conversion trigger must be between DAC_PLAYBACK_TIMER_CLOCK_HZ / 65536 and 1MHz.
+ *
+ * \param wave[IN]				-	dac_wave_noise or dac_wave_triangle
+ * \param amplitude_bits[IN]	-	the peak to peak amplitude of 2^amplitude_bits - 1 DAC steps, from 1 to 12
+ * \param frequency_hz[IN]		-	the triangle frequency, for the noise - the rate of the new values
+ *
+ * \return	the real frequency, 0 if the trigger rate for it can not be set
+ */
+uint32_t Dds_Start_Hardware(dac_wave_e wave, uint8_t amplitude_bits, uint32_t frequency_hz)
+{
+	//	The triangle counter goes from 0 to the amplitude and back, one step per trigger
+	uint32_t	steps = (wave == dac_wave_triangle) ? 2 * ((1 << amplitude_bits) - 1) : 1;
+	uint32_t	trigger_hz = frequency_hz * steps;
+	uint32_t	offset = (DDS_DAC_RANGE - (1 << amplitude_bits)) / 2;
+
+	if((trigger_hz == 0) || (trigger_hz > 1000000) || (trigger_hz < DAC_PLAYBACK_TIMER_CLOCK_HZ / 65536))
+		return 0;
+
+	Dds_Stop();
+	RCC->APB1ENR |= RCC_APB1ENR_DACEN;
+
+	TIM_Basic_Continuous_Counting(DAC_PLAYBACK_TIMER, 0xFFFF);
+	DAC_Playback_Set_Sample_Rate(trigger_hz);
+	DAC_PLAYBACK_TIMER->EGR = TIM_EGR_UG;
+
+	DAC_DeInit();
+	DAC_Init(dac_trigger_tim6, dac_dual_channel_simultanous, false);
+	DAC_Set_Wave(dac_dual_channel_simultanous, wave, amplitude_bits);
+	//	The DHR value is the bottom of the wave
+	DAC_Put_Data_Dual_12bit_R((offset << 16) | offset);
+
+	TIM_Clear(DAC_PLAYBACK_TIMER);
+	TIM_Start(DAC_PLAYBACK_TIMER);
+
+	return DAC_PLAYBACK_TIMER_CLOCK_HZ / ((DAC_PLAYBACK_TIMER->ARR + 1) * steps);
+}
+
+/**
+ * \brief The DAC refill function. It interpolates the table at the phase of every sample and puts the same sample on both channels.
+ *
+ * \param buffer	-	the half of the DAC buffer, DHR12LD words
+ * \param frames	-	the number of the words to put
+ *
+ * \return	frames, the generator never runs out of data
+ */
+uint32_t Dds_Refill(void* buffer, uint32_t frames)
+{
+	uint32_t*		words = buffer;
+	const int16_t*	table = dds_table;
+	uint32_t		phase = dds_phase;
+	uint32_t		increment = dds_increment;
+	uint32_t		remaining = dds_sweep_remaining;
+	int32_t			amplitude = dds_amplitude;
+
+	for(uint32_t i = 0; i < frames; i++)
+	{
+		uint32_t	index = phase >> (32 - DDS_TABLE_BITS);
+		int32_t		fraction = (phase >> (32 - DDS_TABLE_BITS - DDS_FRACTION_BITS)) & ((1 << DDS_FRACTION_BITS) - 1);
+		int32_t		sample = table[index] + (((table[index + 1] - table[index]) * fraction) >> DDS_FRACTION_BITS);
+		uint32_t	word = (uint16_t)(((sample * amplitude) >> 15) ^ DDS_SAMPLE_OFFSET);
+
+		words[i] = (word << 16) | word;
+		phase += increment;
+
+		if(remaining != 0)
+		{
+			if(dds_sweep_factor != 0)
+				increment = (uint32_t)(((uint64_t)increment * dds_sweep_factor + (1 << (DDS_SWEEP_FACTOR_BITS - 1))) >> DDS_SWEEP_FACTOR_BITS);
+			else
+				increment += dds_sweep_step;
+			//	No rounding error is left at the end
+			if(--remaining == 0)
+				increment = dds_sweep_end;
+		}
+	}
+
+	dds_phase = phase;
+	dds_increment = increment;
+	dds_sweep_remaining = remaining;
+
+	return frames;
+}
+
+#if defined(DWT)
+/**
+ * \brief This function measures the generator with the DWT cycle counter, during the exponential sweep, it is the slowest
+ * 			case. The user settings are restored afterwards.
+ *
+ * \return	CPU cycles per stereo frame, it should not be above DDS_CYCLE_BUDGET
+ */
+uint32_t Dds_Benchmark(void)
+{
+	static uint32_t		words[DDS_BENCHMARK_FRAMES];
+	uint32_t			sample_rate = dds_sample_rate;
+	uint32_t			frequency = dds_frequency;
+	uint32_t			start;
+	uint32_t			cycles;
+
+	Dds_Compute_Tables();
+	dds_sample_rate = 44100;
+	Dds_Sweep(20, 20000, 10000, true);
+
+	Dsp_Enable_Cycle_Counter();
+
+	start = DWT->CYCCNT;
+	Dds_Refill(words, DDS_BENCHMARK_FRAMES);
+	cycles = DWT->CYCCNT - start;
+
+	//	Back to the user settings
+	dds_sample_rate = sample_rate;
+	Dds_Set_Frequency(frequency);
+
+	return cycles / DDS_BENCHMARK_FRAMES;
+}
+#endif
@@ -0,0 +1,135 @@
+#include "dither.h"
+#include "dsp.h"
+#include <stdint.h>
+
+#define DITHER_DAC_OFFSET			(uint32_t)0x80008000	//	The middle of the range in both lanes
+#define DITHER_DAC_MASK				(uint32_t)0xFFF0FFF0	//	The 12 bits converted by the DAC in both lanes
+#define DITHER_NOISE_MASK			(uint32_t)0x000F000F	//	One uniform value (0 to 15) in both lanes
+#define DITHER_NOISE_BIAS			(uint32_t)0x00070007	//	-15 centers the sum of two values, +8 rounds instead of the truncation
+
+static volatile dither_mode_e	dither_mode = DITHER_DEFAULT_MODE;	/*< The chosen mode */
+static uint32_t					dither_random = 0x2545F491;			/*< The LFSR state, it can not be 0 */
+static uint32_t					dither_error_1;						/*< The last requantization error of both lanes */
+static uint32_t					dither_error_2;						/*< The requantization error before the last one */
+
+/**
+ * \brief This function sets the dither mode. It takes effect from the next refilled block.
+ */
+void Dither_Set_Mode(dither_mode_e mode)
+{
+	dither_mode = mode;
+}
+
+/**
+ * \brief This function returns the chosen dither mode
+ */
+dither_mode_e Dither_Get_Mode(void)
+{
+	return dither_mode;
+}
+
+/**
+ * \brief This function gives the TPDF noise for both lanes. One xorshift32 step (the LFSR with the period 2^32 - 1, three
+ * 			shifts and three XORs) gives the 4 bit uniform values, two of them are summed in each lane with SADD16.
+ *
+ * \return	the noise of -7 to 23 in both lanes (1/16 of the DAC step)
+ */
+static inline uint32_t Dither_Noise(void)
+{
+	uint32_t random = dither_random;
+
+	random ^= random << 13;
+	random ^= random >> 17;
+	random ^= random << 5;
+	dither_random = random;
+
+	return Dsp_Ssub16(Dsp_Sadd16(random & DITHER_NOISE_MASK, (random >> 4) & DITHER_NOISE_MASK), DITHER_NOISE_BIAS);
+}
+
+/**
+ * \brief This function dithers the block of the DAC words. It is called in the DAC refill interrupt. The lanes are moved to the
+ * 			signed range, so the noise and the error feedback are added with the saturation (QADD16/QSUB16).
+ *
+ * \param words[IN/OUT]	-	the DAC words (DHR12LD layout)
+ * \param frames[IN]	-	the number of the words
+ */
+void Dither_Process(uint32_t* words, uint32_t frames)
+{
+	uint32_t error_1 = dither_error_1;
+	uint32_t error_2 = dither_error_2;
+
+	switch(dither_mode)
+	{
+		case DITHER_MODE_TPDF:
+		{
+			//	The lower bits are dropped by the DAC
+			for(uint32_t i = 0; i < frames; i++)
+				words[i] = Dsp_Sadd16(Dsp_Qadd16(Dsp_Ssub16(words[i], DITHER_DAC_OFFSET), Dither_Noise()), DITHER_DAC_OFFSET);
+			break;
+		}
+		case DITHER_MODE_TPDF_SHAPED_1:
+		{
+			//	The output is x + e[n] - e[n-1]
+			for(uint32_t i = 0; i < frames; i++)
+			{
+				uint32_t wanted = Dsp_Qsub16(Dsp_Ssub16(words[i], DITHER_DAC_OFFSET), error_1);
+				uint32_t output = Dsp_Qadd16(wanted, Dither_Noise()) & DITHER_DAC_MASK;
+
+				error_1 = Dsp_Ssub16(output, wanted);
+				words[i] = Dsp_Sadd16(output, DITHER_DAC_OFFSET);
+			}
+			break;
+		}
+		case DITHER_MODE_TPDF_SHAPED_2:
+		{
+			//	The output is x + e[n] - 2 * e[n-1] + e[n-2]
+			for(uint32_t i = 0; i < frames; i++)
+			{
+				uint32_t feedback = Dsp_Ssub16(Dsp_Sadd16(error_1, error_1), error_2);
+				uint32_t wanted = Dsp_Qsub16(Dsp_Ssub16(words[i], DITHER_DAC_OFFSET), feedback);
+				uint32_t output = Dsp_Qadd16(wanted, Dither_Noise()) & DITHER_DAC_MASK;
+
+				error_2 = error_1;
+				error_1 = Dsp_Ssub16(output, wanted);
+				words[i] = Dsp_Sadd16(output, DITHER_DAC_OFFSET);
+			}
+			break;
+		}
+		default:
+			break;
+	}
+
+	dither_error_1 = error_1;
+	dither_error_2 = error_2;
+}
+
+#if defined(DWT)
+/**
+ * \brief This function measures the dither processing time with the DWT cycle counter
+ *
+ * \param mode[IN]	-	the measured mode
+ *
+ * \return	CPU cycles per stereo frame, it should not be above DITHER_CYCLE_BUDGET
+ */
+uint32_t Dither_Benchmark(dither_mode_e mode)
+{
+	static uint32_t	words[DITHER_BENCHMARK_FRAMES];
+	dither_mode_e	user_mode = dither_mode;
+	uint32_t		start;
+	uint32_t		cycles;
+
+	for(uint32_t i = 0; i < DITHER_BENCHMARK_FRAMES; i++)
+		words[i] = (i * 256) | ((65535 - i * 256) << 16);
+
+	Dsp_Enable_Cycle_Counter();
+
+	dither_mode = mode;
+	start = DWT->CYCCNT;
+	Dither_Process(words, DITHER_BENCHMARK_FRAMES);
+	cycles = DWT->CYCCNT - start;
+	//	Back to the user mode
+	dither_mode = user_mode;
+
+	return cycles / DITHER_BENCHMARK_FRAMES;
+}
+#endif
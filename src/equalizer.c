@@ -0,0 +1,367 @@
+#include "equalizer.h"
+#include "dsp.h"
+#include "NEC_remote_controller.h"
+#include <stdint.h>
+#include <stdbool.h>
+#include <math.h>
+
+#define EQUALIZER_DAC_OFFSET		(uint32_t)0x80008000	//	The middle of the range in both lanes
+#define EQUALIZER_COEFFICIENT_BITS	(uint8_t)28				//	Q28 coefficients, -8 to 8
+#define EQUALIZER_ROUNDING			((int64_t)1 << (EQUALIZER_COEFFICIENT_BITS - 1))
+#define EQUALIZER_CHANNELS			(uint8_t)2
+
+typedef struct
+{
+	equalizer_filter_e	filter;
+	uint16_t			frequency;		/*< The shelf or the peak frequency in Hz */
+	float				q;				/*< The quality factor, 0.707 gives the shelf without the overshoot */
+	int8_t				gain;			/*< In dB */
+}equalizer_band_t;
+
+typedef struct
+{
+	int32_t	b0;
+	int32_t	b1;
+	int32_t	b2;
+	int32_t	a1;		/*< Negated, so all five products are accumulated */
+	int32_t	a2;		/*< Negated */
+}equalizer_coefficients_t;
+
+typedef struct
+{
+	int32_t	x1;
+	int32_t	x2;
+	int32_t	y1;
+	int32_t	y2;
+}equalizer_state_t;
+
+/*< The bands: bass, middle and treble */
+static equalizer_band_t equalizer_bands[EQUALIZER_BANDS] =
+{
+	{EQUALIZER_FILTER_LOW_SHELF, 100, 0.707f, 0},
+	{EQUALIZER_FILTER_PEAKING, 1000, 0.7f, 0},
+	{EQUALIZER_FILTER_HIGH_SHELF, 8000, 0.707f, 0}
+};
+
+static equalizer_coefficients_t	equalizer_coefficients[2][EQUALIZER_BANDS];		/*< Two sets, one is used by the interrupt, the other one is prepared */
+static uint8_t					equalizer_masks[2];								/*< The bands processed with the set, bit n - band n */
+static volatile uint8_t			equalizer_active_set;							/*< The set taken by the next block */
+static uint8_t					equalizer_used_set;								/*< The set used by the last block */
+static equalizer_state_t		equalizer_state[EQUALIZER_BANDS][EQUALIZER_CHANNELS];	/*< The filter history of both channels */
+static uint32_t					equalizer_sample_rate = EQUALIZER_DEFAULT_RATE;	/*< The DAC sample rate */
+static bool						equalizer_enabled = true;						/*< False - all bands are bypassed */
+static uint8_t					equalizer_selected_band;						/*< The band changed by the remote controller */
+
+/**
+ * \brief This function converts the coefficient to Q28
+ */
+static int32_t Equalizer_To_Q28(float value)
+{
+	return (int32_t)lrintf(value * (float)(1 << EQUALIZER_COEFFICIENT_BITS));
+}
+
+/**
+ * \brief This function computes the biquad coefficients of the band (RBJ audio EQ cookbook), normalized by a0
+ */
+static void Equalizer_Compute_Coefficients(const equalizer_band_t* band, equalizer_coefficients_t* coefficients)
+{
+	const float pi = 3.14159265f;
+	float		a = powf(10.0f, band->gain / 40.0f);
+	float		w0 = 2 * pi * band->frequency / equalizer_sample_rate;
+	float		cos_w0 = cosf(w0);
+	float		alpha = sinf(w0) / (2 * band->q);
+	float		shelf = 2 * sqrtf(a) * alpha;
+	float		b0, b1, b2, a0, a1, a2;
+
+	switch(band->filter)
+	{
+		case EQUALIZER_FILTER_LOW_SHELF:
+			b0 = a * ((a + 1) - (a - 1) * cos_w0 + shelf);
+			b1 = 2 * a * ((a - 1) - (a + 1) * cos_w0);
+			b2 = a * ((a + 1) - (a - 1) * cos_w0 - shelf);
+			a0 = (a + 1) + (a - 1) * cos_w0 + shelf;
+			a1 = -2 * ((a - 1) + (a + 1) * cos_w0);
+			a2 = (a + 1) + (a - 1) * cos_w0 - shelf;
+			break;
+		case EQUALIZER_FILTER_HIGH_SHELF:
+			b0 = a * ((a + 1) + (a - 1) * cos_w0 + shelf);
+			b1 = -2 * a * ((a - 1) + (a + 1) * cos_w0);
+			b2 = a * ((a + 1) + (a - 1) * cos_w0 - shelf);
+			a0 = (a + 1) - (a - 1) * cos_w0 + shelf;
+			a1 = 2 * ((a - 1) - (a + 1) * cos_w0);
+			a2 = (a + 1) - (a - 1) * cos_w0 - shelf;
+			break;
+		default:
+			b0 = 1 + alpha * a;
+			b1 = -2 * cos_w0;
+			b2 = 1 - alpha * a;
+			a0 = 1 + alpha / a;
+			a1 = -2 * cos_w0;
+			a2 = 1 - alpha / a;
+			break;
+	}
+
+	coefficients->b0 = Equalizer_To_Q28(b0 / a0);
+	coefficients->b1 = Equalizer_To_Q28(b1 / a0);
+	coefficients->b2 = Equalizer_To_Q28(b2 / a0);
+	coefficients->a1 = Equalizer_To_Q28(-a1 / a0);
+	coefficients->a2 = Equalizer_To_Q28(-a2 / a0);
+}
+
+/**
+ * \brief This function prepares the coefficients of all bands in the set, which is not used by the interrupt, and hands
+ * 			it over. The interrupt takes it at the start of the next block. It is called only from the main context.
+ */
+static void Equalizer_Update(void)
+{
+	uint8_t set = equalizer_active_set ^ 1;
+	uint8_t mask = 0;
+
+	for(uint8_t band = 0; band < EQUALIZER_BANDS; band++)
+	{
+		if(!equalizer_enabled || (equalizer_bands[band].gain == 0))
+			continue;
+		Equalizer_Compute_Coefficients(&equalizer_bands[band], &equalizer_coefficients[set][band]);
+		mask |= 1 << band;
+	}
+	equalizer_masks[set] = mask;
+	equalizer_active_set = set;
+}
+
+/**
+ * \brief This function sets the sample rate of the DAC playback, the coefficients are computed again
+ *
+ * \param sample_rate[IN]	-	the rate in Hz
+ */
+void Equalizer_Set_Sample_Rate(uint32_t sample_rate)
+{
+	if(sample_rate == equalizer_sample_rate)
+		return;
+
+	equalizer_sample_rate = sample_rate;
+	Equalizer_Update();
+}
+
+/**
+ * \brief This function changes the filter of the band. The gain is kept.
+ *
+ * \param band[IN]		-	the band number, 0 to EQUALIZER_BANDS - 1
+ * \param filter[IN]	-	the filter type
+ * \param frequency[IN]	-	the shelf or the peak frequency in Hz, below the half of the sample rate
+ * \param q[IN]			-	the quality factor
+ */
+void Equalizer_Configure_Band(uint8_t band, equalizer_filter_e filter, uint16_t frequency, float q)
+{
+	if(band >= EQUALIZER_BANDS)
+		return;
+
+	equalizer_bands[band].filter = filter;
+	equalizer_bands[band].frequency = frequency;
+	equalizer_bands[band].q = q;
+	Equalizer_Update();
+}
+
+/**
+ * \brief This function sets the gain of the band. The new coefficients are used from the next refilled block.
+ *
+ * \param band[IN]	-	the band number, 0 to EQUALIZER_BANDS - 1
+ * \param gain[IN]	-	the gain in dB, -EQUALIZER_MAX_GAIN to EQUALIZER_MAX_GAIN. 0 - the band is bypassed
+ */
+void Equalizer_Set_Gain(uint8_t band, int8_t gain)
+{
+	if(band >= EQUALIZER_BANDS)
+		return;
+	if(gain > EQUALIZER_MAX_GAIN)
+		gain = EQUALIZER_MAX_GAIN;
+	if(gain < -EQUALIZER_MAX_GAIN)
+		gain = -EQUALIZER_MAX_GAIN;
+
+	equalizer_bands[band].gain = gain;
+	Equalizer_Update();
+}
+
+/**
+ * \brief This function returns the gain of the band in dB
+ */
+int8_t Equalizer_Get_Gain(uint8_t band)
+{
+	return (band < EQUALIZER_BANDS) ? equalizer_bands[band].gain : 0;
+}
+
+/**
+ * \brief This function turns the equalizer on or off. The band gains are kept.
+ */
+void Equalizer_Set_Enabled(bool enabled)
+{
+	equalizer_enabled = enabled;
+	Equalizer_Update();
+}
+
+/**
+ * \brief This function returns true if the equalizer is on
+ */
+bool Equalizer_Is_Enabled(void)
+{
+	return equalizer_enabled;
+}
+
+/**
+ * \brief This function returns the band changed by the remote controller
+ */
+uint8_t Equalizer_Get_Selected_Band(void)
+{
+	return equalizer_selected_band;
+}
+
+/**
+ * \brief This function executes the equalizer commands of the remote controller. It should be called for every command taken from the remote command fifo.
+ * 			CH selects the next band, after the last band the equalizer is turned off and the next CH turns it on with the
+ * 			first band. CH+ and CH- change the gain of the selected band by EQUALIZER_GAIN_STEP.
+ *
+ * \param command[IN]	-	the received NEC command
+ *
+ * \return	true if it was the equalizer command
+ */
+bool Equalizer_Execute_Remote_Command(uint8_t command)
+{
+	switch(command)
+	{
+		case NEC_CH:
+			if(!equalizer_enabled)
+			{
+				equalizer_selected_band = 0;
+				Equalizer_Set_Enabled(true);
+			}
+			else if(++equalizer_selected_band == EQUALIZER_BANDS)
+			{
+				Equalizer_Set_Enabled(false);
+			}
+			return true;
+		case NEC_CH_PLUS:
+			if(equalizer_enabled)
+				Equalizer_Set_Gain(equalizer_selected_band, equalizer_bands[equalizer_selected_band].gain + EQUALIZER_GAIN_STEP);
+			return true;
+		case NEC_CH_MINUS:
+			if(equalizer_enabled)
+				Equalizer_Set_Gain(equalizer_selected_band, equalizer_bands[equalizer_selected_band].gain - EQUALIZER_GAIN_STEP);
+			return true;
+		default:
+			return false;
+	}
+}
+
+/**
+ * \brief This function filters one sample with the Direct Form I biquad:
+ * 			y[n] = b0 * x[n] + b1 * x[n-1] + b2 * x[n-2] - a1 * y[n-1] - a2 * y[n-2]
+ */
+static inline int32_t Equalizer_Biquad(const equalizer_coefficients_t* coefficients, equalizer_state_t* state, int32_t x)
+{
+	int64_t acc = EQUALIZER_ROUNDING;
+	int32_t y;
+
+	acc = Dsp_Smlal(acc, coefficients->b0, x);
+	acc = Dsp_Smlal(acc, coefficients->b1, state->x1);
+	acc = Dsp_Smlal(acc, coefficients->b2, state->x2);
+	acc = Dsp_Smlal(acc, coefficients->a1, state->y1);
+	acc = Dsp_Smlal(acc, coefficients->a2, state->y2);
+	y = (int32_t)(acc >> EQUALIZER_COEFFICIENT_BITS);
+
+	state->x2 = state->x1;
+	state->x1 = x;
+	state->y2 = state->y1;
+	state->y1 = y;
+
+	return y;
+}
+
+/**
+ * \brief This function filters the block of the DAC words. It is called in the DAC refill interrupt. With all bands at
+ * 			0dB (or the equalizer off) the block is not touched at all.
+ *
+ * \param words[IN/OUT]	-	the DAC words (DHR12LD layout)
+ * \param frames[IN]	-	the number of the words
+ */
+void Equalizer_Process(uint32_t* words, uint32_t frames)
+{
+	uint8_t								set = equalizer_active_set;
+	uint8_t								mask = equalizer_masks[set];
+	const equalizer_coefficients_t*		coefficients = equalizer_coefficients[set];
+
+	if(set != equalizer_used_set)
+	{
+		//	The bands which were bypassed start from the silence, not from the old history
+		for(uint8_t band = 0; band < EQUALIZER_BANDS; band++)
+		{
+			if((mask & ~equalizer_masks[equalizer_used_set]) & (1 << band))
+			{
+				equalizer_state[band][0] = (equalizer_state_t){0};
+				equalizer_state[band][1] = (equalizer_state_t){0};
+			}
+		}
+		equalizer_used_set = set;
+	}
+	if(mask == 0)
+		return;
+
+	for(uint32_t i = 0; i < frames; i++)
+	{
+		uint32_t	lanes = Dsp_Ssub16(words[i], EQUALIZER_DAC_OFFSET);
+		//	Q15 in the top half word is Q31, shifted down for the headroom
+		int32_t		left = (int32_t)(lanes << 16) >> EQUALIZER_HEADROOM_BITS;
+		int32_t		right = (int32_t)(lanes & 0xFFFF0000) >> EQUALIZER_HEADROOM_BITS;
+
+		for(uint8_t band = 0; band < EQUALIZER_BANDS; band++)
+		{
+			if(!(mask & (1 << band)))
+				continue;
+			left = Equalizer_Biquad(&coefficients[band], &equalizer_state[band][0], left);
+			right = Equalizer_Biquad(&coefficients[band], &equalizer_state[band][1], right);
+		}
+
+		left = Dsp_Saturate_Q15(left >> (16 - EQUALIZER_HEADROOM_BITS));
+		right = Dsp_Saturate_Q15(right >> (16 - EQUALIZER_HEADROOM_BITS));
+		words[i] = Dsp_Sadd16(Dsp_Pkhbt(left, right, 16), EQUALIZER_DAC_OFFSET);
+	}
+}
+
+#if defined(DWT)
+/**
+ * \brief This function measures the equalizer with the DWT cycle counter. All bands are turned on for the measurement,
+ * 			the user settings are restored afterwards.
+ *
+ * \return	CPU cycles per sample (one channel) per band, it should not be above EQUALIZER_CYCLE_BUDGET
+ */
+uint32_t Equalizer_Benchmark(void)
+{
+	static uint32_t	words[EQUALIZER_BENCHMARK_FRAMES];
+	int8_t			gains[EQUALIZER_BANDS];
+	bool			enabled = equalizer_enabled;
+	uint32_t		start;
+	uint32_t		cycles;
+
+	for(uint32_t i = 0; i < EQUALIZER_BENCHMARK_FRAMES; i++)
+		words[i] = (i * 256) | ((65535 - i * 256) << 16);
+
+	Dsp_Enable_Cycle_Counter();
+
+	for(uint8_t band = 0; band < EQUALIZER_BANDS; band++)
+	{
+		gains[band] = equalizer_bands[band].gain;
+		equalizer_bands[band].gain = -EQUALIZER_GAIN_STEP;
+	}
+	equalizer_enabled = true;
+	Equalizer_Update();
+
+	start = DWT->CYCCNT;
+	Equalizer_Process(words, EQUALIZER_BENCHMARK_FRAMES);
+	cycles = DWT->CYCCNT - start;
+
+	//	Back to the user settings
+	for(uint8_t band = 0; band < EQUALIZER_BANDS; band++)
+		equalizer_bands[band].gain = gains[band];
+	equalizer_enabled = enabled;
+	Equalizer_Update();
+
+	return cycles / (EQUALIZER_BENCHMARK_FRAMES * EQUALIZER_CHANNELS * EQUALIZER_BANDS);
+}
+#endif
@@ -0,0 +1,224 @@
+#include "stm32f4xx.h"
+#include <stdbool.h>
+#include "i2s.h"
+#include "dac.h"
+#include "GPIO.h"
+#include "RCC.h"
+
+#define I2S_SIGN_FLIP				(uint32_t)0x80008000	//	Moves both DHR12LD lanes to the signed range
+#define I2S_PLLI2SN_MIN				(uint32_t)50
+#define I2S_PLLI2SN_MAX				(uint32_t)432
+#define I2S_PLLI2SR_MIN				(uint32_t)2
+#define I2S_PLLI2SR_MAX				(uint32_t)7
+#define I2S_VCO_MIN_HZ				(uint32_t)100000000
+#define I2S_VCO_MAX_HZ				(uint32_t)432000000
+#define I2S_CLOCK_MAX_HZ			(uint32_t)192000000
+#define I2S_DIVIDER_MIN				(uint32_t)4				//	2 * I2SDIV + ODD, I2SDIV is 2 to 255
+#define I2S_DIVIDER_MAX				(uint32_t)511
+
+#if I2S_PLAYBACK_MASTER_CLOCK
+#define I2S_CLOCKS_PER_FRAME		(uint32_t)256			//	The divider is applied to MCK, which is 256 x Fs for both frame lengths
+#elif I2S_PLAYBACK_FRAME_32_BIT
+#define I2S_CLOCKS_PER_FRAME		(uint32_t)64			//	Two 32 bit channels
+#else
+#define I2S_CLOCKS_PER_FRAME		(uint32_t)32			//	Two 16 bit channels
+#endif
+
+typedef struct
+{
+	uint32_t	plli2sn;
+	uint32_t	plli2sr;
+	uint32_t	divider;		/*< 2 * I2SDIV + ODD */
+}i2s_clock_t;
+
+static uint32_t					i2s_playback_buffer[2 * I2S_PLAYBACK_HALF_BUFFER_SAMPLES];	/*< Ping-pong buffer, both halves read by one circular DMA transfer */
+static dac_playback_refill_f	i2s_playback_refill;										/*< Function filling the half of the buffer which is free */
+
+
+/**
+ * \brief This function searches the PLLI2S multiplier, divider and the I2S prescaler which give the rate closest to the requested one
+ *
+ * \param sample_rate_hz[IN]	-	the requested rate
+ * \param clock[OUT]			-	the found configuration
+ *
+ * \return	the real sample rate in Hz
+ */
+static uint32_t I2S_Find_Clock(uint32_t sample_rate_hz, i2s_clock_t* clock)
+{
+	uint64_t	frame_clock = (uint64_t)sample_rate_hz * I2S_CLOCKS_PER_FRAME;
+	uint64_t	best_error = UINT64_MAX;
+	uint64_t	best_vco;
+
+	//	The reset PLLI2S and the slowest I2S, if no configuration reaches the rate
+	clock->plli2sn = 192;
+	clock->plli2sr = 2;
+	clock->divider = I2S_DIVIDER_MAX;
+	best_vco = (uint64_t)RCC_PLL_INPUT_FREQ_HZ * clock->plli2sn;
+
+	for(uint32_t r = I2S_PLLI2SR_MIN; r <= I2S_PLLI2SR_MAX; r++)
+	{
+		for(uint32_t n = I2S_PLLI2SN_MIN; n <= I2S_PLLI2SN_MAX; n++)
+		{
+			uint64_t vco = (uint64_t)RCC_PLL_INPUT_FREQ_HZ * n;
+			uint64_t divider;
+			uint64_t error;
+
+			if((vco < I2S_VCO_MIN_HZ) || (vco > I2S_VCO_MAX_HZ) || (vco > (uint64_t)I2S_CLOCK_MAX_HZ * r))
+				continue;
+			//	The I2S clock is vco / r, the rounded divider gives the closest rate
+			divider = (vco + frame_clock * r / 2) / (frame_clock * r);
+			if((divider < I2S_DIVIDER_MIN) || (divider > I2S_DIVIDER_MAX))
+				continue;
+			error = (vco > divider * frame_clock * r) ? (vco - divider * frame_clock * r) : (divider * frame_clock * r - vco);
+			//	The relative errors are compared: error / vco < best_error / best_vco
+			if(error * best_vco < best_error * vco)
+			{
+				best_error = error;
+				best_vco = vco;
+				clock->plli2sn = n;
+				clock->plli2sr = r;
+				clock->divider = (uint32_t)divider;
+			}
+		}
+	}
+
+	return (uint32_t)((best_vco + (uint64_t)clock->plli2sr * clock->divider * I2S_CLOCKS_PER_FRAME / 2)
+					/ ((uint64_t)clock->plli2sr * clock->divider * I2S_CLOCKS_PER_FRAME));
+}
+
+/**
+ * \brief This function fills the given half of the playback buffer using the refill function. The DAC words are moved to the
+ * 			signed range, the samples it did not give are replaced with silence.
+ */
+static void I2S_Playback_Refill(uint32_t half)
+{
+	uint32_t*	buffer = i2s_playback_buffer + half * I2S_PLAYBACK_HALF_BUFFER_SAMPLES;
+	uint32_t	filled = 0;
+
+	if(i2s_playback_refill != 0)
+		filled = i2s_playback_refill(buffer, I2S_PLAYBACK_HALF_BUFFER_SAMPLES);
+	for(uint32_t i = 0; i < filled; i++)
+		buffer[i] ^= I2S_SIGN_FLIP;
+	for(; filled < I2S_PLAYBACK_HALF_BUFFER_SAMPLES; filled++)
+		buffer[filled] = 0;
+}
+
+/**
+ * \brief This function configures the I2S playback: the PLLI2S and SPI3 as the I2S master transmitter (Philips standard,
+ * 			16 bit data) and the DMA which moves the samples from the ping-pong buffer to the data register. The CPU is
+ * 			interrupted only when a half of the buffer has been sent, so it can be refilled while the DMA reads the other half.
+ *
+ * \param sample_rate_hz[IN]	-	the output sample rate
+ * \param refill[IN]			-	the function which gives the samples (DHR12LD words, like for the DAC)
+ *
+ * \return	the real sample rate in Hz, the closest one the PLLI2S can give
+ */
+uint32_t I2S_Playback_Init(uint32_t sample_rate_hz, dac_playback_refill_f refill)
+{
+	i2s_clock_t	clock;
+	uint32_t	real_rate;
+
+	//	Turn on the clock for SPI3, the pins and DMA1
+	RCC->APB1ENR |= RCC_APB1ENR_SPI3EN;
+	RCC->AHB1ENR |= RCC_AHB1ENR_GPIOAEN | RCC_AHB1ENR_GPIOCEN | RCC_AHB1ENR_DMA1EN;
+
+	I2S_Playback_Stop();
+	i2s_playback_refill = refill;
+
+	//	Configure the pins: WS, CK, SD and MCK
+	GPIO_AlternateFunctionPrepare(I2S_WS_PORT, I2S_WS_PIN, gpio_otyper_push_pull, gpio_speed_fast, gpio_pupd_no_pull);
+	GPIO_AlternateFunctionSet(I2S_WS_PORT, I2S_WS_PIN, I2S_ALTERNATE_FUNCTION);
+	GPIO_AlternateFunctionPrepare(I2S_CLOCK_PORT, I2S_CK_PIN | I2S_SD_PIN, gpio_otyper_push_pull, gpio_speed_fast, gpio_pupd_no_pull);
+	GPIO_AlternateFunctionSet(I2S_CLOCK_PORT, I2S_CK_PIN | I2S_SD_PIN, I2S_ALTERNATE_FUNCTION);
+#if I2S_PLAYBACK_MASTER_CLOCK
+	GPIO_AlternateFunctionPrepare(I2S_CLOCK_PORT, I2S_MCK_PIN, gpio_otyper_push_pull, gpio_speed_fast, gpio_pupd_no_pull);
+	GPIO_AlternateFunctionSet(I2S_CLOCK_PORT, I2S_MCK_PIN, I2S_ALTERNATE_FUNCTION);
+#endif
+
+	//	Configure the clock
+	real_rate = I2S_Find_Clock(sample_rate_hz, &clock);
+	RCC_SetI2SClockFrequency(clock.plli2sn, clock.plli2sr);
+
+	//	I2S master transmitter, Philips standard, 16 bit data in the 16 or 32 bit channel frame
+	I2S_PLAYBACK_SPI->I2SCFGR = SPI_I2SCFGR_I2SMOD | SPI_I2SCFGR_I2SCFG_1;
+#if I2S_PLAYBACK_FRAME_32_BIT
+	I2S_PLAYBACK_SPI->I2SCFGR |= SPI_I2SCFGR_CHLEN;
+#endif
+	I2S_PLAYBACK_SPI->I2SPR = (clock.divider >> 1) | ((clock.divider & 1) ? SPI_I2SPR_ODD : 0);
+#if I2S_PLAYBACK_MASTER_CLOCK
+	I2S_PLAYBACK_SPI->I2SPR |= SPI_I2SPR_MCKOE;
+#endif
+	I2S_PLAYBACK_SPI->CR2 = SPI_CR2_TXDMAEN;
+
+	//	Configure the stream: memory to peripheral, circular, memory increment, half and complete interrupts, 16 bit transfers
+	I2S_PLAYBACK_DMA_STREAM->CR = 0;
+	while(I2S_PLAYBACK_DMA_STREAM->CR & DMA_SxCR_EN);
+	I2S_PLAYBACK_DMA_STREAM->CR = (I2S_PLAYBACK_DMA_CHANNEL << 25) | DMA_SxCR_PL_1 | DMA_SxCR_MINC | DMA_SxCR_CIRC | DMA_SxCR_DIR_0
+								| DMA_SxCR_MSIZE_0 | DMA_SxCR_PSIZE_0 | DMA_SxCR_HTIE | DMA_SxCR_TCIE | DMA_SxCR_TEIE;
+	I2S_PLAYBACK_DMA_STREAM->PAR = (uint32_t)&I2S_PLAYBACK_SPI->DR;
+	I2S_PLAYBACK_DMA_STREAM->M0AR = (uint32_t)i2s_playback_buffer;
+	//	Two half words (left and right) per frame
+	I2S_PLAYBACK_DMA_STREAM->NDTR = 2 * 2 * I2S_PLAYBACK_HALF_BUFFER_SAMPLES;
+	//	Direct mode, no FIFO
+	I2S_PLAYBACK_DMA_STREAM->FCR = 0;
+
+	NVIC_SetPriority(I2S_PLAYBACK_DMA_IRQn, 1);
+	NVIC_EnableIRQ(I2S_PLAYBACK_DMA_IRQn);
+
+	return real_rate;
+}
+
+/**
+ * \brief This function fills both halves of the buffer and starts the DMA and the I2S
+ */
+void I2S_Playback_Start(void)
+{
+	I2S_Playback_Refill(0);
+	I2S_Playback_Refill(1);
+
+	//	Clear the stream 7 flags and enable the stream
+	DMA1->HIFCR = DMA_HIFCR_CTCIF7 | DMA_HIFCR_CHTIF7 | DMA_HIFCR_CTEIF7 | DMA_HIFCR_CDMEIF7 | DMA_HIFCR_CFEIF7;
+	I2S_PLAYBACK_DMA_STREAM->CR |= DMA_SxCR_EN;
+
+	I2S_PLAYBACK_SPI->I2SCFGR |= SPI_I2SCFGR_I2SE;
+}
+
+/**
+ * \brief This function stops the DMA and, after the last frame is sent, the I2S
+ */
+void I2S_Playback_Stop(void)
+{
+	I2S_PLAYBACK_DMA_STREAM->CR &= ~DMA_SxCR_EN;
+	if(I2S_PLAYBACK_SPI->I2SCFGR & SPI_I2SCFGR_I2SE)
+	{
+		//	The I2S must not be disabled in the middle of the frame
+		while(!(I2S_PLAYBACK_SPI->SR & SPI_SR_TXE));
+		while(I2S_PLAYBACK_SPI->SR & SPI_SR_BSY);
+		I2S_PLAYBACK_SPI->I2SCFGR &= ~SPI_I2SCFGR_I2SE;
+	}
+}
+
+/**
+ * \brief The DMA interrupt. After the half transfer the DMA reads the second half, so the first one is refilled and after the complete transfer - the second one.
+ */
+void DMA1_Stream7_IRQHandler(void)
+{
+	uint32_t flags = DMA1->HISR;
+
+	if(flags & DMA_HISR_HTIF7)
+	{
+		DMA1->HIFCR = DMA_HIFCR_CHTIF7;
+		I2S_Playback_Refill(0);
+	}
+	if(flags & DMA_HISR_TCIF7)
+	{
+		DMA1->HIFCR = DMA_HIFCR_CTCIF7;
+		I2S_Playback_Refill(1);
+	}
+	if(flags & DMA_HISR_TEIF7)
+	{
+		//	Transfer error disables the stream, start it again
+		DMA1->HIFCR = DMA_HIFCR_CTEIF7;
+		I2S_PLAYBACK_DMA_STREAM->CR |= DMA_SxCR_EN;
+	}
+}
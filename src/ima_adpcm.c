@@ -0,0 +1,104 @@
+#include "ima_adpcm.h"
+#include "dsp.h"
+#include <stdint.h>
+
+/*< The quantizer step sizes */
+static const int16_t ima_adpcm_step_table[89] =
+{
+	7, 8, 9, 10, 11, 12, 13, 14, 16, 17, 19, 21, 23, 25, 28, 31, 34, 37, 41, 45, 50, 55, 60, 66, 73, 80, 88, 97, 107, 118,
+	130, 143, 157, 173, 190, 209, 230, 253, 279, 307, 337, 371, 408, 449, 494, 544, 598, 658, 724, 796, 876, 963, 1060,
+	1166, 1282, 1411, 1552, 1707, 1878, 2066, 2272, 2499, 2749, 3024, 3327, 3660, 4026, 4428, 4871, 5358, 5894, 6484,
+	7132, 7845, 8630, 9493, 10442, 11487, 12635, 13899, 15289, 16818, 18500, 20350, 22385, 24623, 27086, 29794, 32767
+};
+
+/*< The step index change for every code, the sign bit does not change it */
+static const int8_t ima_adpcm_index_table[16] =
+{
+	-1, -1, -1, -1, 2, 4, 6, 8,
+	-1, -1, -1, -1, 2, 4, 6, 8
+};
+
+/**
+ * \brief This function prepares the decoder for the stream
+ */
+void Ima_Adpcm_Init(ima_adpcm_t* decoder, uint8_t channels)
+{
+	for(uint8_t channel = 0; channel < IMA_ADPCM_MAX_CHANNELS; channel++)
+	{
+		decoder->predictor[channel] = 0;
+		decoder->step_index[channel] = 0;
+	}
+	decoder->channels = channels;
+}
+
+/**
+ * \brief This function takes the block header. The first sample of the block is stored in the header without compression.
+ *
+ * \param header[IN]	-	IMA_ADPCM_UNIT_SIZE(channels) bytes of the header
+ * \param output[OUT]	-	the first frame of the block
+ */
+void Ima_Adpcm_Decode_Header(ima_adpcm_t* decoder, const uint8_t* header, int16_t* output)
+{
+	for(uint8_t channel = 0; channel < decoder->channels; channel++)
+	{
+		int32_t step_index = header[2];
+
+		decoder->predictor[channel] = (int16_t)(header[0] | (header[1] << 8));
+		decoder->step_index[channel] = (step_index > 88) ? 88 : step_index;
+		output[channel] = (int16_t)decoder->predictor[channel];
+		header += 4;
+	}
+}
+
+/**
+ * \brief This function decodes the 4 bit codes of one channel to the interleaved output. There are no branches on the
+ * 			code value: the bits of the magnitude select the step parts with the masks (the same rounding as the IMA reference
+ * 			decoder), the sign is applied by the select and the predictor is limited with SSAT.
+ */
+static void Ima_Adpcm_Decode_Channel(ima_adpcm_t* decoder, uint8_t channel, uint32_t codes, int16_t* output)
+{
+	int32_t predictor = decoder->predictor[channel];
+	int32_t step_index = decoder->step_index[channel];
+	int32_t channels = decoder->channels;
+
+	//	8 codes in the word, the lower nibble first
+	for(uint32_t i = 0; i < IMA_ADPCM_GROUP_FRAMES; i++)
+	{
+		uint32_t	code = codes & 0x0F;
+		int32_t		step = ima_adpcm_step_table[step_index];
+		int32_t		difference = (step >> 3) + (step & -(int32_t)((code >> 2) & 1))
+								+ ((step >> 1) & -(int32_t)((code >> 1) & 1)) + ((step >> 2) & -(int32_t)(code & 1));
+
+		predictor = Dsp_Saturate_Q15((code & 8) ? predictor - difference : predictor + difference);
+		step_index += ima_adpcm_index_table[code];
+		step_index = (step_index < 0) ? 0 : ((step_index > 88) ? 88 : step_index);
+
+		output[i * channels] = (int16_t)predictor;
+		codes >>= 4;
+	}
+
+	decoder->predictor[channel] = predictor;
+	decoder->step_index[channel] = step_index;
+}
+
+/**
+ * \brief This function decodes the groups of the block which follow the header
+ *
+ * \param data[IN]		-	groups * IMA_ADPCM_UNIT_SIZE(channels) bytes of the block
+ * \param groups[IN]	-	the number of the groups of all channels
+ * \param output[OUT]	-	groups * IMA_ADPCM_GROUP_FRAMES interleaved Q15 frames
+ */
+void Ima_Adpcm_Decode_Groups(ima_adpcm_t* decoder, const uint8_t* data, uint32_t groups, int16_t* output)
+{
+	for(; groups != 0; groups--)
+	{
+		for(uint8_t channel = 0; channel < decoder->channels; channel++)
+		{
+			uint32_t codes = (uint32_t)data[0] | ((uint32_t)data[1] << 8) | ((uint32_t)data[2] << 16) | ((uint32_t)data[3] << 24);
+
+			Ima_Adpcm_Decode_Channel(decoder, channel, codes, output + channel);
+			data += 4;
+		}
+		output += IMA_ADPCM_GROUP_FRAMES * decoder->channels;
+	}
+}
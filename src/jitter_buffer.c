@@ -0,0 +1,191 @@
+#include "jitter_buffer.h"
+#include "audio_ring.h"
+#include "resampler.h"
+#include "pcm_convert.h"
+#include <stdint.h>
+#include <stdbool.h>
+
+static int16_t		jitter_input[RESAMPLER_MAX_CHANNELS * JITTER_BUFFER_BLOCK_FRAMES];		/*< The input frames given to the resampler */
+static int16_t		jitter_output[RESAMPLER_MAX_CHANNELS * JITTER_BUFFER_BLOCK_FRAMES];	/*< The resampled frames */
+static uint32_t		jitter_words[JITTER_BUFFER_BLOCK_FRAMES];								/*< The resampled frames as the DAC words */
+
+
+/**
+ * \brief This function prepares the jitter buffer for the stream
+ *
+ * \param jitter[IN]		-	the jitter buffer to initialize
+ * \param buffer[IN]		-	the memory of the ring, its size must be a power of 2 and hold at least twice the target
+ * \param buffer_size[IN]	-	the size of the buffer in bytes
+ * \param input_rate[IN]	-	the nominal rate of the sender
+ * \param output_rate[IN]	-	the nominal rate of the DAC
+ * \param channels[IN]		-	number of interleaved channels, 1 or 2
+ * \param target_ms[IN]		-	the latency to keep, it must cover the longest gap between the packets
+ *
+ * \return	false if the parameters are not supported
+ */
+bool Jitter_Buffer_Init(jitter_buffer_t* jitter, uint8_t* buffer, uint32_t buffer_size, uint32_t input_rate, uint32_t output_rate, uint8_t channels, uint32_t target_ms)
+{
+	if(!Audio_Ring_Init(&jitter->ring, buffer, buffer_size) || !Resampler_Init(&jitter->resampler, input_rate, output_rate, channels))
+		return false;
+
+	jitter->frame_size = channels * sizeof(int16_t);
+	jitter->nominal_step = jitter->resampler.step;
+	jitter->target_frames = input_rate * target_ms / 1000;
+	if(2 * jitter->target_frames * jitter->frame_size > buffer_size)
+		return false;
+
+	Jitter_Buffer_Reset(jitter);
+
+	return true;
+}
+
+/**
+ * \brief This function empties the buffer and clears the controller, e.g. before the new stream. The statistics are cleared too.
+ */
+void Jitter_Buffer_Reset(jitter_buffer_t* jitter)
+{
+	Audio_Ring_Clear(&jitter->ring);
+	Resampler_Reset(&jitter->resampler);
+	jitter->resampler.step = jitter->nominal_step;
+	jitter->buffering = true;
+	jitter->filtered_error = 0;
+	jitter->integral = 0;
+	jitter->correction = 0;
+	jitter->step_fraction = 0;
+	jitter->update_frames = 0;
+	jitter->underruns = 0;
+	jitter->overflows = 0;
+}
+
+/**
+ * \brief This function puts the received data in the buffer. The data which does not fit is dropped as a whole, so the channels
+ * 			stay aligned when the receiver gives whole frames.
+ *
+ * \param jitter[IN]	-	the jitter buffer
+ * \param data[IN]		-	16 bit signed PCM, interleaved
+ * \param data_size[IN]	-	the number of the bytes
+ *
+ * \return	the number of the bytes put, 0 or data_size
+ */
+uint32_t Jitter_Buffer_Put(jitter_buffer_t* jitter, const uint8_t* data, uint32_t data_size)
+{
+	if(Audio_Ring_Get_Free_Space(&jitter->ring) < data_size)
+	{
+		jitter->overflows += data_size;
+		return 0;
+	}
+
+	return Audio_Ring_Put(&jitter->ring, data, data_size);
+}
+
+/**
+ * \brief This function measures the buffered audio and sets the resampler step. The level is the input frames in the ring and
+ * 			the output frames in the playback ring, converted to the input frames.
+ */
+static void Jitter_Buffer_Update(jitter_buffer_t* jitter, audio_ring_t* output)
+{
+	uint32_t	buffered = Audio_Ring_Get_Data_Size(&jitter->ring) / jitter->frame_size;
+	int32_t		error;
+	int32_t		integral;
+	int32_t		correction;
+	uint32_t	step;
+
+	buffered += ((Audio_Ring_Get_Data_Size(output) / sizeof(uint32_t)) * jitter->nominal_step) >> 16;
+	error = (int32_t)buffered - (int32_t)jitter->target_frames;
+
+	//	Low-pass filter of the level error in Q8 frames, the bursts of the packets are averaged out
+	jitter->filtered_error += ((error * 256) - jitter->filtered_error) >> JITTER_BUFFER_FILTER_SHIFT;
+
+	//	The PI controller, the integral ends at the clock drift. It is summed without the shift, so the small errors are not lost
+	integral = jitter->integral + jitter->filtered_error;
+	if(integral > (JITTER_BUFFER_MAX_CORRECTION << JITTER_BUFFER_INTEGRAL_SHIFT))
+		integral = JITTER_BUFFER_MAX_CORRECTION << JITTER_BUFFER_INTEGRAL_SHIFT;
+	else if(integral < -(JITTER_BUFFER_MAX_CORRECTION << JITTER_BUFFER_INTEGRAL_SHIFT))
+		integral = -(JITTER_BUFFER_MAX_CORRECTION << JITTER_BUFFER_INTEGRAL_SHIFT);
+
+	//	Anti-windup: the integral is not moved further while the correction is at the limit in the direction of the error,
+	//	else it would keep growing and overshoot the level when the error turns
+	correction = (integral >> JITTER_BUFFER_INTEGRAL_SHIFT) + (jitter->filtered_error >> JITTER_BUFFER_PROPORTIONAL_SHIFT);
+	if(!((correction > JITTER_BUFFER_MAX_CORRECTION) && (jitter->filtered_error > 0)) && !((correction < -JITTER_BUFFER_MAX_CORRECTION) && (jitter->filtered_error < 0)))
+		jitter->integral = integral;
+
+	jitter->correction = (jitter->integral >> JITTER_BUFFER_INTEGRAL_SHIFT) + (jitter->filtered_error >> JITTER_BUFFER_PROPORTIONAL_SHIFT);
+	if(jitter->correction > JITTER_BUFFER_MAX_CORRECTION)
+		jitter->correction = JITTER_BUFFER_MAX_CORRECTION;
+	else if(jitter->correction < -JITTER_BUFFER_MAX_CORRECTION)
+		jitter->correction = -JITTER_BUFFER_MAX_CORRECTION;
+
+	//	The part of the step below 1 LSB is carried to the next update, so the mean step has the resolution of 1/256 LSB
+	step = (jitter->nominal_step << JITTER_BUFFER_CORRECTION_BITS) + jitter->correction + jitter->step_fraction;
+	jitter->step_fraction = step & ((1 << JITTER_BUFFER_CORRECTION_BITS) - 1);
+	jitter->resampler.step = step >> JITTER_BUFFER_CORRECTION_BITS;
+}
+
+/**
+ * \brief This function resamples the buffered input to the playback ring, as much as the ring can take. It should be called
+ * 			from the main loop, at least once per a half of the DAC buffer. The output starts when the target is reached
+ * 			and starts again from the target after the underrun.
+ *
+ * \param jitter[IN]	-	the jitter buffer
+ * \param output[IN]	-	the playback ring, DAC words
+ *
+ * \return	the number of the frames put in the playback ring
+ */
+uint32_t Jitter_Buffer_Process(jitter_buffer_t* jitter, audio_ring_t* output)
+{
+	pcm_convert_f	convert = Pcm_Convert_Get_Kernel(16, jitter->resampler.channels);
+	uint32_t		total = 0;
+
+	//	The playback ring ran empty, the DAC plays the silence until the buffer is filled again
+	if(!jitter->buffering && (Audio_Ring_Get_Data_Size(output) == 0) && (Audio_Ring_Get_Data_Size(&jitter->ring) < jitter->frame_size))
+	{
+		jitter->underruns++;
+		jitter->buffering = true;
+	}
+	if(jitter->buffering)
+	{
+		if(Audio_Ring_Get_Data_Size(&jitter->ring) < jitter->target_frames * jitter->frame_size)
+			return 0;
+		jitter->buffering = false;
+	}
+
+	while(Audio_Ring_Get_Free_Space(output) >= JITTER_BUFFER_BLOCK_FRAMES * sizeof(uint32_t))
+	{
+		uint32_t input_frames = Audio_Ring_Get_Data_Size(&jitter->ring) / jitter->frame_size;
+		uint32_t produced;
+
+		if(input_frames > Resampler_Get_Input_Space(&jitter->resampler))
+			input_frames = Resampler_Get_Input_Space(&jitter->resampler);
+		if(input_frames > JITTER_BUFFER_BLOCK_FRAMES)
+			input_frames = JITTER_BUFFER_BLOCK_FRAMES;
+
+		Audio_Ring_Get(&jitter->ring, (uint8_t*)jitter_input, input_frames * jitter->frame_size);
+		produced = Resampler_Process(&jitter->resampler, jitter_input, input_frames, jitter_output, JITTER_BUFFER_BLOCK_FRAMES);
+		if(produced == 0)
+			break;
+
+		convert((const uint8_t*)jitter_output, jitter_words, produced);
+		Audio_Ring_Put(output, (uint8_t*)jitter_words, produced * sizeof(uint32_t));
+		total += produced;
+
+		//	The output goes at the DAC rate, so the updates are equally spaced in time
+		jitter->update_frames += produced;
+		if(jitter->update_frames >= JITTER_BUFFER_UPDATE_FRAMES)
+		{
+			jitter->update_frames -= JITTER_BUFFER_UPDATE_FRAMES;
+			Jitter_Buffer_Update(jitter, output);
+		}
+	}
+
+	return total;
+}
+
+/**
+ * \brief This function returns the correction of the resampler step, it follows the drift of the sender clock to the DAC clock
+ *
+ * \return	the correction in ppm, positive if the sender is faster
+ */
+int32_t Jitter_Buffer_Get_Correction_Ppm(jitter_buffer_t* jitter)
+{
+	return (int32_t)(((int64_t)jitter->correction * 1000000) / ((int64_t)jitter->nominal_step << JITTER_BUFFER_CORRECTION_BITS));
+}
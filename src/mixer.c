@@ -0,0 +1,260 @@
+#include "mixer.h"
+#include "audio_ring.h"
+#include "dac.h"
+#include "dsp.h"
+#include <stdint.h>
+#include <stdbool.h>
+
+#define MIXER_DAC_OFFSET			(uint32_t)0x80008000	//	The middle of the range in both lanes
+#define MIXER_BLOCK_FRAMES			DAC_PLAYBACK_HALF_BUFFER_SAMPLES
+
+typedef struct
+{
+	audio_ring_t* volatile	ring;			/*< The DAC words of the source, 0 - not used */
+	int32_t					gain;			/*< The current Q15 gain with the Q16 fraction, so the small ramp steps are not lost */
+	int32_t					target_gain;	/*< The gain at the end of the ramp, Q15 with the Q16 fraction */
+	int32_t					step;			/*< The gain change per frame */
+	uint32_t				remaining;		/*< Frames left to the end of the ramp */
+	volatile int16_t		fade_gain;		/*< The fade requested by the user */
+	volatile uint32_t		fade_frames;
+	volatile bool			fade_pending;	/*< True until the interrupt takes the requested fade */
+}mixer_channel_t;
+
+static mixer_channel_t	mixer_channels[MIXER_SOURCES] =
+{
+	{0, MIXER_UNITY_GAIN << 16, MIXER_UNITY_GAIN << 16, 0, 0, MIXER_UNITY_GAIN, 0, false},
+	{0, MIXER_UNITY_GAIN << 16, MIXER_UNITY_GAIN << 16, 0, 0, MIXER_UNITY_GAIN, 0, false}
+};
+static uint32_t			mixer_buffer[MIXER_BLOCK_FRAMES];		/*< The words of the aux source */
+
+/**
+ * \brief This function sets the ring of the DAC words played by the source
+ *
+ * \param source[IN]	-	the mixer source
+ * \param ring[IN]		-	the ring, 0 to remove the source
+ */
+void Mixer_Set_Source(mixer_source_e source, audio_ring_t* ring)
+{
+	if(source < MIXER_SOURCES)
+		mixer_channels[source].ring = ring;
+}
+
+/**
+ * \brief This function changes the gain of the source linearly over the given number of frames. The fade starts with
+ * 			the next refilled block and replaces the fade in progress.
+ *
+ * \param source[IN]	-	the mixer source
+ * \param gain[IN]		-	the Q15 gain at the end of the fade, 0 to MIXER_UNITY_GAIN
+ * \param frames[IN]	-	the fade length, 0 - the gain is changed at once
+ */
+void Mixer_Fade(mixer_source_e source, int16_t gain, uint32_t frames)
+{
+	if(source >= MIXER_SOURCES)
+		return;
+	if(gain < 0)
+		gain = 0;
+
+	mixer_channels[source].fade_gain = gain;
+	mixer_channels[source].fade_frames = frames;
+	mixer_channels[source].fade_pending = true;
+}
+
+/**
+ * \brief This function sets the gain of the source at the start of the next refilled block
+ */
+void Mixer_Set_Gain(mixer_source_e source, int16_t gain)
+{
+	Mixer_Fade(source, gain, 0);
+}
+
+/**
+ * \brief This function fades in the source and fades out all the other ones over the same number of frames. The fades
+ * 			start from the current gains, so the new stream should be set to the gain 0 (Mixer_Set_Gain) before its
+ * 			first words are put in the ring.
+ *
+ * \param to[IN]		-	the source which is heard after the crossfade, its ring should be already set
+ * \param frames[IN]	-	the crossfade length
+ */
+void Mixer_Crossfade(mixer_source_e to, uint32_t frames)
+{
+	for(uint8_t source = 0; source < MIXER_SOURCES; source++)
+		Mixer_Fade((mixer_source_e)source, (source == to) ? MIXER_UNITY_GAIN : 0, frames);
+}
+
+/**
+ * \brief This function returns true if the gain of the source is still changing
+ */
+bool Mixer_Is_Fading(mixer_source_e source)
+{
+	if(source >= MIXER_SOURCES)
+		return false;
+
+	return mixer_channels[source].fade_pending || (mixer_channels[source].remaining != 0);
+}
+
+/**
+ * \brief This function takes the fade requested by the user. It is called in the interrupt, at the start of the block.
+ */
+static void Mixer_Start_Fade(mixer_channel_t* channel)
+{
+	uint32_t frames = channel->fade_frames;
+
+	channel->target_gain = channel->fade_gain << 16;
+	channel->fade_pending = false;
+	if(frames == 0)
+	{
+		channel->gain = channel->target_gain;
+		channel->remaining = 0;
+	}
+	else
+	{
+		channel->step = (channel->target_gain - channel->gain) / (int32_t)frames;
+		channel->remaining = frames;
+	}
+}
+
+/**
+ * \brief This function scales both lanes (already moved to the signed range) by the Q15 gain
+ */
+static inline uint32_t Mixer_Scale(uint32_t lanes, uint32_t gain)
+{
+	return Dsp_Pkhbt(Dsp_Smulbb(lanes, gain) >> 15, Dsp_Smultb(lanes, gain) >> 15, 16);
+}
+
+/**
+ * \brief This function moves the DAC words of the source to the signed range and applies its gain envelope in place
+ */
+static void Mixer_Apply_Gain(mixer_channel_t* channel, uint32_t* words, uint32_t frames)
+{
+	uint32_t	ramp = (channel->remaining < frames) ? channel->remaining : frames;
+	uint32_t	gain;
+	uint32_t	i;
+
+	for(i = 0; i < ramp; i++)
+	{
+		channel->gain += channel->step;
+		words[i] = Mixer_Scale(Dsp_Ssub16(words[i], MIXER_DAC_OFFSET), (uint32_t)(channel->gain >> 16));
+	}
+	channel->remaining -= ramp;
+	if(channel->remaining == 0)
+		channel->gain = channel->target_gain;
+
+	gain = (uint32_t)(channel->gain >> 16);
+	if(gain == MIXER_UNITY_GAIN)
+	{
+		for(; i < frames; i++)
+			words[i] = Dsp_Ssub16(words[i], MIXER_DAC_OFFSET);
+	}
+	else
+	{
+		for(; i < frames; i++)
+			words[i] = Mixer_Scale(Dsp_Ssub16(words[i], MIXER_DAC_OFFSET), gain);
+	}
+}
+
+/**
+ * \brief This function takes up to the given number of the words of the source from its ring
+ *
+ * \return	the number of the words taken from the ring
+ */
+static uint32_t Mixer_Read_Source(mixer_channel_t* channel, uint32_t* words, uint32_t frames)
+{
+	audio_ring_t*	ring = channel->ring;
+	uint32_t		count = 0;
+
+	if(ring != 0)
+		count = Audio_Ring_Get(ring, (uint8_t*)words, frames * sizeof(uint32_t)) / sizeof(uint32_t);
+
+	return count;
+}
+
+/**
+ * \brief This function gives the mixed block of the DAC words. It is called in the DAC refill interrupt.
+ *
+ * \param words[OUT]	-	the DAC words (DHR12LD layout)
+ * \param frames[IN]	-	the number of the words to give, up to DAC_PLAYBACK_HALF_BUFFER_SAMPLES
+ *
+ * \return	the number of the given words, less if all sources ran out of data
+ */
+uint32_t Mixer_Get(uint32_t* words, uint32_t frames)
+{
+	mixer_channel_t*	main_channel = &mixer_channels[MIXER_SOURCE_MAIN];
+	mixer_channel_t*	aux_channel = &mixer_channels[MIXER_SOURCE_AUX];
+	uint32_t			main_count;
+	uint32_t			aux_count;
+	uint32_t			count;
+
+	if(frames > MIXER_BLOCK_FRAMES)
+		frames = MIXER_BLOCK_FRAMES;
+
+	for(uint8_t source = 0; source < MIXER_SOURCES; source++)
+	{
+		if(mixer_channels[source].fade_pending)
+			Mixer_Start_Fade(&mixer_channels[source]);
+	}
+
+	main_count = Mixer_Read_Source(main_channel, words, frames);
+	aux_count = Mixer_Read_Source(aux_channel, mixer_buffer, frames);
+
+	//	Nothing to mix, the main words are given as they are
+	if((aux_count == 0) && (main_channel->remaining == 0) && ((main_channel->gain >> 16) == MIXER_UNITY_GAIN))
+		return main_count;
+
+	count = (main_count > aux_count) ? main_count : aux_count;
+	for(uint32_t i = main_count; i < count; i++)
+		words[i] = MIXER_DAC_OFFSET;
+	for(uint32_t i = aux_count; i < count; i++)
+		mixer_buffer[i] = MIXER_DAC_OFFSET;
+
+	Mixer_Apply_Gain(main_channel, words, count);
+	Mixer_Apply_Gain(aux_channel, mixer_buffer, count);
+	for(uint32_t i = 0; i < count; i++)
+		words[i] = Dsp_Sadd16(Dsp_Qadd16(words[i], mixer_buffer[i]), MIXER_DAC_OFFSET);
+
+	return count;
+}
+
+#if defined(DWT)
+/**
+ * \brief This function measures the mixer with the DWT cycle counter. Both sources are full and fading, it is the slowest
+ * 			case. The user sources and gains are restored afterwards, the fades in progress are finished.
+ *
+ * \return	CPU cycles per stereo frame, it should not be above MIXER_CYCLE_BUDGET
+ */
+uint32_t Mixer_Benchmark(void)
+{
+	static uint32_t		buffers[MIXER_SOURCES][MIXER_BENCHMARK_FRAMES];
+	static uint32_t		words[MIXER_BENCHMARK_FRAMES];
+	audio_ring_t		rings[MIXER_SOURCES];
+	mixer_channel_t		channels[MIXER_SOURCES];
+	uint32_t			start;
+	uint32_t			cycles;
+
+	for(uint8_t source = 0; source < MIXER_SOURCES; source++)
+	{
+		channels[source] = mixer_channels[source];
+		Audio_Ring_Init(&rings[source], (uint8_t*)buffers[source], sizeof(buffers[source]));
+		for(uint32_t i = 0; i < MIXER_BENCHMARK_FRAMES; i++)
+			words[i] = (i * 256) | ((65535 - i * 256) << 16);
+		Audio_Ring_Put(&rings[source], (uint8_t*)words, sizeof(words));
+		mixer_channels[source].ring = &rings[source];
+	}
+	Mixer_Crossfade(MIXER_SOURCE_AUX, MIXER_BENCHMARK_FRAMES * 2);
+
+	Dsp_Enable_Cycle_Counter();
+
+	start = DWT->CYCCNT;
+	Mixer_Get(words, MIXER_BENCHMARK_FRAMES);
+	cycles = DWT->CYCCNT - start;
+
+	//	Back to the user settings
+	for(uint8_t source = 0; source < MIXER_SOURCES; source++)
+	{
+		mixer_channels[source] = channels[source];
+		mixer_channels[source].gain = channels[source].target_gain;
+		mixer_channels[source].remaining = 0;
+	}
+
+	return cycles / MIXER_BENCHMARK_FRAMES;
+}
+#endif
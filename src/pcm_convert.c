@@ -0,0 +1,200 @@
+#include "pcm_convert.h"
+#include "dsp.h"
+#include <stdint.h>
+#include <string.h>
+
+#define PCM_CONVERT_OFFSET			(uint32_t)0x80008000	//	Signed to unsigned in both lanes
+
+/**
+ * \brief This function loads the 32 bit word from any address
+ */
+static inline uint32_t Pcm_Read_32(const uint8_t* data)
+{
+	uint32_t word;
+
+	memcpy(&word, data, sizeof(word));
+	return word;
+}
+
+/**
+ * \brief This function loads the 16 bit half word from any address
+ */
+static inline uint32_t Pcm_Read_16(const uint8_t* data)
+{
+	uint16_t half_word;
+
+	memcpy(&half_word, data, sizeof(half_word));
+	return half_word;
+}
+
+/**
+ * \brief This function changes two signed 16 bit lanes to the DAC word
+ */
+static inline uint32_t Pcm_Signed_To_Dac(uint32_t lanes)
+{
+	return Dsp_Sadd16(lanes, PCM_CONVERT_OFFSET);
+}
+
+/**
+ * \brief 8 bit unsigned mono. One load gives four samples, UXTB16 spreads them to the lanes.
+ */
+void Pcm_Convert_U8_Mono(const uint8_t* input, uint32_t* output, uint32_t frames)
+{
+	for(; frames >= 4; frames -= 4)
+	{
+		uint32_t word = Pcm_Read_32(input);
+		uint32_t even = Dsp_Uxtb16(word) << 8;			//	s0 | s2 << 16
+		uint32_t odd = Dsp_Uxtb16(word >> 8) << 8;		//	s1 | s3 << 16
+
+		output[0] = Dsp_Pkhbt(even, even, 16);
+		output[1] = Dsp_Pkhbt(odd, odd, 16);
+		output[2] = Dsp_Pkhtb(even, even, 16);
+		output[3] = Dsp_Pkhtb(odd, odd, 16);
+		input += 4;
+		output += 4;
+	}
+	for(; frames != 0; frames--)
+	{
+		uint32_t sample = (uint32_t)*input++ << 8;
+
+		*output++ = sample | (sample << 16);
+	}
+}
+
+/**
+ * \brief 8 bit unsigned stereo. One load gives two frames.
+ */
+void Pcm_Convert_U8_Stereo(const uint8_t* input, uint32_t* output, uint32_t frames)
+{
+	for(; frames >= 2; frames -= 2)
+	{
+		uint32_t word = Pcm_Read_32(input);
+		uint32_t left = Dsp_Uxtb16(word) << 8;			//	L0 | L1 << 16
+		uint32_t right = Dsp_Uxtb16(word >> 8) << 8;	//	R0 | R1 << 16
+
+		output[0] = Dsp_Pkhbt(left, right, 16);
+		output[1] = Dsp_Pkhtb(right, left, 16);
+		input += 4;
+		output += 2;
+	}
+	if(frames != 0)
+		*output = ((uint32_t)input[0] << 8) | ((uint32_t)input[1] << 24);
+}
+
+/**
+ * \brief 16 bit signed mono. Two samples are offset at once and then copied to both channels.
+ */
+void Pcm_Convert_S16_Mono(const uint8_t* input, uint32_t* output, uint32_t frames)
+{
+	for(; frames >= 2; frames -= 2)
+	{
+		uint32_t samples = Pcm_Signed_To_Dac(Pcm_Read_32(input));
+
+		output[0] = Dsp_Pkhbt(samples, samples, 16);
+		output[1] = Dsp_Pkhtb(samples, samples, 16);
+		input += 4;
+		output += 2;
+	}
+	if(frames != 0)
+	{
+		uint32_t sample = Pcm_Signed_To_Dac(Pcm_Read_16(input));
+
+		*output = Dsp_Pkhbt(sample, sample, 16);
+	}
+}
+
+/**
+ * \brief 16 bit signed stereo. The frame is already a pair of lanes in the DHR12LD order.
+ */
+void Pcm_Convert_S16_Stereo(const uint8_t* input, uint32_t* output, uint32_t frames)
+{
+	for(; frames >= 2; frames -= 2)
+	{
+		output[0] = Pcm_Signed_To_Dac(Pcm_Read_32(input));
+		output[1] = Pcm_Signed_To_Dac(Pcm_Read_32(input + 4));
+		input += 8;
+		output += 2;
+	}
+	if(frames != 0)
+		*output = Pcm_Signed_To_Dac(Pcm_Read_32(input));
+}
+
+/**
+ * \brief 24 bit signed mono. Only the upper 16 bits of the samples are taken, two of them are packed in the lanes.
+ */
+void Pcm_Convert_S24_Mono(const uint8_t* input, uint32_t* output, uint32_t frames)
+{
+	for(; frames >= 2; frames -= 2)
+	{
+		uint32_t samples = Pcm_Signed_To_Dac(Dsp_Pkhbt(Pcm_Read_16(input + 1), Pcm_Read_16(input + 4), 16));
+
+		output[0] = Dsp_Pkhbt(samples, samples, 16);
+		output[1] = Dsp_Pkhtb(samples, samples, 16);
+		input += 6;
+		output += 2;
+	}
+	if(frames != 0)
+	{
+		uint32_t sample = Pcm_Signed_To_Dac(Pcm_Read_16(input + 1));
+
+		*output = Dsp_Pkhbt(sample, sample, 16);
+	}
+}
+
+/**
+ * \brief 24 bit signed stereo. The upper 16 bits of both samples are packed in the lanes.
+ */
+void Pcm_Convert_S24_Stereo(const uint8_t* input, uint32_t* output, uint32_t frames)
+{
+	for(; frames != 0; frames--)
+	{
+		*output++ = Pcm_Signed_To_Dac(Dsp_Pkhbt(Pcm_Read_16(input + 1), Pcm_Read_16(input + 4), 16));
+		input += 6;
+	}
+}
+
+/**
+ * \brief This function returns the kernel for the PCM format
+ *
+ * \return	the kernel or NULL if the format is not supported
+ */
+pcm_convert_f Pcm_Convert_Get_Kernel(uint16_t bits_per_sample, uint16_t channels)
+{
+	switch(bits_per_sample)
+	{
+		case 8:
+			return (channels == 1) ? Pcm_Convert_U8_Mono : Pcm_Convert_U8_Stereo;
+		case 16:
+			return (channels == 1) ? Pcm_Convert_S16_Mono : Pcm_Convert_S16_Stereo;
+		case 24:
+			return (channels == 1) ? Pcm_Convert_S24_Mono : Pcm_Convert_S24_Stereo;
+		default:
+			return 0;
+	}
+}
+
+#if defined(DWT)
+/**
+ * \brief This function measures the kernel throughput with the DWT cycle counter
+ *
+ * \param kernel[IN]	-	the measured kernel
+ *
+ * \return	CPU cycles for PCM_CONVERT_BENCHMARK_FRAMES frames
+ */
+uint32_t Pcm_Convert_Benchmark(pcm_convert_f kernel)
+{
+	static uint8_t	input[PCM_CONVERT_BENCHMARK_FRAMES * 6];	//	The longest frame - 24 bit stereo
+	static uint32_t	output[PCM_CONVERT_BENCHMARK_FRAMES];
+	uint32_t		start;
+
+	for(uint32_t i = 0; i < sizeof(input); i++)
+		input[i] = (uint8_t)(i * 37);
+
+	Dsp_Enable_Cycle_Counter();
+
+	start = DWT->CYCCNT;
+	kernel(input, output, PCM_CONVERT_BENCHMARK_FRAMES);
+
+	return DWT->CYCCNT - start;
+}
+#endif
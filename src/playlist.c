@@ -0,0 +1,288 @@
+#include "playlist.h"
+#include "sd_card_reader.h"
+#include "audio_ring.h"
+#include "wav.h"
+#include "NEC_remote_controller.h"
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+
+static playlist_slot_t	playlist_slots[2];
+static audio_ring_t		playlist_output;									/*< The playback ring shared by all tracks */
+static uint8_t			playlist_output_buffer[PLAYLIST_OUTPUT_RING_SIZE];
+static TCHAR			playlist_directory[PLAYLIST_PATH_SIZE];
+static uint8_t			playlist_files[PLAYLIST_MAX_TRACKS];				/*< Indices of the WAV files in sd_files_list */
+static uint8_t			playlist_track_count;
+static uint8_t			playlist_track = PLAYLIST_NO_TRACK;				/*< The current track */
+static uint8_t			playlist_current;									/*< The slot of the current track */
+static bool				playlist_stopping;									/*< The last track is done, its samples are played out */
+
+/**
+ * \brief This function checks the extension of the 8.3 file name
+ */
+static bool Playlist_Is_Wav(const TCHAR* name)
+{
+	const TCHAR* dot = strrchr(name, '.');
+
+	return (dot != 0) && !strcmp(dot, ".WAV");
+}
+
+/**
+ * \brief This function opens the track in the slot and binds its SD stream with the slot input ring
+ *
+ * \param queued[IN]	-	true if the track goes after the current one, false if the playback starts with it
+ *
+ * \return	FR_OK or the FatFS error code
+ */
+static FRESULT Playlist_Load(uint8_t slot, uint8_t track, bool queued)
+{
+	playlist_slot_t*	playlist_slot = &playlist_slots[slot];
+	TCHAR				path[PLAYLIST_PATH_SIZE + 13];
+	FRESULT				result;
+
+	strcpy(path, playlist_directory);
+	if((path[0] == 0) || (path[strlen(path) - 1] != '/'))
+		strcat(path, "/");
+	strcat(path, sd_files_list[playlist_files[track]]);
+
+	playlist_slot->track = PLAYLIST_NO_TRACK;
+	result = SD_Stream_Open(slot, path, &playlist_slot->input);
+	if(result != FR_OK)
+		return result;
+	Audio_Ring_Clear(&playlist_slot->input);
+
+	if(queued)
+		Wav_Parser_Queue(&playlist_slot->parser, &playlist_output);
+	else
+		Wav_Parser_Init(&playlist_slot->parser, &playlist_output);
+	playlist_slot->track = track;
+
+	return FR_OK;
+}
+
+/**
+ * \brief This function closes the track of the slot
+ */
+static void Playlist_Unload(uint8_t slot)
+{
+	SD_Stream_Close(slot);
+	playlist_slots[slot].track = PLAYLIST_NO_TRACK;
+}
+
+/**
+ * \brief This function drops the current track and lets the queued one fill the playback ring
+ */
+static void Playlist_Advance(void)
+{
+	Playlist_Unload(playlist_current);
+	playlist_current ^= 1;
+	playlist_track = playlist_slots[playlist_current].track;
+
+	if(playlist_track != PLAYLIST_NO_TRACK)
+		Wav_Parser_Release(&playlist_slots[playlist_current].parser);
+}
+
+/**
+ * \brief This function makes the playlist of the WAV files in the directory and starts the first one. The order is the
+ * 			order of the directory entries.
+ *
+ * \param dir_path[IN]	-	the path to the directory, shorter than PLAYLIST_PATH_SIZE
+ *
+ * \return	FR_OK, FR_NO_FILE if there are no WAV files or the FatFS error code
+ */
+FRESULT Playlist_Open(const TCHAR* dir_path)
+{
+	FRESULT result;
+
+	//	Stop the previous playlist
+	Wav_Playback_Stop();
+	for(uint8_t slot = 0; slot < 2; slot++)
+	{
+		Playlist_Unload(slot);
+		Audio_Ring_Init(&playlist_slots[slot].input, playlist_slots[slot].input_buffer, PLAYLIST_INPUT_RING_SIZE);
+	}
+	Audio_Ring_Init(&playlist_output, playlist_output_buffer, PLAYLIST_OUTPUT_RING_SIZE);
+	playlist_track = PLAYLIST_NO_TRACK;
+	playlist_stopping = false;
+	playlist_track_count = 0;
+
+	if(strlen(dir_path) >= PLAYLIST_PATH_SIZE)
+		return FR_INVALID_NAME;
+	strcpy(playlist_directory, dir_path);
+
+	result = SD_Get_File_List(dir_path);
+	if(result != FR_OK)
+		return result;
+	for(uint8_t file = 0; (file < sd_number_of_files_in_dir) && (file < PLAYLIST_MAX_TRACKS); file++)
+	{
+		if(Playlist_Is_Wav(sd_files_list[file]))
+			playlist_files[playlist_track_count++] = file;
+	}
+	if(playlist_track_count == 0)
+		return FR_NO_FILE;
+
+	return Playlist_Play(0);
+}
+
+/**
+ * \brief This function switches to the track. If something is played, the track is queued after the samples already
+ * 			in the playback ring, so the DAC is not stopped. The prefetched next track is not opened again.
+ *
+ * \param track[IN]	-	the track number, less than Playlist_Get_Track_Count()
+ *
+ * \return	FR_OK, FR_INVALID_PARAMETER if there is no such track or the FatFS error code
+ */
+FRESULT Playlist_Play(uint8_t track)
+{
+	uint8_t	slot;
+	FRESULT	result;
+
+	if(track >= playlist_track_count)
+		return FR_INVALID_PARAMETER;
+
+	if(playlist_track == PLAYLIST_NO_TRACK)
+	{
+		//	Nothing is played, the playback starts from the beginning
+		Wav_Playback_Stop();
+		playlist_stopping = false;
+		for(slot = 0; slot < 2; slot++)
+			Playlist_Unload(slot);
+		playlist_current = 0;
+		result = Playlist_Load(playlist_current, track, false);
+		if(result == FR_OK)
+			playlist_track = track;
+		return result;
+	}
+
+	slot = playlist_current ^ 1;
+	if(playlist_slots[slot].track != track)
+	{
+		result = Playlist_Load(slot, track, true);
+		if(result != FR_OK)
+			return result;
+	}
+	Playlist_Advance();
+
+	return FR_OK;
+}
+
+/**
+ * \brief This function switches to the next track, after the last one comes the first one
+ */
+FRESULT Playlist_Next(void)
+{
+	if(playlist_track_count == 0)
+		return FR_NO_FILE;
+	if(playlist_track == PLAYLIST_NO_TRACK)
+		return Playlist_Play(0);
+
+	return Playlist_Play((playlist_track + 1) % playlist_track_count);
+}
+
+/**
+ * \brief This function switches to the previous track, before the first one comes the last one
+ */
+FRESULT Playlist_Previous(void)
+{
+	if(playlist_track_count == 0)
+		return FR_NO_FILE;
+	if((playlist_track == PLAYLIST_NO_TRACK) || (playlist_track == 0))
+		return Playlist_Play(playlist_track_count - 1);
+
+	return Playlist_Play(playlist_track - 1);
+}
+
+/**
+ * \brief This function runs the playlist. It should be called from the main loop: it feeds the input rings from the card,
+ * 			decodes the current track, prefetches the next one and switches to it when the current one is done.
+ *
+ * \return	FR_OK or the FatFS error code
+ */
+FRESULT Playlist_Process(void)
+{
+	playlist_slot_t*	current;
+	playlist_slot_t*	next;
+	wav_state_e			state;
+	FRESULT				result;
+
+	if(playlist_track == PLAYLIST_NO_TRACK)
+	{
+		//	After the last track the output runs until its last samples are played
+		if(playlist_stopping && (Audio_Ring_Get_Data_Size(&playlist_output) == 0) && Wav_Playback_Is_Drained())
+		{
+			Wav_Playback_Stop();
+			playlist_stopping = false;
+		}
+		return FR_OK;
+	}
+
+	current = &playlist_slots[playlist_current];
+	next = &playlist_slots[playlist_current ^ 1];
+
+	//	The next track is opened as soon as possible, so its beginning is read while the current one is played
+	if((next->track == PLAYLIST_NO_TRACK) && (playlist_track + 1 < playlist_track_count))
+	{
+		result = Playlist_Load(playlist_current ^ 1, playlist_track + 1, true);
+		if(result != FR_OK)
+			return result;
+	}
+
+	result = SD_Stream_Service();
+
+	state = Wav_Parser_Process(&current->parser, &current->input);
+	//	Only the headers of the next track are parsed, its data wait in the input ring
+	if(next->track != PLAYLIST_NO_TRACK)
+		Wav_Parser_Process(&next->parser, &next->input);
+
+	//	WAV_STATE_DONE comes only after the resampler of the current track is flushed, so the next track goes right after
+	//	its last frame
+	if((state == WAV_STATE_DONE) || (state == WAV_STATE_ERROR))
+	{
+		Playlist_Advance();
+		//	The next track fills the playback ring at once
+		if(playlist_track != PLAYLIST_NO_TRACK)
+			Wav_Parser_Process(&next->parser, &next->input);
+		else
+			playlist_stopping = true;
+	}
+
+	return result;
+}
+
+/**
+ * \brief This function returns the current track number, PLAYLIST_NO_TRACK if nothing is played
+ */
+uint8_t Playlist_Get_Track(void)
+{
+	return playlist_track;
+}
+
+/**
+ * \brief This function returns the number of the tracks in the playlist
+ */
+uint8_t Playlist_Get_Track_Count(void)
+{
+	return playlist_track_count;
+}
+
+/**
+ * \brief This function executes the track commands of the remote controller. It should be called for every command taken from the remote command fifo.
+ *
+ * \param command[IN]	-	the received NEC command
+ *
+ * \return	true if it was the track command
+ */
+bool Playlist_Execute_Remote_Command(uint8_t command)
+{
+	switch(command)
+	{
+		case NEC_NEXT:
+			Playlist_Next();
+			return true;
+		case NEC_PREV:
+			Playlist_Previous();
+			return true;
+		default:
+			return false;
+	}
+}
@@ -0,0 +1,82 @@
+#include "pwm_modulator.h"
+#include "dsp.h"
+#include <stdint.h>
+#include <stdbool.h>
+
+#define PWM_MODULATOR_DAC_OFFSET	(uint32_t)0x80008000	//	The middle of the range in both lanes
+#define PWM_MODULATOR_ROUNDING		(int32_t)0x8000			//	Half of the step in the Q16 duty
+
+static uint32_t			pwm_modulator_period;					/*< Timer clocks per carrier period */
+static volatile bool	pwm_modulator_noise_shaping = true;		/*< True if the duty quantization error is shaped */
+static int32_t			pwm_modulator_error_1;					/*< The last quantization error, Q16 steps */
+static int32_t			pwm_modulator_error_2;					/*< The quantization error before the last one */
+
+/**
+ * \brief This function sets the carrier period and clears the error feedback
+ *
+ * \param period[IN]	-	timer clocks per carrier period, the duty goes from 0 to period
+ */
+void PWM_Modulator_Init(uint32_t period)
+{
+	pwm_modulator_period = period;
+	pwm_modulator_error_1 = 0;
+	pwm_modulator_error_2 = 0;
+}
+
+/**
+ * \brief This function turns the noise shaping on or off. It takes effect from the next processed block.
+ */
+void PWM_Modulator_Set_Noise_Shaping(bool enabled)
+{
+	pwm_modulator_noise_shaping = enabled;
+}
+
+/**
+ * \brief This function converts the DAC words to the duty values. The mono sample is mapped to the duty in Q16 steps,
+ * 			between PWM_MODULATOR_GUARD_STEPS and period - PWM_MODULATOR_GUARD_STEPS, so the shaped value (which is at
+ * 			most 2 steps away) is never clipped.
+ *
+ * \param words[IN]		-	the DAC words (DHR12LD layout)
+ * \param duties[OUT]	-	PWM_MODULATOR_OVERSAMPLING duty values per word
+ * \param frames[IN]	-	the number of the words
+ */
+void PWM_Modulator_Process(const uint32_t* words, uint16_t* duties, uint32_t frames)
+{
+	int32_t		scale = (int32_t)(pwm_modulator_period - 2 * PWM_MODULATOR_GUARD_STEPS);
+	int32_t		offset = (int32_t)(PWM_MODULATOR_GUARD_STEPS << 16);
+	int32_t		error_1 = pwm_modulator_error_1;
+	int32_t		error_2 = pwm_modulator_error_2;
+	bool		noise_shaping = pwm_modulator_noise_shaping;
+
+	for(uint32_t i = 0; i < frames; i++)
+	{
+		uint32_t	lanes = Dsp_Ssub16(words[i], PWM_MODULATOR_DAC_OFFSET);
+		//	(L + R) / 2, moved to 0 - 65535
+		int32_t		mono = (int16_t)Dsp_Shadd16(lanes, lanes >> 16) + 32768;
+		int32_t		level = offset + mono * scale;
+
+		if(noise_shaping)
+		{
+			//	Error feedback: duty = level + e[n] - 2 * e[n-1] + e[n-2]
+			for(uint32_t k = 0; k < PWM_MODULATOR_OVERSAMPLING; k++)
+			{
+				int32_t wanted = level - 2 * error_1 + error_2;
+				int32_t duty = (wanted + PWM_MODULATOR_ROUNDING) >> 16;
+
+				error_2 = error_1;
+				error_1 = (duty << 16) - wanted;
+				*duties++ = (uint16_t)duty;
+			}
+		}
+		else
+		{
+			uint16_t duty = (uint16_t)((level + PWM_MODULATOR_ROUNDING) >> 16);
+
+			for(uint32_t k = 0; k < PWM_MODULATOR_OVERSAMPLING; k++)
+				*duties++ = duty;
+		}
+	}
+
+	pwm_modulator_error_1 = error_1;
+	pwm_modulator_error_2 = error_2;
+}
@@ -0,0 +1,138 @@
+#include "stm32f4xx.h"
+#include <stdbool.h>
+#include "pwm_playback.h"
+#include "pwm_modulator.h"
+#include "dac.h"
+#include "GPIO.h"
+#include "RCC.h"
+#include "TIM.h"
+
+#define PWM_PLAYBACK_DAC_OFFSET		(uint32_t)0x80008000	//	The middle of the range in both lanes
+
+static uint16_t					pwm_playback_buffer[2 * PWM_PLAYBACK_HALF_BUFFER_SAMPLES * PWM_PLAYBACK_OVERSAMPLING];	/*< Ping-pong buffer of the CCR1 values */
+static uint32_t					pwm_playback_words[PWM_PLAYBACK_HALF_BUFFER_SAMPLES];	/*< The DAC words given by the refill function */
+static dac_playback_refill_f	pwm_playback_refill;									/*< Function giving the samples */
+static uint32_t					pwm_playback_period;									/*< Timer clocks per carrier period */
+
+
+/**
+ * \brief This function turns the noise shaping on or off. It takes effect from the next refilled block.
+ */
+void PWM_Playback_Set_Noise_Shaping(bool enabled)
+{
+	PWM_Modulator_Set_Noise_Shaping(enabled);
+}
+
+/**
+ * \brief This function fills the given half of the playback buffer using the refill function. The samples it did not give are replaced with silence.
+ */
+static void PWM_Playback_Refill(uint32_t half)
+{
+	uint32_t filled = 0;
+
+	if(pwm_playback_refill != 0)
+		filled = pwm_playback_refill(pwm_playback_words, PWM_PLAYBACK_HALF_BUFFER_SAMPLES);
+	for(; filled < PWM_PLAYBACK_HALF_BUFFER_SAMPLES; filled++)
+		pwm_playback_words[filled] = PWM_PLAYBACK_DAC_OFFSET;
+
+	PWM_Modulator_Process(pwm_playback_words, pwm_playback_buffer + half * PWM_PLAYBACK_HALF_BUFFER_SAMPLES * PWM_PLAYBACK_OVERSAMPLING,
+							PWM_PLAYBACK_HALF_BUFFER_SAMPLES);
+}
+
+/**
+ * \brief This function configures the PWM playback: PWM_PLAYBACK_TIMER generates the carrier on the channel 1 and requests
+ * 			the DMA on every update, the DMA moves the next duty from the ping-pong buffer to CCR1 (preloaded, so it is
+ * 			taken at the start of the next period). The CPU is interrupted only when a half of the buffer has been sent.
+ *
+ * \param sample_rate_hz[IN]	-	the output sample rate
+ * \param refill[IN]			-	the function which gives the samples (DHR12LD words, like for the DAC)
+ *
+ * \return	the real sample rate in Hz, the carrier period is a whole number of the timer clocks
+ */
+uint32_t PWM_Playback_Init(uint32_t sample_rate_hz, dac_playback_refill_f refill)
+{
+	uint32_t carrier_hz = sample_rate_hz * PWM_PLAYBACK_OVERSAMPLING;
+
+	//	Turn on the clock for the timer, the pin and DMA2
+	RCC->APB2ENR |= RCC_APB2ENR_TIM1EN;
+	RCC->AHB1ENR |= RCC_AHB1ENR_GPIOAEN | RCC_AHB1ENR_DMA2EN;
+
+	PWM_Playback_Stop();
+	pwm_playback_refill = refill;
+
+	GPIO_AlternateFunctionPrepare(PWM_PLAYBACK_PORT, PWM_PLAYBACK_PIN, gpio_otyper_push_pull, gpio_speed_fast, gpio_pupd_no_pull);
+	GPIO_AlternateFunctionSet(PWM_PLAYBACK_PORT, PWM_PLAYBACK_PIN, PWM_PLAYBACK_ALTERNATE_FUNCTION);
+
+	//	No prescaler, the period is rounded to the nearest timer clock cycle. The duty starts in the middle (silence)
+	pwm_playback_period = (PWM_PLAYBACK_TIMER_CLOCK_HZ + carrier_hz/2) / carrier_hz;
+	PWM_Modulator_Init(pwm_playback_period);
+	TIM_PWMConfigure(PWM_PLAYBACK_TIMER, 0, pwm_playback_period - 1, pwm_playback_period / 2, TIM_Channel_1);
+	//	The update requests the DMA instead of the interrupts
+	PWM_PLAYBACK_TIMER->DIER = TIM_DIER_UDE;
+
+	//	Configure the stream: memory to peripheral, circular, memory increment, half and complete interrupts, 16 bit transfers
+	PWM_PLAYBACK_DMA_STREAM->CR = 0;
+	while(PWM_PLAYBACK_DMA_STREAM->CR & DMA_SxCR_EN);
+	PWM_PLAYBACK_DMA_STREAM->CR = (PWM_PLAYBACK_DMA_CHANNEL << 25) | DMA_SxCR_PL_1 | DMA_SxCR_MINC | DMA_SxCR_CIRC | DMA_SxCR_DIR_0
+								| DMA_SxCR_MSIZE_0 | DMA_SxCR_PSIZE_0 | DMA_SxCR_HTIE | DMA_SxCR_TCIE | DMA_SxCR_TEIE;
+	PWM_PLAYBACK_DMA_STREAM->PAR = (uint32_t)&PWM_PLAYBACK_TIMER->CCR1;
+	PWM_PLAYBACK_DMA_STREAM->M0AR = (uint32_t)pwm_playback_buffer;
+	PWM_PLAYBACK_DMA_STREAM->NDTR = 2 * PWM_PLAYBACK_HALF_BUFFER_SAMPLES * PWM_PLAYBACK_OVERSAMPLING;
+	//	Direct mode, no FIFO
+	PWM_PLAYBACK_DMA_STREAM->FCR = 0;
+
+	NVIC_SetPriority(PWM_PLAYBACK_DMA_IRQn, 1);
+	NVIC_EnableIRQ(PWM_PLAYBACK_DMA_IRQn);
+
+	return PWM_PLAYBACK_TIMER_CLOCK_HZ / (pwm_playback_period * PWM_PLAYBACK_OVERSAMPLING);
+}
+
+/**
+ * \brief This function fills both halves of the buffer and starts the DMA and the timer
+ */
+void PWM_Playback_Start(void)
+{
+	PWM_Playback_Refill(0);
+	PWM_Playback_Refill(1);
+
+	//	Clear the stream 5 flags and enable the stream
+	PWM_PLAYBACK_DMA->HIFCR = DMA_HIFCR_CTCIF5 | DMA_HIFCR_CHTIF5 | DMA_HIFCR_CTEIF5 | DMA_HIFCR_CDMEIF5 | DMA_HIFCR_CFEIF5;
+	PWM_PLAYBACK_DMA_STREAM->CR |= DMA_SxCR_EN;
+
+	TIM_Clear(PWM_PLAYBACK_TIMER);
+	TIM_Start(PWM_PLAYBACK_TIMER);
+}
+
+/**
+ * \brief This function stops the timer and the DMA. The output holds its last level.
+ */
+void PWM_Playback_Stop(void)
+{
+	TIM_Stop(PWM_PLAYBACK_TIMER);
+	PWM_PLAYBACK_DMA_STREAM->CR &= ~DMA_SxCR_EN;
+}
+
+/**
+ * \brief The DMA interrupt. After the half transfer the DMA reads the second half, so the first one is refilled and after the complete transfer - the second one.
+ */
+void DMA2_Stream5_IRQHandler(void)
+{
+	uint32_t flags = PWM_PLAYBACK_DMA->HISR;
+
+	if(flags & DMA_HISR_HTIF5)
+	{
+		PWM_PLAYBACK_DMA->HIFCR = DMA_HIFCR_CHTIF5;
+		PWM_Playback_Refill(0);
+	}
+	if(flags & DMA_HISR_TCIF5)
+	{
+		PWM_PLAYBACK_DMA->HIFCR = DMA_HIFCR_CTCIF5;
+		PWM_Playback_Refill(1);
+	}
+	if(flags & DMA_HISR_TEIF5)
+	{
+		//	Transfer error disables the stream, start it again
+		PWM_PLAYBACK_DMA->HIFCR = DMA_HIFCR_CTEIF5;
+		PWM_PLAYBACK_DMA_STREAM->CR |= DMA_SxCR_EN;
+	}
+}
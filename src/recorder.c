@@ -0,0 +1,207 @@
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include "recorder.h"
+#include "adc.h"
+#include "audio_ring.h"
+#include "wav.h"
+#include "ff.h"
+
+#define RECORDER_SAMPLE_OFFSET		(uint16_t)0x8000	//	Moves the left aligned unsigned conversion to the signed sample
+
+static FIL					recorder_file;													/*< The recorded file */
+static audio_ring_t			recorder_ring;													/*< The samples waiting for the card */
+static uint8_t				recorder_ring_buffer[RECORDER_RING_SIZE];
+static uint32_t				recorder_buffer[RECORDER_BURST_SIZE / sizeof(uint32_t)];		/*< The burst sent to FatFS, uint32_t keeps it word aligned */
+static uint32_t				recorder_buffer_index;											/*< Bytes already in the burst buffer */
+static int16_t				recorder_samples[ADC_CAPTURE_HALF_BUFFER_SAMPLES];				/*< The converted half of the capture buffer */
+static uint8_t				recorder_channel_count;											/*< Channels of the file */
+static uint32_t				recorder_data_size;												/*< Bytes of the samples written to the file */
+static volatile uint32_t	recorder_dropped_frames;										/*< Frames lost because the ring was full */
+static bool					recorder_recording;												/*< True between the start and the stop */
+
+
+/**
+ * \brief This function puts the little endian value in the header
+ */
+static void Recorder_Put_Value(uint8_t* destination, uint32_t value, uint8_t size)
+{
+	for(uint8_t i = 0; i < size; i++)
+		destination[i] = (uint8_t)(value >> (8 * i));
+}
+
+/**
+ * \brief The capture callback. It converts the right aligned 12 bit conversions to the signed 16 bit samples and puts them in the ring.
+ * 			The half is dropped as a whole if the ring can not take it.
+ */
+static void Recorder_Capture(const uint16_t* samples, uint32_t frames)
+{
+	uint32_t count = frames * recorder_channel_count;
+
+	if(Audio_Ring_Get_Free_Space(&recorder_ring) < count * sizeof(int16_t))
+	{
+		recorder_dropped_frames += frames;
+		return;
+	}
+
+	for(uint32_t i = 0; i < count; i++)
+		recorder_samples[i] = (int16_t)((uint16_t)(samples[i] << 4) ^ RECORDER_SAMPLE_OFFSET);
+
+	Audio_Ring_Put(&recorder_ring, (uint8_t*)recorder_samples, count * sizeof(int16_t));
+}
+
+/**
+ * \brief This function writes the burst buffer to the file
+ *
+ * \return	FR_OK or the FatFS error code, FR_DENIED if the card is full
+ */
+static FRESULT Recorder_Write_Buffer(void)
+{
+	FRESULT	result;
+	UINT	written;
+
+	result = f_write(&recorder_file, recorder_buffer, recorder_buffer_index, &written);
+	if((result == FR_OK) && (written != recorder_buffer_index))
+		result = FR_DENIED;
+	recorder_buffer_index = 0;
+
+	return result;
+}
+
+/**
+ * \brief This function creates the file, puts the WAV header in the first burst and starts the capture.
+ * 			The header holds the real rate of the capture, which may differ from the requested one by the timer rounding.
+ *
+ * \param path[IN]				-	the path of the file, an existing file is overwritten
+ * \param sample_rate_hz[IN]	-	the requested sample rate
+ * \param channels[IN]			-	the ADC channels, in the order of the WAV channels
+ * \param channel_count[IN]		-	the number of the channels, 1 to ADC_CAPTURE_MAX_CHANNELS
+ *
+ * \return	FR_OK or the FatFS error code, FR_INVALID_PARAMETER if the capture can not be configured
+ */
+FRESULT Recorder_Start(const TCHAR* path, uint32_t sample_rate_hz, const uint8_t* channels, uint8_t channel_count)
+{
+	uint8_t*	header = (uint8_t*)recorder_buffer;
+	uint32_t	real_rate;
+	FRESULT		result;
+
+	if(recorder_recording)
+		Recorder_Stop();
+
+	Audio_Ring_Init(&recorder_ring, recorder_ring_buffer, sizeof(recorder_ring_buffer));
+	recorder_channel_count = channel_count;
+	recorder_data_size = 0;
+	recorder_dropped_frames = 0;
+
+	real_rate = ADC_Capture_Init(sample_rate_hz, channels, channel_count, Recorder_Capture);
+	if(real_rate == 0)
+		return FR_INVALID_PARAMETER;
+
+	result = f_open(&recorder_file, path, FA_CREATE_ALWAYS | FA_WRITE);
+	if(result != FR_OK)
+		return result;
+
+	//	The sizes are set to 0, Recorder_Stop() writes them
+	memcpy(header, "RIFF\0\0\0\0WAVEfmt ", 16);
+	Recorder_Put_Value(header + 16, 16, 4);
+	Recorder_Put_Value(header + 20, WAV_FORMAT_PCM, 2);
+	Recorder_Put_Value(header + 22, channel_count, 2);
+	Recorder_Put_Value(header + 24, real_rate, 4);
+	Recorder_Put_Value(header + 28, real_rate * channel_count * sizeof(int16_t), 4);
+	Recorder_Put_Value(header + 32, channel_count * sizeof(int16_t), 2);
+	Recorder_Put_Value(header + 34, 16, 2);
+	memcpy(header + 36, "data\0\0\0\0", 8);
+	recorder_buffer_index = RECORDER_WAV_HEADER_SIZE;
+
+	recorder_recording = true;
+	ADC_Capture_Start();
+
+	return FR_OK;
+}
+
+/**
+ * \brief This function moves the samples from the ring to the file. It should be called from the main loop.
+ * 			At most one burst is written per call and only a full one, so the file grows by whole sectors.
+ *
+ * \return	FR_OK or the FatFS error code, the recording is stopped on the error
+ */
+FRESULT Recorder_Process(void)
+{
+	uint32_t	missing = RECORDER_BURST_SIZE - recorder_buffer_index;
+	FRESULT		result;
+
+	if(!recorder_recording || (Audio_Ring_Get_Data_Size(&recorder_ring) < missing))
+		return FR_OK;
+
+	recorder_data_size += Audio_Ring_Get(&recorder_ring, (uint8_t*)recorder_buffer + recorder_buffer_index, missing);
+	recorder_buffer_index = RECORDER_BURST_SIZE;
+
+	//	Keep what was written, the stop sets the sizes and closes the file
+	result = Recorder_Write_Buffer();
+	if(result != FR_OK)
+		Recorder_Stop();
+
+	return result;
+}
+
+/**
+ * \brief This function stops the capture, writes the rest of the samples and sets the RIFF and data chunk sizes.
+ *
+ * \return	FR_OK or the FatFS error code
+ */
+FRESULT Recorder_Stop(void)
+{
+	uint8_t		size[4];
+	UINT		written;
+	FRESULT		result;
+
+	if(!recorder_recording)
+		return FR_OK;
+
+	ADC_Capture_Stop();
+	recorder_recording = false;
+
+	//	The full bursts first, then the rest
+	do
+	{
+		uint32_t taken = Audio_Ring_Get(&recorder_ring, (uint8_t*)recorder_buffer + recorder_buffer_index, RECORDER_BURST_SIZE - recorder_buffer_index);
+
+		recorder_data_size += taken;
+		recorder_buffer_index += taken;
+		result = Recorder_Write_Buffer();
+	}while((result == FR_OK) && (Audio_Ring_Get_Data_Size(&recorder_ring) != 0));
+
+	//	The sizes of the RIFF chunk (the file without its first 8 bytes) and of the data chunk
+	Recorder_Put_Value(size, RECORDER_WAV_HEADER_SIZE - 8 + recorder_data_size, 4);
+	if(result == FR_OK)
+		result = f_lseek(&recorder_file, 4);
+	if(result == FR_OK)
+		result = f_write(&recorder_file, size, sizeof(size), &written);
+	Recorder_Put_Value(size, recorder_data_size, 4);
+	if(result == FR_OK)
+		result = f_lseek(&recorder_file, 40);
+	if(result == FR_OK)
+		result = f_write(&recorder_file, size, sizeof(size), &written);
+
+	if(result == FR_OK)
+		return f_close(&recorder_file);
+
+	f_close(&recorder_file);
+	return result;
+}
+
+/**
+ * \brief This function checks whether the recording is running
+ */
+bool Recorder_Is_Recording(void)
+{
+	return recorder_recording;
+}
+
+/**
+ * \brief This function returns the number of the frames dropped since the start because the card was too slow. The ADC overruns are counted by ADC_Capture_Get_Overruns().
+ */
+uint32_t Recorder_Get_Dropped_Frames(void)
+{
+	return recorder_dropped_frames;
+}
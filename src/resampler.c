@@ -0,0 +1,210 @@
+#include "resampler.h"
+#include "dsp.h"
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <math.h>
+
+/**
+ * \brief This function computes the windowed sinc filter (Blackman window) and splits it in phases. Every phase is normalized
+ * 			to the unity DC gain, so the interpolation between the phases does not modulate the volume.
+ *
+ * \param cutoff	-	the cutoff frequency relative to the input Nyquist frequency (0, 1]
+ */
+static void Resampler_Compute_Coefficients(resampler_t* resampler, float cutoff)
+{
+	const float pi = 3.14159265f;
+	float		taps[RESAMPLER_TAPS];
+	float		sum;
+
+	for(uint32_t phase = 0; phase <= RESAMPLER_PHASES; phase++)
+	{
+		sum = 0;
+		for(uint32_t tap = 0; tap < RESAMPLER_TAPS; tap++)
+		{
+			//	The distance from the filter center which is between tap TAPS/2 - 1 and TAPS/2
+			float x = (float)tap - (float)(RESAMPLER_TAPS/2 - 1) - (float)phase / RESAMPLER_PHASES;
+			float window = 0.42f + 0.5f * cosf(2 * pi * x / RESAMPLER_TAPS) + 0.08f * cosf(4 * pi * x / RESAMPLER_TAPS);
+			float sinc = (x == 0) ? 1.0f : sinf(pi * cutoff * x) / (pi * cutoff * x);
+
+			taps[tap] = (fabsf(x) >= RESAMPLER_TAPS/2) ? 0 : sinc * window;
+			sum += taps[tap];
+		}
+		for(uint32_t tap = 0; tap < RESAMPLER_TAPS; tap++)
+		{
+			int32_t coefficient = (int32_t)lrintf(taps[tap] / sum * 32768.0f);
+
+			resampler->coefficients[phase][tap] = (coefficient > 32767) ? 32767 : (int16_t)coefficient;
+		}
+	}
+}
+
+/**
+ * \brief This function prepares the resampler for the given conversion
+ *
+ * \param resampler[IN]		-	the resampler to initialize
+ * \param input_rate[IN]	-	the sample rate of the input
+ * \param output_rate[IN]	-	the sample rate of the output
+ * \param channels[IN]		-	number of interleaved channels, 1 or 2
+ *
+ * \return	false if the parameters are not supported
+ */
+bool Resampler_Init(resampler_t* resampler, uint32_t input_rate, uint32_t output_rate, uint8_t channels)
+{
+	if((channels == 0) || (channels > RESAMPLER_MAX_CHANNELS) || (input_rate == 0) || (output_rate == 0))
+		return false;
+
+	resampler->channels = channels;
+	resampler->step = (uint32_t)((((uint64_t)input_rate << 16) + output_rate / 2) / output_rate);
+	//	At downsampling the filter must remove everything above the output Nyquist frequency, 0.9 leaves the room for the transition band
+	Resampler_Compute_Coefficients(resampler, (input_rate > output_rate) ? 0.9f * output_rate / input_rate : 0.9f);
+	Resampler_Reset(resampler);
+
+	return true;
+}
+
+/**
+ * \brief This function clears the history, e.g. before the new file
+ */
+void Resampler_Reset(resampler_t* resampler)
+{
+	memset(resampler->history, 0, sizeof(resampler->history));
+	//	Start with the silence in the filter, so the first samples are not lost
+	resampler->history_size = RESAMPLER_TAPS - 1;
+	resampler->position = 0;
+}
+
+/**
+ * \brief This function returns the number of input frames which can be given to Resampler_Process() now
+ */
+uint32_t Resampler_Get_Input_Space(resampler_t* resampler)
+{
+	return RESAMPLER_HISTORY_SIZE - resampler->history_size;
+}
+
+/**
+ * \brief This function computes one output sample of one channel: two neighbouring phases with SMLAD and the linear interpolation
+ * 			between them with SMLAWB.
+ */
+static int16_t Resampler_Filter(const int16_t* history, const int16_t* phase_0, const int16_t* phase_1, int32_t fraction)
+{
+	int32_t acc_0 = 0;
+	int32_t acc_1 = 0;
+
+	for(uint32_t tap = 0; tap < RESAMPLER_TAPS; tap += 2)
+	{
+		uint32_t samples = Dsp_Read_Q15x2(history + tap);
+
+		acc_0 = Dsp_Smlad(samples, Dsp_Read_Q15x2(phase_0 + tap), acc_0);
+		acc_1 = Dsp_Smlad(samples, Dsp_Read_Q15x2(phase_1 + tap), acc_1);
+	}
+	//	Q30 to Q15
+	acc_0 >>= 15;
+	acc_1 >>= 15;
+	//	acc_0 + (acc_1 - acc_0) * fraction, the fraction is Q15 so the difference is doubled for the >> 16 of SMLAWB
+	return Dsp_Saturate_Q15(Dsp_Smlawb((acc_1 - acc_0) * 2, fraction, acc_0));
+}
+
+/**
+ * \brief This function takes the input frames and gives as many output frames as it can. The input which is not used yet
+ * 			stays in the history, so the caller must not give more frames than Resampler_Get_Input_Space() returns
+ * 			(the rest is dropped).
+ *
+ * \param resampler[IN]		-	the resampler
+ * \param input[IN]			-	interleaved Q15 input frames
+ * \param input_frames[IN]	-	the number of the input frames
+ * \param output[OUT]		-	interleaved Q15 output frames
+ * \param output_frames[IN]	-	the space in the output in frames
+ *
+ * \return	the number of the output frames
+ */
+uint32_t Resampler_Process(resampler_t* resampler, const int16_t* input, uint32_t input_frames, int16_t* output, uint32_t output_frames)
+{
+	uint32_t	produced = 0;
+	uint32_t	channels = resampler->channels;
+	uint32_t	used;
+
+	//	Deinterleave the input to the history
+	if(input_frames > Resampler_Get_Input_Space(resampler))
+		input_frames = Resampler_Get_Input_Space(resampler);
+	for(uint32_t channel = 0; channel < channels; channel++)
+	{
+		int16_t* history = resampler->history[channel] + resampler->history_size;
+
+		for(uint32_t frame = 0; frame < input_frames; frame++)
+			history[frame] = input[frame * channels + channel];
+	}
+	resampler->history_size += input_frames;
+
+	//	Every output needs RESAMPLER_TAPS input frames from its integer position
+	while((produced < output_frames) && ((resampler->position >> 16) + RESAMPLER_TAPS <= resampler->history_size))
+	{
+		uint32_t		index = resampler->position >> 16;
+		uint32_t		phase = (resampler->position >> (16 - RESAMPLER_PHASE_BITS)) & (RESAMPLER_PHASES - 1);
+		int32_t			fraction = (resampler->position << (RESAMPLER_PHASE_BITS - 1)) & 0x7FFF;
+		const int16_t*	phase_0 = resampler->coefficients[phase];
+		const int16_t*	phase_1 = resampler->coefficients[phase + 1];
+
+		for(uint32_t channel = 0; channel < channels; channel++)
+			output[produced * channels + channel] = Resampler_Filter(resampler->history[channel] + index, phase_0, phase_1, fraction);
+
+		produced++;
+		resampler->position += resampler->step;
+	}
+
+	//	Drop the frames which no output needs any more
+	used = resampler->position >> 16;
+	if(used > resampler->history_size)
+		used = resampler->history_size;
+	if(used != 0)
+	{
+		for(uint32_t channel = 0; channel < channels; channel++)
+			memmove(resampler->history[channel], resampler->history[channel] + used, (resampler->history_size - used) * sizeof(int16_t));
+		resampler->history_size -= used;
+		resampler->position -= used << 16;
+	}
+
+	return produced;
+}
+
+#if defined(DWT)
+/**
+ * \brief This function measures the processing time of the stereo conversion with the DWT cycle counter.
+ *
+ * \param input_rate[IN]	-	the sample rate of the input
+ * \param output_rate[IN]	-	the sample rate of the output
+ *
+ * \return	CPU cycles per one output sample (one channel), 0 if the conversion is not supported
+ */
+uint32_t Resampler_Benchmark(uint32_t input_rate, uint32_t output_rate)
+{
+	static resampler_t	resampler;
+	int16_t				input[2 * RESAMPLER_BLOCK_SIZE];
+	int16_t				output[2 * RESAMPLER_BLOCK_SIZE];
+	uint32_t			cycles = 0;
+	uint32_t			produced = 0;
+	uint32_t			start;
+
+	if(!Resampler_Init(&resampler, input_rate, output_rate, 2))
+		return 0;
+	//	Some sound, so the input is not only zeros
+	for(uint32_t i = 0; i < 2 * RESAMPLER_BLOCK_SIZE; i++)
+		input[i] = (int16_t)(i * 1021);
+
+	Dsp_Enable_Cycle_Counter();
+
+	for(uint32_t block = 0; block < 16; block++)
+	{
+		uint32_t frames = Resampler_Get_Input_Space(&resampler);
+
+		//	The space can be a bit more than the input block
+		if(frames > RESAMPLER_BLOCK_SIZE)
+			frames = RESAMPLER_BLOCK_SIZE;
+		start = DWT->CYCCNT;
+		produced += Resampler_Process(&resampler, input, frames, output, RESAMPLER_BLOCK_SIZE);
+		cycles += DWT->CYCCNT - start;
+	}
+
+	return (produced != 0) ? cycles / (2 * produced) : 0;
+}
+#endif
@@ -9,6 +9,7 @@
 #include "integer.h"
 #include "string.h"
 #include "SysTick.h"
+#include "audio_ring.h"
 
 /*** 		LOW LEVEL VARS			***/
 r1_response_u 			r1_response;							/*< Buffer for r1 response from card */
@@ -21,13 +22,15 @@ static uint16_t 		data_block_size;						/*< Buffer for data block size set on th
 /*** 		HIGH LEVEL VARS			***/
 uint16_t				sd_number_of_files_in_dir;				/*< The counter of the files inside the last checked directory	*/
 DIR						sd_current_directory;					/*< The current directory	*/
-FIL						sd_current_file;						/*< The current file */
+sd_stream_t				sd_streams[SD_STREAM_MAX_FILES];		/*< The streamed files, each with its own sector buffer */
+static uint8_t			sd_stream_first;						/*< The stream served first in the next SD_Stream_Service() call */
 FILINFO					sd_current_file_information;			/*< The current checked file informations	*/
 
 TCHAR					sd_files_list[FILE_ARRAY_SIZE][13];		/*< The array where the file names will be held. The second dimension is 13 because of the max short file name size in FatFS */
 BYTE					sd_data_buffer[512];
 BYTE					sd_data_buffer_additional[512];
 uint16_t				read_data_byte_counter = 0;
+static audio_ring_t*	sd_forward_ring;						/*< The ring fed by SD_Audio_Ring_Sink() during f_forward() */
 
 /*************************************************************************************************************************************************/
 												/*									*/
@@ -123,6 +126,180 @@ FRESULT SD_Find_File_Name_Containing(TCHAR* directory_path, TCHAR* name_pattern)
 	return FR_NO_FILE;
 }
 
+/**
+ * \brief This is the streaming function given to f_forward(). It copies the data straight from the FatFS sector window
+ * 			to the audio ring set in \v sd_forward_ring.
+ *
+ * \param data		-	pointer to the data in the sector window. NULL when FatFS only checks the sink state
+ * \param data_size	-	number of bytes to take, 0 when FatFS only checks the sink state
+ *
+ * \return	the number of bytes taken or, in the state check, 1 if the ring can take any data and 0 if it is full
+ */
+static UINT SD_Audio_Ring_Sink(const BYTE* data, UINT data_size)
+{
+	//	State check - tell FatFS to stop when the ring is full
+	if(data_size == 0)
+		return (Audio_Ring_Get_Free_Space(sd_forward_ring) != 0) ? 1 : 0;
+
+	return Audio_Ring_Put(sd_forward_ring, data, data_size);
+}
+
+/**
+ * \brief This function streams the file data to the audio ring. The data goes from the FatFS sector window directly
+ * 			to the ring, so there is no intermediate buffer. It stops when the ring is full or the file ends.
+ *
+ * \param file[IN]				-	the opened file to stream
+ * \param ring[IN]				-	the ring which is to be filled
+ * \param bytes_forwarded[OUT]	-	the number of bytes put in the ring
+ *
+ * \return	FR_OK or the FatFS error code
+ */
+FRESULT SD_Forward_To_Audio_Ring(FIL* file, audio_ring_t* ring, UINT* bytes_forwarded)
+{
+	sd_forward_ring = ring;
+	//	Forward no more than the ring can take now, so the sink never has to refuse the data
+	return f_forward(file, SD_Audio_Ring_Sink, Audio_Ring_Get_Free_Space(ring), bytes_forwarded);
+}
+
+/**
+ * \brief This function opens the file for streaming and binds it with the ring which is to be filled with its data.
+ *
+ * \param stream_number[IN]	-	the number of the stream, less than SD_STREAM_MAX_FILES
+ * \param path[IN]			-	the path to the file
+ * \param ring[IN]			-	the ring fed by SD_Stream_Service()
+ *
+ * \return	FR_OK, FR_INVALID_PARAMETER if the stream number is wrong or the FatFS error code
+ */
+FRESULT SD_Stream_Open(uint8_t stream_number, const TCHAR* path, audio_ring_t* ring)
+{
+	sd_stream_t*	stream;
+	FRESULT			result;
+
+	if(stream_number >= SD_STREAM_MAX_FILES)
+		return FR_INVALID_PARAMETER;
+
+	stream = &sd_streams[stream_number];
+	//	Close the previous file of this stream
+	if(stream->opened)
+		SD_Stream_Close(stream_number);
+
+	result = f_open(&stream->file, path, FA_READ);
+	if(result != FR_OK)
+		return result;
+
+	stream->ring = ring;
+	stream->data_size = 0;
+	stream->data_index = 0;
+	stream->end_of_file = false;
+	stream->opened = true;
+
+	return FR_OK;
+}
+
+/**
+ * \brief This function closes the streamed file. The data already put in the ring stays there.
+ *
+ * \param stream_number[IN]	-	the number of the stream
+ *
+ * \return	FR_OK or the FatFS error code
+ */
+FRESULT SD_Stream_Close(uint8_t stream_number)
+{
+	sd_stream_t* stream;
+
+	if(stream_number >= SD_STREAM_MAX_FILES)
+		return FR_INVALID_PARAMETER;
+
+	stream = &sd_streams[stream_number];
+	if(!stream->opened)
+		return FR_OK;
+
+	stream->opened = false;
+	return f_close(&stream->file);
+}
+
+/**
+ * \brief This function moves the data from the stream buffer to its ring.
+ *
+ * \return true if the whole buffer was put in the ring
+ */
+static bool SD_Stream_Flush_Buffer(sd_stream_t* stream)
+{
+	stream->data_index += Audio_Ring_Put(stream->ring, (uint8_t*)stream->buffer + stream->data_index, stream->data_size - stream->data_index);
+
+	return (stream->data_index == stream->data_size);
+}
+
+/**
+ * \brief This function feeds the rings of all opened streams. It should be called from the main loop.
+ * 			Each stream gets at most one multiple block read per call and the stream served first changes every call,
+ * 			so no stream can starve the others. A new read is done only when the ring can take the whole buffer,
+ * 			so the read data never waits in the stream buffer for longer than one call.
+ *
+ * \return	FR_OK or the FatFS error code of the first failed stream
+ */
+FRESULT SD_Stream_Service(void)
+{
+	FRESULT		result = FR_OK;
+	FRESULT		read_result;
+	uint8_t		stream_number = sd_stream_first;
+
+	for(uint8_t i = 0; i < SD_STREAM_MAX_FILES; i++)
+	{
+		sd_stream_t* stream = &sd_streams[stream_number];
+
+		//	Go to the next stream in the round
+		if(++stream_number == SD_STREAM_MAX_FILES)
+			stream_number = 0;
+
+		if(!stream->opened)
+			continue;
+		//	Put the rest of the last read in the ring first
+		if(!SD_Stream_Flush_Buffer(stream) || stream->end_of_file)
+			continue;
+		//	Read the next sectors only if the ring can take all of them
+		if(Audio_Ring_Get_Free_Space(stream->ring) < SD_STREAM_BUFFER_SIZE)
+			continue;
+
+		stream->data_index = 0;
+		read_result = f_read(&stream->file, stream->buffer, SD_STREAM_BUFFER_SIZE, &stream->data_size);
+		if(read_result != FR_OK)
+		{
+			//	Stop the broken stream, the others are still served
+			stream->data_size = 0;
+			stream->end_of_file = true;
+			if(result == FR_OK)
+				result = read_result;
+			continue;
+		}
+		//	The file ends when less than the whole buffer was read
+		if(stream->data_size < SD_STREAM_BUFFER_SIZE)
+			stream->end_of_file = true;
+
+		SD_Stream_Flush_Buffer(stream);
+	}
+	//	Start the next round from the next stream
+	if(++sd_stream_first == SD_STREAM_MAX_FILES)
+		sd_stream_first = 0;
+
+	return result;
+}
+
+/**
+ * \brief This function checks whether all the data of the streamed file is already in the ring
+ *
+ * \return	true if the file was read to the end and its buffer is empty or if the stream is closed
+ */
+bool SD_Stream_Is_Finished(uint8_t stream_number)
+{
+	sd_stream_t* stream = &sd_streams[stream_number];
+
+	if(!stream->opened)
+		return true;
+
+	return (stream->end_of_file && (stream->data_index == stream->data_size));
+}
+
 /**
  * \brief This function checks whether the given file is already opened
  * \param file - the pointer to the file to check
@@ -213,6 +390,21 @@ uint32_t SD_Send_Command(uint8_t command, uint8_t* argument_array)
 
 			break;
 		}
+		case SD_STOP_TRANSMISSION:
+		{
+			uint8_t response_counter = 0;
+			//	The byte right after CMD12 is the stuff byte, it can still be the data of the stopped block
+			SPI_Receive_Data_Only(CARD_READER_SPI, &r1_response.number, sizeof(r1_response));
+			//	Then the real r1 comes
+			do
+			{
+				SPI_Receive_Data_Only(CARD_READER_SPI, &r1_response.number, sizeof(r1_response));
+				response_counter++;
+			}while((r1_response.bitfields.header_bit != 0) && (response_counter < 8));
+
+			ret_val = r1_response.number;
+			break;
+		}
 		case SD_STOP_TRANSMISSION_BUSY_FLAG:
 		{
 			uint8_t dummy_resp;
@@ -405,4 +597,179 @@ uint16_t SD_Read_Single_Block(DWORD sector_number, BYTE* data_buffer)
 	return 0;
 }
 
+/**
+ * \brief This function waits until the card releases the data line. The card keeps it low while it programs the written block
+ * 			or finishes the stopped transmission.
+ */
+static void SD_Wait_While_Busy(void)
+{
+	uint8_t busy = 0;
+
+	do
+	{
+		SPI_Receive_Data_Only(CARD_READER_SPI, &busy, 1);
+	}while(busy != (uint8_t)0xFF);
+}
+
+/**
+ * \brief This function reads the consecutive data blocks with one CMD18 request and stops the transmission with CMD12.
+ * 			It saves the command and access time of the card for every block but the first one.
+ *
+ * \param sector_number[IN]		-	the logical number of the first sector
+ * \param data_buffer[OUT]		-	the pointer to the buffer for number_of_blocks * 512 bytes
+ * \param number_of_blocks[IN]	-	the number of the blocks to read
+ *
+ * \return 0 if the blocks were read, else the r1 response of CMD12
+ */
+uint16_t SD_Read_Multiple_Blocks(DWORD sector_number, BYTE* data_buffer, UINT number_of_blocks)
+{
+	uint8_t data_token = 0;
+	uint16_t crc;
+	uint8_t command_arguments[4] = {0};
+	uint32_t physical_address = sector_number * 512;
+	command_arguments[3] = (uint8_t)physical_address;
+	command_arguments[2] = (uint8_t)(physical_address >> 8);
+	command_arguments[1] = (uint8_t)(physical_address >> 16);
+	command_arguments[0] = (uint8_t)(physical_address >> 24);
+	//	Send the request of the data blocks
+	uint8_t retval = SD_Send_Command(CMD18, command_arguments);
+	if(retval != 0)
+	{
+		while(1);
+	}
+
+	for(UINT i = 0; i < number_of_blocks; i++)
+	{
+		//	Wait for the data token of the next block
+		do
+		{
+			SPI_Receive_Data_Only(CARD_READER_SPI, &data_token, 1);
+
+			if((data_token & (uint8_t)0xF0) == (uint8_t)0)
+			{
+				error_token.byte = data_token;
+				Log_Uart("Karta zwrocila Error Token w trakcie odczytu wielu blokow\n\r");
+				while(1);
+			}
+		}while(data_token != (uint8_t)0xFE);
+
+		SPI_Receive_Data_Only(CARD_READER_SPI, data_buffer + i*512, 512);
+		//	The CRC must be taken, otherwise it would be read as the next data token
+		SPI_Receive_Data_Only(CARD_READER_SPI, (uint8_t*)&crc, sizeof(crc));
+	}
+	//	Stop the transmission, the busy wait makes sense only after the card has answered
+	retval = SD_Send_Command(CMD12, command_arguments);
+	if(retval != 0)
+		return retval;
+	SD_Wait_While_Busy();
+
+	return 0;
+}
+
+/**
+ * \brief This function sends one data block with the given start token and gets the data response of the card
+ *
+ * \param token[IN]			-	0xFE for CMD24, 0xFC for every block of CMD25
+ * \param data_buffer[IN]	-	the 512 bytes of the block
+ *
+ * \return the data response token masked with SD_DATA_RESPONSE_MASK, SD_DATA_RESPONSE_ACCEPTED if the block was taken
+ */
+static uint8_t SD_Send_Data_Block(uint8_t token, const BYTE* data_buffer)
+{
+	uint8_t gap = 0xFF;
+	uint8_t crc[2] = {0xFF, 0xFF};
+	uint8_t data_response = 0xFF;
+
+	//	One byte gap before the token, then the block and the CRC (not checked in the SPI mode)
+	SPI_Send_Data_Only(CARD_READER_SPI, &gap, 1);
+	SPI_Send_Data_Only(CARD_READER_SPI, &token, 1);
+	SPI_Send_Data_Only(CARD_READER_SPI, (uint8_t*)data_buffer, 512);
+	SPI_Send_Data_Only(CARD_READER_SPI, crc, sizeof(crc));
+	//	The data response comes in the next byte
+	for(uint8_t i = 0; (i < 8) && (data_response == 0xFF); i++)
+		SPI_Receive_Data_Only(CARD_READER_SPI, &data_response, 1);
+
+	return data_response & SD_DATA_RESPONSE_MASK;
+}
+
+/**
+ * \brief This function writes one data block with CMD24 and waits until the card has programmed it
+ *
+ * \param sector_number[IN]	-	the logical number of the sector, given by FatFS library
+ * \param data_buffer[IN]	-	the 512 bytes to write
+ *
+ * \return 0 if the block was written, else the r1 response or the data response of the card
+ */
+uint16_t SD_Write_Single_Block(DWORD sector_number, const BYTE* data_buffer)
+{
+	uint8_t command_arguments[4] = {0};
+	uint32_t physical_address = sector_number * 512;
+	command_arguments[3] = (uint8_t)physical_address;
+	command_arguments[2] = (uint8_t)(physical_address >> 8);
+	command_arguments[1] = (uint8_t)(physical_address >> 16);
+	command_arguments[0] = (uint8_t)(physical_address >> 24);
+	//	Send the request of writing 1 data block
+	uint8_t retval = SD_Send_Command(CMD24, command_arguments);
+	if(retval != 0)
+	{
+		Log_Uart("Karta odrzucila zadanie zapisu pojedynczego bloku\n\r");
+		return retval;
+	}
+
+	retval = SD_Send_Data_Block(0xFE, data_buffer);
+	SD_Wait_While_Busy();
+	if(retval != SD_DATA_RESPONSE_ACCEPTED)
+	{
+		Log_Uart("Karta odrzucila dane w trakcie zapisu pojedynczego bloku\n\r");
+		return retval;
+	}
+
+	return 0;
+}
+
+/**
+ * \brief This function writes the consecutive data blocks with one CMD25 request and ends the transmission with the stop token.
+ * 			The card programs the blocks while the next ones are sent, so a burst of blocks is written much faster than the single blocks.
+ *
+ * \param sector_number[IN]		-	the logical number of the first sector
+ * \param data_buffer[IN]		-	the pointer to number_of_blocks * 512 bytes
+ * \param number_of_blocks[IN]	-	the number of the blocks to write
+ *
+ * \return 0 if all blocks were written, else the r1 response or the data response of the rejected block
+ */
+uint16_t SD_Write_Multiple_Blocks(DWORD sector_number, const BYTE* data_buffer, UINT number_of_blocks)
+{
+	uint8_t stop_token = 0xFD;
+	uint8_t data_response = SD_DATA_RESPONSE_ACCEPTED;
+	uint8_t command_arguments[4] = {0};
+	uint32_t physical_address = sector_number * 512;
+	command_arguments[3] = (uint8_t)physical_address;
+	command_arguments[2] = (uint8_t)(physical_address >> 8);
+	command_arguments[1] = (uint8_t)(physical_address >> 16);
+	command_arguments[0] = (uint8_t)(physical_address >> 24);
+	//	Send the request of writing the data blocks
+	uint8_t retval = SD_Send_Command(CMD25, command_arguments);
+	if(retval != 0)
+	{
+		Log_Uart("Karta odrzucila zadanie zapisu wielu blokow\n\r");
+		return retval;
+	}
+
+	for(UINT i = 0; (i < number_of_blocks) && (data_response == SD_DATA_RESPONSE_ACCEPTED); i++)
+	{
+		data_response = SD_Send_Data_Block(0xFC, data_buffer + i*512);
+		SD_Wait_While_Busy();
+	}
+	//	Stop the transmission, also after the rejected block. The busy state starts one byte after the stop token
+	SPI_Send_Data_Only(CARD_READER_SPI, &stop_token, 1);
+	SPI_Receive_Data_Only(CARD_READER_SPI, &stop_token, 1);
+	SD_Wait_While_Busy();
+	if(data_response != SD_DATA_RESPONSE_ACCEPTED)
+	{
+		Log_Uart("Karta odrzucila dane w trakcie zapisu wielu blokow\n\r");
+		return data_response;
+	}
+
+	return 0;
+}
 
@@ -0,0 +1,301 @@
+#include "soft_timer.h"
+#include "timebase.h"
+#include <stddef.h>
+
+#define SOFT_TIMER_SLOT_MASK				(uint32_t)(SOFT_TIMER_SLOTS - 1)
+#define SOFT_TIMER_WHEEL_MASK				(uint64_t)((1 << SOFT_TIMER_WHEEL_BITS) - 1)
+
+static soft_timer_t*		soft_timer_slots[SOFT_TIMER_LEVELS][SOFT_TIMER_SLOTS];
+static soft_timer_t*		soft_timer_far;								/*< The timers beyond the wheel */
+static uint32_t				soft_timer_used_slots[SOFT_TIMER_LEVELS];	/*< Bit n set - the slot n of the level is not empty */
+static uint64_t				soft_timer_tick;							/*< The tick the wheel is at */
+
+static void Soft_Timer_Expire(void);
+
+/**
+ * \brief	Returns the first tick which starts at or after the given time.
+ */
+static inline uint64_t Soft_Timer_Tick_Of(uint64_t time_us)
+{
+	return (time_us + (1 << SOFT_TIMER_TICK_SHIFT) - 1) >> SOFT_TIMER_TICK_SHIFT;
+}
+
+/**
+ * \brief	Links the timer in the slot of its expiry tick. It has to be called with the interrupts disabled.
+ */
+static void Soft_Timer_Insert(soft_timer_t* timer)
+{
+	uint64_t		difference = timer->expiry_tick ^ soft_timer_tick;
+	soft_timer_t**	head;
+
+	if(difference >> SOFT_TIMER_WHEEL_BITS)
+	{
+		timer->level = SOFT_TIMER_LEVELS;
+		head = &soft_timer_far;
+	}
+	else
+	{
+		//	The highest group of bits in which the expiry differs from the current tick is the level, the expiry bits
+		//	of that group - the slot. The expiry equal to the current tick is in the level 0
+		uint8_t level = difference ? (uint8_t)((31 - __CLZ((uint32_t)difference)) / SOFT_TIMER_LEVEL_BITS) : 0;
+
+		timer->level = level;
+		timer->slot = (uint8_t)((timer->expiry_tick >> (level*SOFT_TIMER_LEVEL_BITS)) & SOFT_TIMER_SLOT_MASK);
+		soft_timer_used_slots[level] |= (uint32_t)1 << timer->slot;
+		head = &soft_timer_slots[level][timer->slot];
+	}
+
+	timer->next = *head;
+	if(timer->next)
+		timer->next->prev_next = &timer->next;
+	timer->prev_next = head;
+	*head = timer;
+}
+
+/**
+ * \brief	Unlinks the running timer. It has to be called with the interrupts disabled.
+ */
+static void Soft_Timer_Remove(soft_timer_t* timer)
+{
+	*timer->prev_next = timer->next;
+	if(timer->next)
+		timer->next->prev_next = timer->prev_next;
+	timer->prev_next = NULL;
+
+	if(timer->level < SOFT_TIMER_LEVELS && soft_timer_slots[timer->level][timer->slot] == NULL)
+		soft_timer_used_slots[timer->level] &= ~((uint32_t)1 << timer->slot);
+}
+
+/**
+ * \brief	Finds the nearest tick at which a timer expires or has to be cascaded.
+ * \param tick[OUT]	-	the found tick
+ * \return	false if no timer runs
+ */
+static bool Soft_Timer_Next_Event(uint64_t* tick)
+{
+	for(uint8_t level = 0; level < SOFT_TIMER_LEVELS; level++)
+	{
+		uint8_t		shift = level*SOFT_TIMER_LEVEL_BITS;
+		uint32_t	used_slots = soft_timer_used_slots[level];
+
+		//	The level 0 timers of the current tick are due, the slots before it belong to the next turn which is
+		//	never used - the timers of the higher levels always lie after the current slot of their level
+		if(level == 0)
+			used_slots &= ~(uint32_t)0 << (soft_timer_tick & SOFT_TIMER_SLOT_MASK);
+
+		//	The lower level events always come before the higher level ones
+		if(used_slots)
+		{
+			uint8_t slot = (uint8_t)__CLZ(__RBIT(used_slots));
+
+			*tick = ((soft_timer_tick >> (shift + SOFT_TIMER_LEVEL_BITS)) << (shift + SOFT_TIMER_LEVEL_BITS)) | ((uint64_t)slot << shift);
+			return true;
+		}
+	}
+
+	//	The far timers are checked at the next wheel turn
+	if(soft_timer_far)
+	{
+		*tick = (soft_timer_tick | SOFT_TIMER_WHEEL_MASK) + 1;
+		return true;
+	}
+
+	return false;
+}
+
+/**
+ * \brief	Moves the timers of the slots which the current tick has just reached to the lower levels.
+ */
+static void Soft_Timer_Cascade(void)
+{
+	soft_timer_t*	timer;
+	soft_timer_t*	next;
+
+	if((soft_timer_tick & SOFT_TIMER_WHEEL_MASK) == 0)
+	{
+		timer = soft_timer_far;
+		soft_timer_far = NULL;
+		for(; timer; timer = next)
+		{
+			next = timer->next;
+			Soft_Timer_Insert(timer);
+		}
+	}
+
+	for(uint8_t level = SOFT_TIMER_LEVELS - 1; level > 0; level--)
+	{
+		uint8_t shift = level*SOFT_TIMER_LEVEL_BITS;
+		uint8_t slot = (uint8_t)((soft_timer_tick >> shift) & SOFT_TIMER_SLOT_MASK);
+
+		//	The slot of this level starts only when all the lower bits are zero
+		if(soft_timer_tick & (((uint64_t)1 << shift) - 1))
+			continue;
+
+		timer = soft_timer_slots[level][slot];
+		soft_timer_slots[level][slot] = NULL;
+		soft_timer_used_slots[level] &= ~((uint32_t)1 << slot);
+		for(; timer; timer = next)
+		{
+			next = timer->next;
+			Soft_Timer_Insert(timer);
+		}
+	}
+}
+
+/**
+ * \brief	Programs the alarm of the timebase for the next event of the wheel. It has to be called with the interrupts disabled.
+ */
+static void Soft_Timer_Program_Alarm(void)
+{
+	uint64_t tick;
+
+	if(Soft_Timer_Next_Event(&tick))
+		Time_Alarm_Set((uint32_t)(tick << SOFT_TIMER_TICK_SHIFT), Soft_Timer_Expire);
+	else
+		Time_Alarm_Cancel();
+}
+
+/**
+ * \brief	The alarm callback. It moves the wheel through all the events up to now and calls the expired timers back.
+ */
+static void Soft_Timer_Expire(void)
+{
+	uint64_t		now_tick = Time_Now_us64() >> SOFT_TIMER_TICK_SHIFT;
+	uint64_t		tick;
+	uint32_t		primask = __get_PRIMASK();
+	soft_timer_t*	timer;
+
+	__disable_irq();
+	while(Soft_Timer_Next_Event(&tick) && tick <= now_tick)
+	{
+		//	No timer is in the skipped ticks
+		soft_timer_tick = tick;
+		Soft_Timer_Cascade();
+
+		//	The callbacks run with the interrupts enabled, one timer at a time, so they may start and stop any timer. The slot
+		//	is taken from soft_timer_tick each time, Soft_Timer_Start moves the idle wheel to the current time
+		while((timer = soft_timer_slots[0][soft_timer_tick & SOFT_TIMER_SLOT_MASK]) != NULL)
+		{
+			Soft_Timer_Remove(timer);
+			if(timer->period_us)
+			{
+				//	The period is added to the exact expiry, so the rounding to the ticks does not accumulate
+				timer->expiry_us += timer->period_us;
+				timer->expiry_tick = Soft_Timer_Tick_Of(timer->expiry_us);
+				if(timer->expiry_tick <= soft_timer_tick)
+					timer->expiry_tick = soft_timer_tick + 1;
+				Soft_Timer_Insert(timer);
+			}
+
+			__set_PRIMASK(primask);
+			timer->callback(timer->context);
+			__disable_irq();
+		}
+	}
+	//	There is no event up to now, so the wheel can jump there
+	if(now_tick > soft_timer_tick)
+		soft_timer_tick = now_tick;
+
+	Soft_Timer_Program_Alarm();
+	__set_PRIMASK(primask);
+}
+
+/**
+ * \brief	Clears the wheel and starts the timebase. The running timers are forgotten.
+ */
+void Soft_Timer_Init(void)
+{
+	uint32_t primask = __get_PRIMASK();
+
+	Time_Init();
+
+	__disable_irq();
+	Time_Alarm_Cancel();
+	for(uint8_t level = 0; level < SOFT_TIMER_LEVELS; level++)
+	{
+		for(uint8_t slot = 0; slot < SOFT_TIMER_SLOTS; slot++)
+			soft_timer_slots[level][slot] = NULL;
+		soft_timer_used_slots[level] = 0;
+	}
+	soft_timer_far = NULL;
+	soft_timer_tick = Time_Now_us64() >> SOFT_TIMER_TICK_SHIFT;
+	__set_PRIMASK(primask);
+}
+
+/**
+ * \brief	Prepares the timer structure. The timer does not run until Soft_Timer_Start.
+ * \param timer[OUT]		-	the timer
+ * \param callback[IN]		-	the function called when the timer expires
+ * \param context[IN]		-	the pointer given to the callback
+ */
+void Soft_Timer_Create(soft_timer_t* timer, soft_timer_callback_f callback, void* context)
+{
+	timer->next = NULL;
+	timer->prev_next = NULL;
+	timer->period_us = 0;
+	timer->callback = callback;
+	timer->context = context;
+}
+
+/**
+ * \brief	Starts the timer. The running timer is restarted with the new times.
+ * \param timer[IN]			-	the timer prepared by Soft_Timer_Create
+ * \param timeout_us[IN]	-	the time to the first expiry, up to SOFT_TIMER_MAX_TIMEOUT_US
+ * \param period_us[IN]		-	the time between the next expiries, 0 for the one shot timer
+ */
+void Soft_Timer_Start(soft_timer_t* timer, uint32_t timeout_us, uint32_t period_us)
+{
+	uint32_t primask = __get_PRIMASK();
+	uint64_t now;
+
+	if(timeout_us > SOFT_TIMER_MAX_TIMEOUT_US)
+		timeout_us = SOFT_TIMER_MAX_TIMEOUT_US;
+	if(period_us > SOFT_TIMER_MAX_TIMEOUT_US)
+		period_us = SOFT_TIMER_MAX_TIMEOUT_US;
+	//	The timer expires at most once per tick
+	if(period_us && period_us < ((uint32_t)1 << SOFT_TIMER_TICK_SHIFT))
+		period_us = (uint32_t)1 << SOFT_TIMER_TICK_SHIFT;
+
+	__disable_irq();
+	if(timer->prev_next)
+		Soft_Timer_Remove(timer);
+
+	now = Time_Now_us64();
+	//	The idle wheel is not moved by the alarm, so it is moved here - the first timer would go to a higher level
+	//	and cascade down without need
+	if(soft_timer_far == NULL && (soft_timer_used_slots[0] | soft_timer_used_slots[1] | soft_timer_used_slots[2] | soft_timer_used_slots[3]) == 0)
+		soft_timer_tick = now >> SOFT_TIMER_TICK_SHIFT;
+
+	timer->expiry_us = now + timeout_us;
+	timer->period_us = period_us;
+	timer->expiry_tick = Soft_Timer_Tick_Of(timer->expiry_us);
+	//	The current tick is being expired or already was
+	if(timer->expiry_tick <= soft_timer_tick)
+		timer->expiry_tick = soft_timer_tick + 1;
+
+	Soft_Timer_Insert(timer);
+	Soft_Timer_Program_Alarm();
+	__set_PRIMASK(primask);
+}
+
+/**
+ * \brief	Stops the timer. Stopping the timer which does not run does nothing.
+ */
+void Soft_Timer_Stop(soft_timer_t* timer)
+{
+	uint32_t primask = __get_PRIMASK();
+
+	__disable_irq();
+	//	The alarm is left as it is, if it was set for this timer it finds nothing to expire and moves on
+	if(timer->prev_next)
+		Soft_Timer_Remove(timer);
+	__set_PRIMASK(primask);
+}
+
+/**
+ * \brief	Checks if the timer runs. The one shot timer does not run any more when its callback is called.
+ */
+bool Soft_Timer_Is_Running(const soft_timer_t* timer)
+{
+	return timer->prev_next != NULL;
+}
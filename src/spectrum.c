@@ -0,0 +1,279 @@
+#include "spectrum.h"
+#include "dsp.h"
+#include "HD44780.h"
+#include <stdint.h>
+#include <stdbool.h>
+#include <math.h>
+
+#define SPECTRUM_DAC_OFFSET			(uint32_t)0x80008000	//	The middle of the range in both lanes
+#define SPECTRUM_LCD_COLUMNS		(uint8_t)16
+#define SPECTRUM_LCD_LINES			(uint8_t)2
+#define SPECTRUM_EMPTY_CHARACTER	' '
+
+/*< The first FFT bin of every band and the end of the last one. Roughly one third of an octave, 172Hz per bin at 44.1kHz */
+static const uint8_t spectrum_band_edges[SPECTRUM_BANDS + 1] =
+{
+	1, 2, 3, 4, 5, 7, 9, 11, 14, 18, 23, 29, 37, 47, 60, 80, 128
+};
+
+static int16_t			spectrum_window[SPECTRUM_FFT_SIZE];					/*< Hann window, Q15 */
+static uint32_t			spectrum_twiddles[3 * SPECTRUM_FFT_SIZE / 4];		/*< e^(-j2pi k/N), the real part in the bottom half word */
+static uint32_t			spectrum_data[SPECTRUM_FFT_SIZE];					/*< Complex Q15 FFT data, the real part in the bottom half word */
+static int16_t			spectrum_samples[SPECTRUM_FFT_SIZE];				/*< The captured samples */
+static volatile uint16_t	spectrum_captured;								/*< Number of the captured samples */
+static volatile uint32_t	spectrum_wait;									/*< Frames to skip before the next capture */
+static volatile bool	spectrum_ready;										/*< True if the capture is waiting for the analysis */
+static uint8_t			spectrum_levels[SPECTRUM_BANDS];					/*< The bar heights, 0 to SPECTRUM_LEVELS */
+static char				spectrum_shown[SPECTRUM_LCD_LINES][SPECTRUM_LCD_COLUMNS];	/*< The characters on the LCD */
+static uint8_t			spectrum_next_column;								/*< The column which is checked for the change first */
+
+/**
+ * \brief This function prepares the window and the twiddle factors and defines the bar characters. The LCD must be configured.
+ */
+void Spectrum_Init(void)
+{
+	const float pi = 3.14159265f;
+	char		rows[8];
+
+	for(uint16_t i = 0; i < SPECTRUM_FFT_SIZE; i++)
+		spectrum_window[i] = (int16_t)(16383.5f - 16383.5f * cosf(2 * pi * i / SPECTRUM_FFT_SIZE));
+	for(uint16_t k = 0; k < 3 * SPECTRUM_FFT_SIZE / 4; k++)
+	{
+		int32_t re = (int32_t)lrintf(32767.0f * cosf(2 * pi * k / SPECTRUM_FFT_SIZE));
+		int32_t im = (int32_t)lrintf(-32767.0f * sinf(2 * pi * k / SPECTRUM_FFT_SIZE));
+
+		spectrum_twiddles[k] = Dsp_Pkhbt(re, im, 16);
+	}
+
+	//	The character n is the bar of n + 1 pixel rows
+	for(uint8_t code = 0; code < LCD_CUSTOM_CHARACTERS; code++)
+	{
+		for(uint8_t row = 0; row < 8; row++)
+			rows[row] = (row >= 7 - code) ? 0x1F : 0x00;
+		LCD_Define_Character(code, rows);
+	}
+	//	Nothing is known about the screen, every character is written again
+	for(uint8_t line = 0; line < SPECTRUM_LCD_LINES; line++)
+	{
+		for(uint8_t column = 0; column < SPECTRUM_LCD_COLUMNS; column++)
+			spectrum_shown[line][column] = 0xFF;
+	}
+	for(uint8_t band = 0; band < SPECTRUM_BANDS; band++)
+		spectrum_levels[band] = 0;
+
+	spectrum_captured = 0;
+	spectrum_wait = 0;
+	spectrum_ready = false;
+}
+
+/**
+ * \brief This function copies the outgoing samples for the analysis. It is called in the DAC refill interrupt, after
+ * 			the volume and the dither, and does nothing while the previous capture waits for Spectrum_Process().
+ *
+ * \param words[IN]		-	the DAC words (DHR12LD layout)
+ * \param frames[IN]	-	the number of the words
+ */
+void Spectrum_Capture(const uint32_t* words, uint32_t frames)
+{
+	uint32_t i;
+
+	if(spectrum_ready)
+		return;
+	if(spectrum_wait >= frames)
+	{
+		spectrum_wait -= frames;
+		return;
+	}
+
+	for(i = spectrum_wait; (i < frames) && (spectrum_captured < SPECTRUM_FFT_SIZE); i++)
+	{
+		uint32_t lanes = Dsp_Ssub16(words[i], SPECTRUM_DAC_OFFSET);
+
+		//	Mid channel (L + R) / 2
+		spectrum_samples[spectrum_captured++] = (int16_t)Dsp_Shadd16(lanes, lanes >> 16);
+	}
+	spectrum_wait = 0;
+	if(spectrum_captured == SPECTRUM_FFT_SIZE)
+		spectrum_ready = true;
+}
+
+/**
+ * \brief This function multiplies the complex Q15 values: SMUSD gives the real part, SMUADX the imaginary one
+ */
+static inline uint32_t Spectrum_Complex_Multiply(uint32_t x, uint32_t w)
+{
+	return Dsp_Pkhbt(Dsp_Smusd(x, w) >> 15, Dsp_Smuadx(x, w) >> 15, 16);
+}
+
+/**
+ * \brief This function computes the radix-4 decimation in frequency FFT of spectrum_data in place. Every butterfly halves
+ * 			its sums twice (SHADD16, SHSUB16, SHASX, SHSAX), so the result is scaled by 1/N. The output is in the digit
+ * 			reversed order.
+ */
+static void Spectrum_Fft(void)
+{
+	uint32_t* data = spectrum_data;
+
+	for(uint32_t size = SPECTRUM_FFT_SIZE; size > 1; size >>= 2)
+	{
+		uint32_t quarter = size >> 2;
+		uint32_t twiddle_step = SPECTRUM_FFT_SIZE / size;
+
+		for(uint32_t j = 0; j < quarter; j++)
+		{
+			uint32_t w1 = spectrum_twiddles[j * twiddle_step];
+			uint32_t w2 = spectrum_twiddles[2 * j * twiddle_step];
+			uint32_t w3 = spectrum_twiddles[3 * j * twiddle_step];
+
+			for(uint32_t i = j; i < SPECTRUM_FFT_SIZE; i += size)
+			{
+				uint32_t t0 = Dsp_Shadd16(data[i], data[i + 2 * quarter]);
+				uint32_t t1 = Dsp_Shsub16(data[i], data[i + 2 * quarter]);
+				uint32_t t2 = Dsp_Shadd16(data[i + quarter], data[i + 3 * quarter]);
+				uint32_t t3 = Dsp_Shsub16(data[i + quarter], data[i + 3 * quarter]);
+
+				data[i] = Dsp_Shadd16(t0, t2);
+				//	(t1 - j * t3) / 2 and (t1 + j * t3) / 2
+				data[i + quarter] = Spectrum_Complex_Multiply(Dsp_Shsax(t1, t3), w1);
+				data[i + 2 * quarter] = Spectrum_Complex_Multiply(Dsp_Shsub16(t0, t2), w2);
+				data[i + 3 * quarter] = Spectrum_Complex_Multiply(Dsp_Shasx(t1, t3), w3);
+			}
+		}
+	}
+}
+
+/**
+ * \brief This function returns the index with the reversed order of the base 4 digits
+ */
+static inline uint32_t Spectrum_Digit_Reverse(uint32_t index)
+{
+	uint32_t reversed = 0;
+
+	for(uint8_t digit = 0; digit < SPECTRUM_FFT_STAGES; digit++)
+	{
+		reversed = (reversed << 2) | (index & 3);
+		index >>= 2;
+	}
+	return reversed;
+}
+
+/**
+ * \brief This function analyses the captured samples and sets the bar levels. The bars fall by one level per refresh.
+ */
+static void Spectrum_Analyse(void)
+{
+	//	Windowed real samples, the window is scaled by 1/2 so the magnitudes can not exceed the Q15 range
+	for(uint32_t i = 0; i < SPECTRUM_FFT_SIZE; i++)
+		spectrum_data[i] = (uint16_t)((spectrum_samples[i] * spectrum_window[i]) >> 16);
+
+	Spectrum_Fft();
+
+	for(uint8_t band = 0; band < SPECTRUM_BANDS; band++)
+	{
+		uint32_t	power = 0;
+		int32_t		level;
+
+		//	The strongest bin of the band, so a single tone is shown at its full level
+		for(uint32_t bin = spectrum_band_edges[band]; bin < spectrum_band_edges[band + 1]; bin++)
+		{
+			uint32_t value = spectrum_data[Spectrum_Digit_Reverse(bin)];
+			uint32_t bin_power = (uint32_t)Dsp_Smuad(value, value);
+
+			if(bin_power > power)
+				power = bin_power;
+		}
+		//	The level is log2 of the power (__builtin_clz gives the position of the highest bit)
+		level = (power != 0) ? (32 - __builtin_clz(power) - SPECTRUM_FLOOR_BITS) : 0;
+		if(level < 0)
+			level = 0;
+		if(level > SPECTRUM_LEVELS)
+			level = SPECTRUM_LEVELS;
+
+		if(level >= spectrum_levels[band])
+			spectrum_levels[band] = (uint8_t)level;
+		else
+			spectrum_levels[band]--;
+	}
+}
+
+/**
+ * \brief This function returns the character of the bar part in the line
+ */
+static char Spectrum_Get_Character(uint8_t level, uint8_t line)
+{
+	//	The line 1 (bottom) shows the levels 1 to 8, the line 0 the levels 9 to 16
+	uint8_t bottom = (line == 0) ? 8 : 0;
+
+	if(level <= bottom)
+		return SPECTRUM_EMPTY_CHARACTER;
+	if(level - bottom >= 8)
+		return 7;
+	return (char)(level - bottom - 1);
+}
+
+/**
+ * \brief This function updates the changed bar characters on the LCD, at most SPECTRUM_LCD_WRITES_PER_CALL of them.
+ * 			The rest is written in the next calls.
+ */
+static void Spectrum_Draw(void)
+{
+	uint8_t writes = 0;
+
+	for(uint8_t checked = 0; (checked < SPECTRUM_LCD_COLUMNS) && (writes < SPECTRUM_LCD_WRITES_PER_CALL); checked++)
+	{
+		uint8_t column = spectrum_next_column;
+
+		for(uint8_t line = 0; line < SPECTRUM_LCD_LINES; line++)
+		{
+			char character = Spectrum_Get_Character(spectrum_levels[column], line);
+
+			if(character == spectrum_shown[line][column])
+				continue;
+			LCD_GoTo(line, column);
+			LCD_WriteData(character);
+			spectrum_shown[line][column] = character;
+			writes++;
+		}
+		if(++spectrum_next_column == SPECTRUM_LCD_COLUMNS)
+			spectrum_next_column = 0;
+	}
+}
+
+/**
+ * \brief This function runs the analyser. It should be called from the main loop: it analyses the ready capture, lets
+ * 			the refill interrupt take the next one and updates the bars.
+ */
+void Spectrum_Process(void)
+{
+	if(spectrum_ready)
+	{
+		Spectrum_Analyse();
+		//	The next capture starts SPECTRUM_CAPTURE_PERIOD frames after the start of this one
+		spectrum_captured = 0;
+		spectrum_wait = SPECTRUM_CAPTURE_PERIOD - SPECTRUM_FFT_SIZE;
+		spectrum_ready = false;
+	}
+	Spectrum_Draw();
+}
+
+#if defined(DWT)
+/**
+ * \brief This function measures the analysis of one capture (window, FFT and bands) with the DWT cycle counter
+ *
+ * \return	CPU cycles, it should not be above SPECTRUM_CYCLE_BUDGET
+ */
+uint32_t Spectrum_Benchmark(void)
+{
+	uint32_t start;
+
+	for(uint32_t i = 0; i < SPECTRUM_FFT_SIZE; i++)
+		spectrum_samples[i] = (int16_t)(i * 2654435761u >> 16);
+
+	Dsp_Enable_Cycle_Counter();
+
+	start = DWT->CYCCNT;
+	Spectrum_Analyse();
+
+	return DWT->CYCCNT - start;
+}
+#endif
@@ -0,0 +1,123 @@
+#include "timebase.h"
+
+static volatile uint32_t	time_overflows;		/*< The upper 32 bits of the time */
+static time_alarm_callback_f	time_alarm_callback;
+
+/**
+ * \brief	Starts the free running microsecond counter. Calls after the first one do nothing.
+ */
+void Time_Init(void)
+{
+	//	The timebase is already running
+	if(TIMEBASE_TIMER->CR1 & TIM_CR1_CEN)
+		return;
+
+	//	Turn on the clock for the timer
+	if(TIMEBASE_TIMER == TIM2)
+		RCC->APB1ENR |= RCC_APB1ENR_TIM2EN;
+	else
+		RCC->APB1ENR |= RCC_APB1ENR_TIM5EN;
+
+	TIMEBASE_TIMER->CR1 = 0;
+	TIMEBASE_TIMER->PSC = TIMEBASE_PRESCALER;
+	//	Count through the whole 32 bit range
+	TIMEBASE_TIMER->ARR = 0xFFFFFFFF;
+	TIMEBASE_TIMER->CNT = 0;
+	//	The channel 1 is the output compare in the frozen mode - it only sets the CC1IF, the pin is not driven
+	TIMEBASE_TIMER->CCMR1 &= ~(TIM_CCMR1_CC1S | TIM_CCMR1_OC1M | TIM_CCMR1_OC1PE);
+	TIMEBASE_TIMER->CCER &= ~TIM_CCER_CC1E;
+	//	Only the counter overflow sets the UIF
+	TIMEBASE_TIMER->CR1 |= TIM_CR1_URS;
+	//	Load the prescaler
+	TIMEBASE_TIMER->EGR = TIM_EGR_UG;
+	TIMEBASE_TIMER->SR = 0;
+	time_overflows = 0;
+
+	TIMEBASE_TIMER->DIER = TIM_DIER_UIE;
+	NVIC_SetPriority(TIMEBASE_TIMER_IRQn, TIMEBASE_IRQ_PRIORITY);
+	NVIC_EnableIRQ(TIMEBASE_TIMER_IRQn);
+
+	TIMEBASE_TIMER->CR1 |= TIM_CR1_CEN;
+}
+
+/**
+ * \brief	Returns the 64 bit time since Time_Init. It is valid also in the interrupts and with the interrupts disabled.
+ */
+uint64_t Time_Now_us64(void)
+{
+	uint32_t primask = __get_PRIMASK();
+	uint32_t high, low;
+
+	__disable_irq();
+	high = time_overflows;
+	low = TIMEBASE_TIMER->CNT;
+	//	The wrap which is not counted yet - the caller blocks the timebase interrupt. The low half tells if the counter
+	//	value was read before or after the wrap
+	if((TIMEBASE_TIMER->SR & TIM_SR_UIF) && low < 0x80000000)
+		high++;
+	__set_PRIMASK(primask);
+
+	return ((uint64_t)high << 32) | low;
+}
+
+/**
+ * \brief	Waits actively for the given time. Unlike TIM_Delay it may be used by many callers and from the interrupts.
+ * \param delay_us[IN]	-	the requested delay, less than 2^31us
+ */
+void Time_Busy_Wait_us(uint32_t delay_us)
+{
+	uint32_t deadline = Time_Deadline_us(delay_us);
+
+	while(!Time_Is_Expired(deadline));
+}
+
+/**
+ * \brief	Arms the one shot alarm. The previous alarm is replaced.
+ * \param at_us[IN]		-	the time of the call, from Time_Now_us. The time which already passed calls back at once
+ * \param callback[IN]	-	the function called from the timebase interrupt
+ */
+void Time_Alarm_Set(uint32_t at_us, time_alarm_callback_f callback)
+{
+	TIMEBASE_TIMER->DIER &= ~TIM_DIER_CC1IE;
+	time_alarm_callback = callback;
+	TIMEBASE_TIMER->CCR1 = at_us;
+	TIMEBASE_TIMER->SR = ~TIM_SR_CC1IF;
+	TIMEBASE_TIMER->DIER |= TIM_DIER_CC1IE;
+
+	//	The counter could have passed the compare value before it was written - the match would come after the wrap
+	if(Time_Is_Expired(at_us))
+		TIMEBASE_TIMER->EGR = TIM_EGR_CC1G;
+}
+
+/**
+ * \brief	Disarms the alarm.
+ */
+void Time_Alarm_Cancel(void)
+{
+	TIMEBASE_TIMER->DIER &= ~TIM_DIER_CC1IE;
+	TIMEBASE_TIMER->SR = ~TIM_SR_CC1IF;
+}
+
+/**
+ * \brief	Counts the wraps of the timebase counter and calls the alarm back.
+ */
+void TIM5_IRQHandler(void)
+{
+	if(TIMEBASE_TIMER->SR & TIM_SR_UIF)
+	{
+		//	The higher priority interrupts may read the time between the two writes
+		__disable_irq();
+		time_overflows++;
+		TIMEBASE_TIMER->SR = ~TIM_SR_UIF;
+		__enable_irq();
+	}
+
+	if((TIMEBASE_TIMER->DIER & TIM_DIER_CC1IE) && (TIMEBASE_TIMER->SR & TIM_SR_CC1IF))
+	{
+		//	One shot - the callback arms the next alarm if it needs one
+		TIMEBASE_TIMER->DIER &= ~TIM_DIER_CC1IE;
+		TIMEBASE_TIMER->SR = ~TIM_SR_CC1IF;
+		if(time_alarm_callback)
+			time_alarm_callback();
+	}
+}
@@ -0,0 +1,162 @@
+#include "volume.h"
+#include "dsp.h"
+#include "NEC_remote_controller.h"
+#include <stdint.h>
+#include <stdbool.h>
+
+#define VOLUME_DAC_OFFSET			(uint32_t)0x80008000	//	The middle of the range in both lanes
+
+/*< Q15 gain of the volume steps, 2dB apart: 32767 * 10^(-(31 - step) / 10) */
+static const int16_t volume_gain_table[VOLUME_STEPS] =
+{
+	0, 33, 41, 52, 65, 82, 104, 130, 164, 207, 260, 328, 413, 519, 654, 823,
+	1036, 1304, 1642, 2067, 2603, 3277, 4125, 5193, 6538, 8231, 10362, 13045, 16422, 20675, 26028, 32767
+};
+
+static uint8_t				volume_step = VOLUME_DEFAULT_STEP;			/*< The chosen volume step */
+static volatile int32_t		volume_target_gain = VOLUME_UNITY_GAIN;		/*< The gain set by the user, reached at the end of the next block */
+static int32_t				volume_current_gain = VOLUME_UNITY_GAIN;	/*< The gain at the end of the last block */
+
+/**
+ * \brief This function sets the volume step. The gain changes smoothly during the next refilled block.
+ *
+ * \param step[IN]	-	the volume step, 0 (mute) to VOLUME_STEPS - 1 (0dB)
+ */
+void Volume_Set_Step(uint8_t step)
+{
+	if(step >= VOLUME_STEPS)
+		step = VOLUME_STEPS - 1;
+
+	volume_step = step;
+	volume_target_gain = volume_gain_table[step];
+}
+
+/**
+ * \brief This function returns the chosen volume step
+ */
+uint8_t Volume_Get_Step(void)
+{
+	return volume_step;
+}
+
+/**
+ * \brief This function increases the volume by one step (2dB)
+ */
+void Volume_Up(void)
+{
+	if(volume_step < VOLUME_STEPS - 1)
+		Volume_Set_Step(volume_step + 1);
+}
+
+/**
+ * \brief This function decreases the volume by one step (2dB)
+ */
+void Volume_Down(void)
+{
+	if(volume_step > 0)
+		Volume_Set_Step(volume_step - 1);
+}
+
+/**
+ * \brief This function executes the volume commands of the remote controller. It should be called for every command taken from the remote command fifo.
+ *
+ * \param command[IN]	-	the received NEC command
+ *
+ * \return	true if it was the volume command
+ */
+bool Volume_Execute_Remote_Command(uint8_t command)
+{
+	switch(command)
+	{
+		case NEC_VOL_PLUS:
+			Volume_Up();
+			return true;
+		case NEC_VOL_MINUS:
+			Volume_Down();
+			return true;
+		default:
+			return false;
+	}
+}
+
+/**
+ * \brief This function scales both channels of the DAC word by the Q15 gain. The lanes are moved to the signed range with SSUB16,
+ * 			multiplied with SMULBB/SMULTB and moved back with SADD16. The gain is below 1, so no product is larger than its
+ * 			sample and nothing has to be saturated; the wrap of SADD16 is only the move back to the unsigned range.
+ */
+static inline uint32_t Volume_Scale(uint32_t word, uint32_t gain)
+{
+	uint32_t	lanes = Dsp_Ssub16(word, VOLUME_DAC_OFFSET);
+	int32_t		left = Dsp_Smulbb(lanes, gain) >> 15;
+	int32_t		right = Dsp_Smultb(lanes, gain) >> 15;
+
+	return Dsp_Sadd16(Dsp_Pkhbt(left, right, 16), VOLUME_DAC_OFFSET);
+}
+
+/**
+ * \brief This function applies the volume to the block of the DAC words. It is called in the DAC refill interrupt.
+ * 			If the volume was changed, the gain goes linearly from the old to the new value over the block. At 0dB
+ * 			the block is not touched at all.
+ *
+ * \param words[IN/OUT]	-	the DAC words (DHR12LD layout)
+ * \param frames[IN]	-	the number of the words
+ */
+void Volume_Process(uint32_t* words, uint32_t frames)
+{
+	int32_t target = volume_target_gain;
+
+	if(frames == 0)
+		return;
+
+	if(target == volume_current_gain)
+	{
+		//	Constant gain
+		if(target == VOLUME_UNITY_GAIN)
+			return;
+		for(uint32_t i = 0; i < frames; i++)
+			words[i] = Volume_Scale(words[i], (uint32_t)target);
+	}
+	else
+	{
+		//	The gain in Q16 fraction of the Q15 value, so the small steps of the long blocks are not lost. The difference can be
+		//	negative, so it is multiplied - the left shift of a negative value is undefined
+		int32_t gain = volume_current_gain * 65536;
+		int32_t step = ((target - volume_current_gain) * 65536) / (int32_t)frames;
+
+		for(uint32_t i = 0; i < frames; i++)
+		{
+			gain += step;
+			words[i] = Volume_Scale(words[i], (uint32_t)(gain >> 16));
+		}
+		volume_current_gain = target;
+	}
+}
+
+#if defined(DWT)
+/**
+ * \brief This function measures the volume processing time with the DWT cycle counter. The ramp is measured, it is the slower case.
+ *
+ * \return	CPU cycles per stereo frame, it should not be above VOLUME_CYCLE_BUDGET
+ */
+uint32_t Volume_Benchmark(void)
+{
+	static uint32_t	words[256];
+	uint8_t			step = volume_step;
+	uint32_t		start;
+	uint32_t		cycles;
+
+	for(uint32_t i = 0; i < 256; i++)
+		words[i] = (i * 256) | ((65535 - i * 256) << 16);
+
+	Dsp_Enable_Cycle_Counter();
+
+	Volume_Set_Step(step / 2);
+	start = DWT->CYCCNT;
+	Volume_Process(words, 256);
+	cycles = DWT->CYCCNT - start;
+	//	Back to the user volume
+	Volume_Set_Step(step);
+
+	return cycles / 256;
+}
+#endif
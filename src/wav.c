@@ -0,0 +1,622 @@
+#include "wav.h"
+#include "audio_ring.h"
+#include "dac.h"
+#include "i2s.h"
+#include "pwm_playback.h"
+#include "resampler.h"
+#include "pcm_convert.h"
+#include "volume.h"
+#include "equalizer.h"
+#include "mixer.h"
+#include "ima_adpcm.h"
+#include "dither.h"
+#include "spectrum.h"
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+
+static uint32_t			wav_playback_rate;					/*< The output rate of the last playback configuration */
+static bool				wav_playback_started;				/*< True if the playback was started after it was last configured */
+static volatile uint8_t	wav_playback_empty_refills;			/*< The refills in a row which found no samples, up to 2 */
+
+//	The data processing buffers. Static - too big for the stack and the parsers are never called from the interrupts
+static uint8_t			wav_work[WAV_WORK_BUFFER_SIZE];				/*< The data taken from the input */
+static int16_t			wav_samples[2 * WAV_WORK_BUFFER_SIZE];		/*< Q15 frames, ADPCM gives 2 samples from every byte */
+static int16_t			wav_resampled[WAV_WORK_BUFFER_SIZE];		/*< Q15 frames from the resampler */
+static uint32_t			wav_words[WAV_WORK_BUFFER_SIZE];			/*< DAC words */
+
+//	KSDATAFORMAT_SUBTYPE_PCM, the only SubFormat of WAV_FORMAT_EXTENSIBLE which is played
+static const uint8_t	wav_subformat_pcm[16] = {0x01, 0x00, 0x00, 0x00, 0x00, 0x00, 0x10, 0x00, 0x80, 0x00, 0x00, 0xAA, 0x00, 0x38, 0x9B, 0x71};
+
+/**
+ * \brief This function reads the little endian half word
+ */
+static uint16_t Wav_Get_16(const uint8_t* data)
+{
+	return (uint16_t)(data[0] | (data[1] << 8));
+}
+
+/**
+ * \brief This function reads the little endian word
+ */
+static uint32_t Wav_Get_32(const uint8_t* data)
+{
+	return (uint32_t)data[0] | ((uint32_t)data[1] << 8) | ((uint32_t)data[2] << 16) | ((uint32_t)data[3] << 24);
+}
+
+/**
+ * \brief This function prepares the parser for the new file. The playback ring is cleared.
+ *
+ * \param parser[IN]	-	the parser to initialize
+ * \param output[IN]	-	the playback ring which is to be filled with the DAC samples
+ */
+void Wav_Parser_Init(wav_parser_t* parser, audio_ring_t* output)
+{
+	memset(parser, 0, sizeof(wav_parser_t));
+	parser->output = output;
+	parser->state = WAV_STATE_RIFF_HEADER;
+	parser->header_size = 12;
+	Audio_Ring_Clear(output);
+}
+
+/**
+ * \brief This function prepares the parser for the file which is to be played right after the current one. The playback
+ * 			ring is not cleared and the running playback is not stopped. The headers are parsed and the decoder is prepared
+ * 			ahead, but the data are not decoded until Wav_Parser_Release() is called, so the input ring can be filled
+ * 			with the beginning of the file while the current one is still played.
+ *
+ * \param parser[IN]	-	the parser to initialize, not the one of the current file
+ * \param output[IN]	-	the playback ring of the current file
+ */
+void Wav_Parser_Queue(wav_parser_t* parser, audio_ring_t* output)
+{
+	memset(parser, 0, sizeof(wav_parser_t));
+	parser->output = output;
+	parser->state = WAV_STATE_RIFF_HEADER;
+	parser->header_size = 12;
+	parser->queued = true;
+	parser->held = true;
+}
+
+/**
+ * \brief This function lets the queued parser decode its data to the playback ring. It should be called when the previous
+ * 			parser returned WAV_STATE_DONE (not WAV_STATE_DATA or WAV_STATE_FLUSH, its resampler still keeps the end of the file)
+ * 			or the previous file is dropped, the samples go right after the ones already in the ring.
+ */
+void Wav_Parser_Release(wav_parser_t* parser)
+{
+	parser->held = false;
+}
+
+/**
+ * \brief This function stops the playback output (WAV_OUTPUT)
+ */
+void Wav_Playback_Stop(void)
+{
+#if WAV_OUTPUT == WAV_OUTPUT_I2S
+	I2S_Playback_Stop();
+#elif WAV_OUTPUT == WAV_OUTPUT_PWM
+	PWM_Playback_Stop();
+#else
+	DAC_Playback_Stop();
+#endif
+	wav_playback_started = false;
+}
+
+/**
+ * \brief This function checks if the output has played all the samples. The refill which finds the playback ring empty
+ * 			runs while the other half of the output buffer is played, which may still hold the last samples. Only after the
+ * 			second empty refill in a row both halves are silence.
+ *
+ * \return	true if the playback ring and the output buffer are empty
+ */
+bool Wav_Playback_Is_Drained(void)
+{
+	return wav_playback_empty_refills >= 2;
+}
+
+/**
+ * \brief This function collects the header bytes from the input. The header can come in any number of parts.
+ *
+ * \return	true if the whole header is in parser->header
+ */
+static bool Wav_Collect_Header(wav_parser_t* parser, audio_ring_t* input)
+{
+	parser->header_index += Audio_Ring_Get(input, parser->header + parser->header_index, parser->header_size - parser->header_index);
+
+	if(parser->header_index < parser->header_size)
+		return false;
+
+	parser->header_index = 0;
+	return true;
+}
+
+/**
+ * \brief This function checks the format and prepares the decoder and the resampler for it
+ *
+ * \return	true if the format is supported
+ */
+static bool Wav_Prepare_Decoder(wav_parser_t* parser)
+{
+	wav_format_t* format = &parser->format;
+
+	if((format->channels != 1) && (format->channels != 2))
+		return false;
+	if(format->sample_rate == 0)
+		return false;
+
+	switch(format->format_tag)
+	{
+		case WAV_FORMAT_PCM:
+		case WAV_FORMAT_EXTENSIBLE:
+		{
+			if((format->bits_per_sample != 8) && (format->bits_per_sample != 16) && (format->bits_per_sample != 24))
+				return false;
+			if(format->block_align != format->channels * (format->bits_per_sample / 8))
+				return false;
+			parser->unit_size = format->block_align;
+			break;
+		}
+		case WAV_FORMAT_IMA_ADPCM:
+		{
+			//	The block is the header and the whole groups of all channels
+			parser->unit_size = IMA_ADPCM_UNIT_SIZE(format->channels);
+			if((format->bits_per_sample != 4) || (format->block_align <= parser->unit_size) || (format->block_align % parser->unit_size))
+				return false;
+			Ima_Adpcm_Init(&parser->adpcm, format->channels);
+			parser->block_remaining = 0;
+			break;
+		}
+		default:
+			return false;
+	}
+
+#if WAV_OUTPUT_SAMPLE_RATE
+	//	The DAC runs at the fixed rate, the other rates are converted
+	parser->resample = (format->sample_rate != WAV_OUTPUT_SAMPLE_RATE);
+	if(parser->resample && !Resampler_Init(&parser->resampler, format->sample_rate, WAV_OUTPUT_SAMPLE_RATE, format->channels))
+		return false;
+#endif
+
+	return true;
+}
+
+/**
+ * \brief This function checks the fmt chunk fields
+ *
+ * \return	true if the format is supported
+ */
+static bool Wav_Set_Format(wav_parser_t* parser)
+{
+	wav_format_t* format = &parser->format;
+
+	format->format_tag = Wav_Get_16(parser->header);
+	format->channels = Wav_Get_16(parser->header + 2);
+	format->sample_rate = Wav_Get_32(parser->header + 4);
+	format->block_align = Wav_Get_16(parser->header + 12);
+	format->bits_per_sample = Wav_Get_16(parser->header + 14);
+
+	//	The extensible format is PCM only with the PCM SubFormat GUID (after cbSize, wValidBitsPerSample and dwChannelMask),
+	//	e.g. the float samples are not
+	if(format->format_tag == WAV_FORMAT_EXTENSIBLE)
+	{
+		if((parser->header_size < WAV_FMT_EXTENSIBLE_SIZE) || memcmp(parser->header + 24, wav_subformat_pcm, sizeof(wav_subformat_pcm)))
+			return false;
+	}
+
+	if(!Wav_Prepare_Decoder(parser))
+		return false;
+	parser->format_found = true;
+
+	return true;
+}
+
+/**
+ * \brief This function configures the playback output (WAV_OUTPUT) for the file before its first samples are decoded. The
+ * 			queued file goes on with the running playback, the output is configured again only if its rate has to change.
+ */
+static void Wav_Configure_Playback(wav_parser_t* parser)
+{
+#if WAV_OUTPUT_SAMPLE_RATE
+	uint32_t rate = WAV_OUTPUT_SAMPLE_RATE;
+#else
+	//	The trigger timer period is set for the sample rate of the file
+	uint32_t rate = parser->format.sample_rate;
+#endif
+
+	Mixer_Set_Source(MIXER_SOURCE_MAIN, parser->output);
+	if(parser->queued && wav_playback_started && (rate == wav_playback_rate))
+	{
+		parser->playing = true;
+	}
+	else
+	{
+		Equalizer_Set_Sample_Rate(rate);
+#if WAV_OUTPUT == WAV_OUTPUT_I2S
+		I2S_Playback_Init(rate, Wav_Playback_Refill);
+#elif WAV_OUTPUT == WAV_OUTPUT_PWM
+		PWM_Playback_Init(rate, Wav_Playback_Refill);
+#else
+		DAC_Playback_Init(rate, true, Wav_Playback_Refill);
+#endif
+		wav_playback_rate = rate;
+		wav_playback_started = false;
+	}
+	parser->configured = true;
+}
+
+/**
+ * \brief This function starts the playback output
+ */
+static void Wav_Start_Playback(wav_parser_t* parser)
+{
+#if WAV_OUTPUT == WAV_OUTPUT_I2S
+	I2S_Playback_Start();
+#elif WAV_OUTPUT == WAV_OUTPUT_PWM
+	PWM_Playback_Start();
+#else
+	DAC_Playback_Start();
+#endif
+	wav_playback_started = true;
+	parser->playing = true;
+}
+
+/**
+ * \brief This function converts one PCM sample to Q15
+ */
+static int16_t Wav_Sample_To_Q15(const uint8_t* sample, uint16_t bits_per_sample)
+{
+	switch(bits_per_sample)
+	{
+		//	8 bit samples are unsigned
+		case 8:
+			return (int16_t)((sample[0] - 128) << 8);
+		//	16 and 24 bit samples are signed, only the upper 16 bits are used
+		case 16:
+			return (int16_t)Wav_Get_16(sample);
+		default:
+			return (int16_t)Wav_Get_16(sample + 1);
+	}
+}
+
+/**
+ * \brief This function returns the number of Q15 frames which Wav_Output_Q15() takes now for sure
+ */
+static uint32_t Wav_Get_Q15_Capacity(wav_parser_t* parser)
+{
+	uint32_t capacity;
+
+	//	The resampler keeps the input it cannot use yet, so it limits the input instead of the output
+	if(parser->resample)
+		return Resampler_Get_Input_Space(&parser->resampler);
+
+	capacity = Audio_Ring_Get_Free_Space(parser->output) / sizeof(uint32_t);
+	return (capacity < WAV_WORK_BUFFER_SIZE) ? capacity : WAV_WORK_BUFFER_SIZE;
+}
+
+/**
+ * \brief This function puts the Q15 frames in the playback ring, through the resampler if it is used. The caller must not give
+ * 			more frames than Wav_Get_Q15_Capacity() returns.
+ *
+ * \return	the number of the frames put in the playback ring
+ */
+static uint32_t Wav_Output_Q15(wav_parser_t* parser, const int16_t* samples, uint32_t frames)
+{
+	uint16_t	channels = parser->format.channels;
+	uint32_t	output_frames = Audio_Ring_Get_Free_Space(parser->output) / sizeof(uint32_t);
+
+	if(parser->resample)
+	{
+		if(output_frames > WAV_WORK_BUFFER_SIZE / channels)
+			output_frames = WAV_WORK_BUFFER_SIZE / channels;
+		output_frames = Resampler_Process(&parser->resampler, samples, frames, wav_resampled, output_frames);
+		samples = wav_resampled;
+	}
+	else
+	{
+		output_frames = frames;
+	}
+	Pcm_Convert_Get_Kernel(16, channels)((const uint8_t*)samples, wav_words, output_frames);
+	Audio_Ring_Put(parser->output, (uint8_t*)wav_words, output_frames * sizeof(uint32_t));
+
+	return output_frames;
+}
+
+/**
+ * \brief This function converts the PCM samples of the data chunk and puts them in the playback ring. It takes only whole frames
+ * 			which fit in the ring, the rest stays in the input.
+ *
+ * \return	true if any frame was converted
+ */
+static bool Wav_Process_Pcm(wav_parser_t* parser, audio_ring_t* input)
+{
+	wav_format_t*	format = &parser->format;
+	uint32_t		bytes_per_sample = format->bits_per_sample / 8;
+	uint32_t		frames = WAV_WORK_BUFFER_SIZE / format->block_align;
+	uint32_t		output_frames;
+	uint32_t		limit;
+
+	//	Only the frames which are in the input and fit in the output
+	limit = Audio_Ring_Get_Data_Size(input) / format->block_align;
+	if(limit < frames)
+		frames = limit;
+	limit = parser->chunk_remaining / format->block_align;
+	if(limit < frames)
+		frames = limit;
+	limit = Wav_Get_Q15_Capacity(parser);
+	if(limit < frames)
+		frames = limit;
+
+	Audio_Ring_Get(input, wav_work, frames * format->block_align);
+	parser->chunk_remaining -= frames * format->block_align;
+
+	if(parser->resample)
+	{
+		for(uint32_t i = 0; i < frames * format->channels; i++)
+			wav_samples[i] = Wav_Sample_To_Q15(wav_work + i * bytes_per_sample, format->bits_per_sample);
+
+		output_frames = Wav_Output_Q15(parser, wav_samples, frames);
+	}
+	else
+	{
+		//	Straight from the file format to the DAC words
+		output_frames = frames;
+		Pcm_Convert_Get_Kernel(format->bits_per_sample, format->channels)(wav_work, wav_words, output_frames);
+		Audio_Ring_Put(parser->output, (uint8_t*)wav_words, output_frames * sizeof(uint32_t));
+	}
+
+	return (frames != 0) || (output_frames != 0);
+}
+
+/**
+ * \brief This function decodes the IMA ADPCM data chunk. The block is decoded unit by unit (the header or one group of every
+ * 			channel), so neither the whole block nor its decoded samples have to be buffered.
+ *
+ * \return	true if anything was decoded
+ */
+static bool Wav_Process_Adpcm(wav_parser_t* parser, audio_ring_t* input)
+{
+	uint32_t	unit_size = parser->unit_size;
+	uint32_t	capacity = Wav_Get_Q15_Capacity(parser);
+	uint32_t	units = WAV_WORK_BUFFER_SIZE / unit_size;
+	uint32_t	limit;
+
+	//	Only the units which are in the input
+	limit = Audio_Ring_Get_Data_Size(input) / unit_size;
+	if(limit < units)
+		units = limit;
+	limit = parser->chunk_remaining / unit_size;
+	if(limit < units)
+		units = limit;
+	if(units == 0)
+		return false;
+
+	if(parser->block_remaining < unit_size)
+	{
+		if(parser->block_remaining != 0)
+		{
+			//	The broken end of the block is dropped
+			Audio_Ring_Get(input, wav_work, parser->block_remaining);
+			parser->chunk_remaining -= parser->block_remaining;
+			parser->block_remaining = 0;
+			return true;
+		}
+
+		//	The new block starts with the header, the last block can be shorter
+		if(capacity == 0)
+			return Wav_Output_Q15(parser, wav_samples, 0) != 0;
+		parser->block_remaining = (parser->chunk_remaining < parser->format.block_align) ? parser->chunk_remaining : parser->format.block_align;
+		Audio_Ring_Get(input, wav_work, unit_size);
+		parser->chunk_remaining -= unit_size;
+		parser->block_remaining -= unit_size;
+
+		Ima_Adpcm_Decode_Header(&parser->adpcm, wav_work, wav_samples);
+		Wav_Output_Q15(parser, wav_samples, 1);
+		return true;
+	}
+
+	//	Only the groups of this block which fit in the output
+	limit = parser->block_remaining / unit_size;
+	if(limit < units)
+		units = limit;
+	limit = capacity / IMA_ADPCM_GROUP_FRAMES;
+	if(limit < units)
+		units = limit;
+	if(units == 0)
+	{
+		//	Only the resampler output can make the space for the next group
+		return Wav_Output_Q15(parser, wav_samples, 0) != 0;
+	}
+
+	Audio_Ring_Get(input, wav_work, units * unit_size);
+	parser->chunk_remaining -= units * unit_size;
+	parser->block_remaining -= units * unit_size;
+
+	Ima_Adpcm_Decode_Groups(&parser->adpcm, wav_work, units, wav_samples);
+	Wav_Output_Q15(parser, wav_samples, units * IMA_ADPCM_GROUP_FRAMES);
+
+	return true;
+}
+
+/**
+ * \brief This function decodes the data chunk with the decoder of the file format
+ *
+ * \return	true if anything was decoded
+ */
+static bool Wav_Process_Data(wav_parser_t* parser, audio_ring_t* input)
+{
+	if(parser->format.format_tag == WAV_FORMAT_IMA_ADPCM)
+		return Wav_Process_Adpcm(parser, input);
+
+	return Wav_Process_Pcm(parser, input);
+}
+
+/**
+ * \brief This function parses the file data waiting in the input ring. It should be called whenever new data comes from the SD card
+ * 			or the playback takes the samples. The playback is started when the playback ring gets half full.
+ *
+ * \param parser[IN]	-	the parser
+ * \param input[IN]		-	the ring with the raw file data, e.g. fed by SD_Stream_Service()
+ *
+ * \return	the parser state
+ */
+wav_state_e Wav_Parser_Process(wav_parser_t* parser, audio_ring_t* input)
+{
+	bool progress = true;
+
+	while(progress)
+	{
+		progress = false;
+
+		switch(parser->state)
+		{
+			case WAV_STATE_RIFF_HEADER:
+			{
+				if(!Wav_Collect_Header(parser, input))
+					break;
+				if(memcmp(parser->header, "RIFF", 4) || memcmp(parser->header + 8, "WAVE", 4))
+				{
+					parser->state = WAV_STATE_ERROR;
+					break;
+				}
+				parser->state = WAV_STATE_CHUNK_HEADER;
+				parser->header_size = 8;
+				progress = true;
+				break;
+			}
+			case WAV_STATE_CHUNK_HEADER:
+			{
+				if(!Wav_Collect_Header(parser, input))
+					break;
+				//	The chunks are word aligned, the odd sized ones have the pad byte
+				parser->chunk_remaining = Wav_Get_32(parser->header + 4);
+				if(!memcmp(parser->header, "fmt ", 4) && (parser->chunk_remaining >= WAV_FMT_SIZE))
+				{
+					parser->chunk_remaining = (parser->chunk_remaining + 1) & ~(uint32_t)1;
+					//	The extension of the extensible format is read too, for its SubFormat
+					parser->header_size = (parser->chunk_remaining >= WAV_FMT_EXTENSIBLE_SIZE) ? WAV_FMT_EXTENSIBLE_SIZE : WAV_FMT_SIZE;
+					parser->chunk_remaining -= parser->header_size;
+					parser->state = WAV_STATE_FMT;
+				}
+				else if(!memcmp(parser->header, "data", 4) && parser->format_found)
+				{
+					parser->state = WAV_STATE_DATA;
+				}
+				else
+				{
+					parser->chunk_remaining = (parser->chunk_remaining + 1) & ~(uint32_t)1;
+					parser->state = WAV_STATE_SKIP;
+				}
+				progress = true;
+				break;
+			}
+			case WAV_STATE_FMT:
+			{
+				if(!Wav_Collect_Header(parser, input))
+					break;
+				if(!Wav_Set_Format(parser))
+				{
+					parser->state = WAV_STATE_ERROR;
+					break;
+				}
+				parser->state = WAV_STATE_SKIP;
+				progress = true;
+				break;
+			}
+			case WAV_STATE_SKIP:
+			{
+				uint8_t		dummy[16];
+				uint32_t	skipped;
+
+				while(parser->chunk_remaining)
+				{
+					skipped = Audio_Ring_Get(input, dummy, (parser->chunk_remaining < sizeof(dummy)) ? parser->chunk_remaining : sizeof(dummy));
+					if(skipped == 0)
+						break;
+					parser->chunk_remaining -= skipped;
+				}
+				if(parser->chunk_remaining)
+					break;
+				parser->state = WAV_STATE_CHUNK_HEADER;
+				parser->header_size = 8;
+				progress = true;
+				break;
+			}
+			case WAV_STATE_DATA:
+			{
+				//	The queued file waits for the end of the previous one
+				if(parser->held)
+					break;
+				if(!parser->configured)
+					Wav_Configure_Playback(parser);
+
+				progress = Wav_Process_Data(parser, input);
+				//	Start the playback when there is enough data for a while
+				if(!parser->playing && (Audio_Ring_Get_Data_Size(parser->output) >= parser->output->buffer_size / 2))
+					Wav_Start_Playback(parser);
+				//	The part of the frame at the end of the chunk is dropped
+				if(parser->chunk_remaining < parser->unit_size)
+				{
+					Audio_Ring_Get(input, parser->header, parser->chunk_remaining);
+					//	The resampler keeps the last frames until the filter is filled behind them
+					parser->flush_frames = RESAMPLER_TAPS / 2;
+					parser->state = parser->resample ? WAV_STATE_FLUSH : WAV_STATE_DONE;
+					//	Short files are played too
+					if(!parser->playing)
+						Wav_Start_Playback(parser);
+				}
+				break;
+			}
+			case WAV_STATE_FLUSH:
+			{
+				uint32_t frames = Resampler_Get_Input_Space(&parser->resampler);
+				uint32_t output_frames;
+
+				//	The silence goes in as the history makes the space, it moves the last frames to the filter center
+				if(frames > parser->flush_frames)
+					frames = parser->flush_frames;
+				memset(wav_samples, 0, frames * parser->format.channels * sizeof(int16_t));
+				output_frames = Wav_Output_Q15(parser, wav_samples, frames);
+				parser->flush_frames -= frames;
+				progress = (frames != 0) || (output_frames != 0);
+				//	Nothing more comes out although the playback ring has the space
+				if((parser->flush_frames == 0) && (output_frames == 0) && (Audio_Ring_Get_Free_Space(parser->output) >= sizeof(uint32_t)))
+					parser->state = WAV_STATE_DONE;
+				break;
+			}
+			default:
+				break;
+		}
+	}
+
+	return parser->state;
+}
+
+/**
+ * \brief This is the refill function for the DAC playback. It takes the samples from the mixer (the playback ring of
+ * 			the parsed file and the aux source), applies the equalizer, the volume and the dither and passes the result
+ * 			to the spectrum analyser.
+ *
+ * \param buffer	-	the half of the DAC buffer
+ * \param samples	-	the number of samples to give
+ *
+ * \return	the number of given samples, less on the ring underrun
+ */
+uint32_t Wav_Playback_Refill(void* buffer, uint32_t samples)
+{
+	samples = Mixer_Get((uint32_t*)buffer, samples);
+	Equalizer_Process((uint32_t*)buffer, samples);
+	Volume_Process((uint32_t*)buffer, samples);
+#if WAV_OUTPUT == WAV_OUTPUT_DAC
+	//	Only the DAC drops the lower 4 bits, the PWM output has its own noise shaping
+	Dither_Process((uint32_t*)buffer, samples);
+#endif
+	Spectrum_Capture((const uint32_t*)buffer, samples);
+
+	if(samples != 0)
+		wav_playback_empty_refills = 0;
+	else if(wav_playback_empty_refills < 2)
+		wav_playback_empty_refills++;
+
+	return samples;
+}